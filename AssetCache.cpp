@@ -0,0 +1,239 @@
+#include "AssetCache.h"
+#include "TextureLoader.h"
+#include "ConsoleCapture.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace {
+    // Hashes a file's bytes (FNV-1a), to find files with identical contents.
+    uint64_t hashBytes(const std::vector<unsigned char>& bytes) {
+        uint64_t hash = 14695981039346656037ull;
+        for (const unsigned char byte : bytes) {
+            hash = (hash ^ byte) * 1099511628211ull;
+        }
+        return hash;
+    }
+}
+
+// AssetCache constructor. Starts the decode threads.
+AssetCache::AssetCache(int decodeThreads) {
+    for (int i = 0; i < std::max(1, decodeThreads); ++i) {
+        workers.emplace_back(&AssetCache::workerLoop, this);
+    }
+}
+
+// AssetCache destructor. Stops the decode threads and frees images that were never uploaded.
+// GPU textures must already have been released with unloadAll().
+AssetCache::~AssetCache() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+        jobs.clear();
+    }
+    queueWake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (auto& result : results) {
+        if (result.image.data != nullptr) UnloadImage(result.image);
+    }
+}
+
+// Requests a texture. A path that is already loaded or loading just gains a reference.
+TextureHandle AssetCache::loadTexture(const std::string& path) {
+    // Created up front, so texture() never returns an empty texture before the first update().
+    if (fallback.id == 0) {
+        fallback = LoadFallbackTexture();
+    }
+    if (const auto it = slotByPath.find(path); it != slotByPath.end()) {
+        Entry& entry = entries[it->second];
+        ++entry.references;
+        return {it->second, entry.generation};
+    }
+
+    uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(entries.size());
+        entries.emplace_back();
+    }
+    Entry& entry = entries[slot];
+    entry.path = path;
+    entry.references = 1;
+    entry.state = LoadState::LOADING;
+    entry.contentHash = 0;
+    slotByPath[path] = slot;
+    ++pending;
+
+    const TextureHandle handle = {slot, entry.generation};
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        jobs.push_back({handle, path});
+    }
+    queueWake.notify_one();
+    return handle;
+}
+
+// Adds a reference to a texture.
+void AssetCache::retain(TextureHandle handle) {
+    if (Entry* entry = find(handle)) {
+        ++entry->references;
+    }
+}
+
+// Drops a reference. The last one frees the slot and, if no other entry shares it, the GPU texture.
+void AssetCache::release(TextureHandle handle) {
+    Entry* entry = find(handle);
+    if (!entry || --entry->references > 0) return;
+
+    if (entry->state == LoadState::READY) {
+        const auto it = texturesByHash.find(entry->contentHash);
+        if (it != texturesByHash.end() && --it->second.users == 0) {
+            UnloadTexture(it->second.texture);
+            texturesByHash.erase(it);
+        }
+    } else if (entry->state == LoadState::LOADING) {
+        // The worker's result will no longer match the slot's generation and is thrown away.
+        --pending;
+    }
+    slotByPath.erase(entry->path);
+    entry->path.clear();
+    ++entry->generation;
+    freeSlots.push_back(handle.slot);
+}
+
+// Returns the texture, or the fallback while it is not ready.
+Texture2D AssetCache::texture(TextureHandle handle) const {
+    const Entry* entry = find(handle);
+    if (!entry || entry->state != LoadState::READY) return fallback;
+    return texturesByHash.at(entry->contentHash).texture;
+}
+
+// Checks if a texture is uploaded and usable.
+bool AssetCache::isReady(TextureHandle handle) const {
+    const Entry* entry = find(handle);
+    return entry && entry->state == LoadState::READY;
+}
+
+// Checks if a texture has finished loading, successfully or not.
+bool AssetCache::isSettled(TextureHandle handle) const {
+    const Entry* entry = find(handle);
+    return !entry || entry->state != LoadState::LOADING;
+}
+
+// Uploads decoded images, at most ASSET_UPLOADS_PER_UPDATE per call.
+void AssetCache::update() {
+    PROFILE_ZONE("AssetCache::update");
+    for (int uploads = 0; uploads < ASSET_UPLOADS_PER_UPDATE;) {
+        DecodeResult result;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (results.empty()) break;
+            result = std::move(results.front());
+            results.pop_front();
+        }
+
+        Entry* entry = find(result.handle);
+        if (!entry || entry->state != LoadState::LOADING) {
+            // Released while it was loading.
+            if (result.image.data != nullptr) UnloadImage(result.image);
+            continue;
+        }
+        if (!texturesByHash.count(result.contentHash) && result.ok) {
+            ++uploads;
+        }
+        finishLoad(*entry, result);
+    }
+}
+
+// Uploads an entry's image, or shares the texture of a file with the same contents.
+void AssetCache::finishLoad(Entry& entry, DecodeResult& result) {
+    --pending;
+    if (!result.ok) {
+        entry.state = LoadState::FAILED;
+        consoleCapture.addLine("ASSETS: Failed to load " + entry.path + ", using fallback");
+        return;
+    }
+
+    // A matching hash is only shared once the bytes match too. A collision moves on to the next
+    // key, so two different files never share a texture.
+    uint64_t key = result.contentHash;
+    for (auto it = texturesByHash.find(key); it != texturesByHash.end() && it->second.bytes != result.bytes;
+         it = texturesByHash.find(key)) {
+        ++key;
+    }
+    GpuTexture& gpu = texturesByHash[key];
+    if (gpu.users == 0) {
+        gpu.texture = LoadTextureFromImage(result.image);
+        gpu.bytes = std::move(result.bytes);
+    }
+    UnloadImage(result.image);
+    ++gpu.users;
+    entry.contentHash = key;
+    entry.state = LoadState::READY;
+    consoleCapture.addLine("ASSETS: Loaded " + entry.path);
+}
+
+// Unloads every texture and forgets every entry. Outstanding handles become stale.
+void AssetCache::unloadAll() {
+    for (auto& [hash, gpu] : texturesByHash) {
+        UnloadTexture(gpu.texture);
+    }
+    texturesByHash.clear();
+    if (fallback.id != 0) {
+        UnloadTexture(fallback);
+        fallback = Texture2D{};
+    }
+
+    for (uint32_t slot = 0; slot < entries.size(); ++slot) {
+        if (entries[slot].references > 0) {
+            entries[slot].references = 0;
+            entries[slot].path.clear();
+            ++entries[slot].generation;
+            freeSlots.push_back(slot);
+        }
+    }
+    slotByPath.clear();
+    pending = 0;
+}
+
+// Returns the entry for a handle, or nullptr if the handle is stale.
+AssetCache::Entry* AssetCache::find(TextureHandle handle) {
+    if (handle.slot >= entries.size()) return nullptr;
+    Entry& entry = entries[handle.slot];
+    return entry.references > 0 && entry.generation == handle.generation ? &entry : nullptr;
+}
+
+const AssetCache::Entry* AssetCache::find(TextureHandle handle) const {
+    return const_cast<AssetCache*>(this)->find(handle);
+}
+
+// Reads, hashes and decodes files off the main thread.
+void AssetCache::workerLoop() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (true) {
+        queueWake.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (stopping) return;
+        DecodeJob job = std::move(jobs.front());
+        jobs.pop_front();
+        lock.unlock();
+
+        DecodeResult result;
+        result.handle = job.handle;
+        std::ifstream file(job.path, std::ios::binary);
+        if (file) {
+            result.bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            result.contentHash = hashBytes(result.bytes);
+            result.image = LoadImageFromMemory(GetFileExtension(job.path.c_str()), result.bytes.data(),
+                                               static_cast<int>(result.bytes.size()));
+            result.ok = result.image.data != nullptr;
+        }
+
+        lock.lock();
+        results.push_back(std::move(result));
+    }
+}
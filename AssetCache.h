@@ -0,0 +1,120 @@
+#ifndef ASSET_CACHE_H
+#define ASSET_CACHE_H
+
+#include "raylib.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Constants for asset loading.
+constexpr int ASSET_DECODE_THREADS = 2;    // The number of threads that read and decode image files.
+constexpr int ASSET_UPLOADS_PER_UPDATE = 4; // The most textures uploaded to the GPU per update(), to avoid hitches.
+
+// The TextureHandle struct identifies a texture in an AssetCache.
+// The generation changes whenever a slot is reused, so stale handles are detected.
+struct TextureHandle {
+    uint32_t slot = UINT32_MAX;  // The texture's slot in the cache.
+    uint32_t generation = 0;     // The slot's generation when the handle was issued.
+
+    bool operator==(const TextureHandle& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const TextureHandle& other) const { return !(*this == other); }
+};
+
+// The AssetCache class loads textures in the background and shares them between users.
+// Files are read and decoded on worker threads; only the GPU upload happens on the main thread,
+// in update(). Until a texture is uploaded (or if it fails to load) the red fallback texture is
+// served in its place. Requests for the same path share one entry, and files with identical
+// contents share one GPU texture. Entries are reference counted and unloaded when released.
+// Except for the workers, everything runs on the main thread.
+class AssetCache {
+public:
+    explicit AssetCache(int decodeThreads = ASSET_DECODE_THREADS);
+    ~AssetCache();
+
+    AssetCache(const AssetCache&) = delete;
+    AssetCache& operator=(const AssetCache&) = delete;
+
+    // Requests a texture and returns a handle with one reference. Returns immediately. The first
+    // request creates the fallback texture, so call it with a window open.
+    TextureHandle loadTexture(const std::string& path);
+    // Adds a reference to a texture.
+    void retain(TextureHandle handle);
+    // Drops a reference, unloading the texture once none are left.
+    void release(TextureHandle handle);
+
+    // Returns the texture, or the fallback texture while it is loading or if it failed.
+    Texture2D texture(TextureHandle handle) const;
+    // Checks if a texture is uploaded and usable.
+    bool isReady(TextureHandle handle) const;
+    // Checks if a texture has finished loading, successfully or not.
+    bool isSettled(TextureHandle handle) const;
+    // Returns the number of textures still loading.
+    size_t pendingCount() const { return pending; }
+
+    // Uploads decoded images to the GPU. Call once per frame, with a window open.
+    void update();
+    // Unloads every texture, including the fallback. Call before closing the window.
+    void unloadAll();
+
+private:
+    // The state of an entry's load.
+    enum class LoadState : uint8_t { LOADING, READY, FAILED };
+
+    // The Entry struct is one requested texture.
+    struct Entry {
+        std::string path;
+        uint32_t generation = 0;
+        int references = 0;         // 0 when the slot is free.
+        LoadState state = LoadState::LOADING;
+        uint64_t contentHash = 0;   // The key of the entry's texture: the hash of the file's bytes, once read.
+    };
+    // The GpuTexture struct is an uploaded texture, shared by entries with the same contents.
+    struct GpuTexture {
+        Texture2D texture{};
+        int users = 0;
+        std::vector<unsigned char> bytes; // The file's contents, to tell a hash collision from a match.
+    };
+    // The DecodeJob struct asks a worker to read and decode a file.
+    struct DecodeJob {
+        TextureHandle handle;
+        std::string path;
+    };
+    // The DecodeResult struct is what a worker hands back to the main thread.
+    struct DecodeResult {
+        TextureHandle handle;
+        uint64_t contentHash = 0;
+        std::vector<unsigned char> bytes; // The file's contents.
+        Image image{};          // Empty if the file failed to load.
+        bool ok = false;
+    };
+
+    // Returns the entry for a handle, or nullptr if the handle is stale.
+    Entry* find(TextureHandle handle);
+    const Entry* find(TextureHandle handle) const;
+    // Reads and decodes files until the cache is destroyed.
+    void workerLoop();
+    // Hands a finished entry its GPU texture.
+    void finishLoad(Entry& entry, DecodeResult& result);
+
+    std::vector<Entry> entries;
+    std::vector<uint32_t> freeSlots;
+    std::unordered_map<std::string, uint32_t> slotByPath;
+    std::unordered_map<uint64_t, GpuTexture> texturesByHash; // Keyed by content hash, or the next free key on a collision.
+    Texture2D fallback{};
+    size_t pending = 0;
+
+    // Shared with the workers, guarded by queueMutex.
+    std::mutex queueMutex;
+    std::condition_variable queueWake;
+    std::deque<DecodeJob> jobs;
+    std::deque<DecodeResult> results;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+#endif // ASSET_CACHE_H
@@ -0,0 +1,518 @@
+#include "ConfigParser.h"
+#include "ConsoleCapture.h"
+#include "GameConfig.h"
+#include "Commands.h"
+#include "FrameArena.h"
+#include "EntityStore.h"
+#include "Player.h"
+#include "SpatialHash.h"
+#include "StateHash.h"
+#include "SaveState.h"
+#include "TimelineArchive.h"
+#include "Input.h"
+#ifndef HEADLESS_BUILD
+#include "raylib.h"
+#include "TextureLoader.h"
+#include "UIRenderer.h"
+#include "Profiler.h"
+#include "SpriteBatch.h"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Microbenchmarks for the hot paths of the game, run by `make bench`.
+// Each benchmark reports the fastest time per call over several samples, the one least disturbed
+// by the rest of the machine, and the upper quartile as a measure of the spread. Results are
+// written as CSV (name,ns_per_op,iterations,ns_p75) and compared against a stored baseline of the
+// same format. A benchmark only counts as a regression if its fastest sample is both past the
+// threshold and slower than the baseline's upper quartile, so the two spreads do not overlap.
+// Times are absolute, so a baseline only means something on the machine and build it was taken
+// with: record one with `make bench-baseline` before a change and compare after it. Baselines
+// are local files and are not committed.
+
+namespace {
+    // The number of timed samples taken per benchmark; the fastest is reported.
+    constexpr int BENCH_SAMPLES = 15;
+    // The minimum duration of one sample, in seconds. Iteration counts are doubled until it is reached.
+    constexpr double BENCH_SAMPLE_SECONDS = 0.02;
+    // How much slower than the baseline a benchmark may get before it counts as a regression, in percent.
+    constexpr double DEFAULT_REGRESSION_PERCENT = 15.0;
+
+    // The BenchResult struct holds the outcome of one benchmark.
+    struct BenchResult {
+        std::string name;
+        double nsPerOp;       // The fastest sample.
+        long long iterations; // Iterations per sample.
+        double nsUpper;       // The upper quartile of the samples.
+    };
+
+    // The BaselineResult struct holds one benchmark of a stored results file.
+    struct BaselineResult {
+        double nsPerOp = 0.0;
+        double nsUpper = 0.0; // Files without the column use nsPerOp.
+    };
+
+    // Keeps the compiler from discarding a value that is otherwise unused.
+    template <typename T>
+    void keep(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // Times a number of calls to fn, in seconds.
+    template <typename Fn>
+    double timeCalls(Fn& fn, long long iterations) {
+        const auto start = std::chrono::steady_clock::now();
+        for (long long i = 0; i < iterations; ++i) {
+            fn();
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Runs a benchmark and returns the fastest time per call and the upper quartile.
+    template <typename Fn>
+    BenchResult runBench(const std::string& name, Fn fn) {
+        // Calibrate the iteration count, which also warms caches and branch predictors.
+        long long iterations = 1;
+        while (timeCalls(fn, iterations) < BENCH_SAMPLE_SECONDS && iterations < (1ll << 40)) {
+            iterations *= 2;
+        }
+
+        std::vector<double> samples;
+        for (int s = 0; s < BENCH_SAMPLES; ++s) {
+            samples.push_back(timeCalls(fn, iterations) * 1e9 / static_cast<double>(iterations));
+        }
+        std::sort(samples.begin(), samples.end());
+
+        const BenchResult result{name, samples.front(), iterations, samples[BENCH_SAMPLES * 3 / 4]};
+        std::cout << "  " << std::left << std::setw(40) << name << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(12) << result.nsPerOp << " ns/op (p75 "
+                  << result.nsUpper << ")" << std::endl;
+        return result;
+    }
+
+    // Loads a results file into a map from benchmark name to result. Returns an empty map if it is missing.
+    std::unordered_map<std::string, BaselineResult> loadResults(const std::string& path) {
+        std::unordered_map<std::string, BaselineResult> results;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#' || line.rfind("name,", 0) == 0) continue;
+            std::stringstream ss(line);
+            std::string name, nsPerOp, iterations, nsUpper;
+            if (std::getline(ss, name, ',') && std::getline(ss, nsPerOp, ',')) {
+                try {
+                    BaselineResult& result = results[name];
+                    result.nsPerOp = std::stod(nsPerOp);
+                    result.nsUpper = std::getline(ss, iterations, ',') && std::getline(ss, nsUpper, ',')
+                                         ? std::stod(nsUpper) : result.nsPerOp;
+                } catch (const std::exception&) {
+                    std::cerr << "BENCH: Ignoring malformed line in " << path << ": " << line << std::endl;
+                }
+            }
+        }
+        return results;
+    }
+
+    // Writes results as CSV. Returns false if the file cannot be written.
+    bool writeResults(const std::string& path, const std::vector<BenchResult>& results) {
+        std::ofstream file(path);
+        if (!file) return false;
+        file << "name,ns_per_op,iterations,ns_p75\n";
+        file << std::fixed << std::setprecision(2);
+        for (const auto& result : results) {
+            file << result.name << ',' << result.nsPerOp << ',' << result.iterations << ',' << result.nsUpper << '\n';
+        }
+        return static_cast<bool>(file);
+    }
+
+    // Compares results against a baseline and prints the change of each benchmark's fastest sample.
+    // Returns the number of benchmarks that got slower than the threshold allows and whose fastest
+    // sample is also slower than the baseline's upper quartile.
+    int compareResults(const std::vector<BenchResult>& results,
+                       const std::unordered_map<std::string, BaselineResult>& baseline, double thresholdPercent) {
+        int regressions = 0;
+        for (const auto& result : results) {
+            const auto it = baseline.find(result.name);
+            std::cout << "  " << std::left << std::setw(40) << result.name << std::right;
+            if (it == baseline.end() || it->second.nsPerOp <= 0.0) {
+                std::cout << "         new" << std::endl;
+                continue;
+            }
+            const double change = (result.nsPerOp / it->second.nsPerOp - 1.0) * 100.0;
+            std::cout << std::showpos << std::setw(11) << std::setprecision(1) << change << '%' << std::noshowpos;
+            if (change > thresholdPercent) {
+                if (result.nsPerOp > it->second.nsUpper) {
+                    std::cout << "  REGRESSION";
+                    ++regressions;
+                } else {
+                    std::cout << "  (within the baseline's spread)";
+                }
+            }
+            std::cout << std::endl;
+        }
+        return regressions;
+    }
+
+    // Benchmarks the broadphase on crowds of growing size at a fixed density, so the time per
+    // entity should stay about flat. Each entity drifts back and forth around its start.
+    void runBroadphaseBenches(std::vector<BenchResult>& results) {
+        constexpr float spacing = 48.0f;   // The average distance between 32 pixel sprites.
+        constexpr float tickDelta = 1.0f / 60.0f;
+        for (const int count : {100, 1000, 10000, 100000}) {
+            const float side = std::sqrt(static_cast<float>(count)) * spacing;
+            EntityStore store(static_cast<size_t>(count));
+            uint32_t seed = 12345;
+            const auto nextRandom = [&seed]() {
+                seed = seed * 1664525u + 1013904223u;
+                return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+            };
+            for (int i = 0; i < count; ++i) {
+                EntityDesc desc;
+                desc.x = nextRandom() * side;
+                desc.y = nextRandom() * side;
+                desc.width = desc.height = 32.0f;
+                const EntityHandle handle = store.create(desc);
+                store.velX[store.indexOf(handle)] = (nextRandom() - 0.5f) * 400.0f;
+                store.velY[store.indexOf(handle)] = (nextRandom() - 0.5f) * 400.0f;
+            }
+
+            SpatialHash grid;
+            std::vector<EntityPair> pairs;
+            long long tick = 0;
+            results.push_back(runBench("SpatialHash/" + std::to_string(count), [&] {
+                if (++tick % 120 == 0) {
+                    for (size_t i = 0; i < store.size(); ++i) {
+                        store.velX[i] = -store.velX[i];
+                        store.velY[i] = -store.velY[i];
+                    }
+                }
+                for (size_t i = 0; i < store.size(); ++i) {
+                    store.posX[i] += store.velX[i] * tickDelta;
+                    store.posY[i] += store.velY[i] * tickDelta;
+                }
+                grid.update(store);
+                pairs.clear();
+                grid.findPairs(pairs);
+            }));
+            std::cout << "    " << std::setprecision(1) << results.back().nsPerOp / count << " ns/entity, "
+                      << pairs.size() << " pairs, " << grid.cellCount() << " cells, "
+                      << grid.rebuildCount() << " rebuilds" << std::endl;
+
+            if (count == 10000) {
+                std::vector<uint32_t> found;
+                results.push_back(runBench("SpatialHash::queryRegion", [&] {
+                    found.clear();
+                    grid.queryRegion({side / 2.0f, side / 2.0f, 1280.0f, 720.0f}, found);
+                    keep(found.size());
+                }));
+            }
+        }
+    }
+
+    // Benchmarks the config and console paths, which need no window.
+    void runLogicBenches(std::vector<BenchResult>& results) {
+        ConfigFile configFile;
+        configFile.open("resources/conf.ini");
+        GameConfig config;
+        config.loadFromConfig(configFile);
+
+        results.push_back(runBench("ConfigFile::open", [] {
+            ConfigFile file;
+            file.open("resources/conf.ini");
+            keep(file.entries().size());
+        }));
+
+        results.push_back(runBench("GameConfig::loadFromConfig", [&configFile] {
+            GameConfig loaded;
+            loaded.loadFromConfig(configFile);
+            keep(loaded);
+        }));
+
+        results.push_back(runBench("ConsoleCapture::addLine", [] {
+            consoleCapture.addLine("BENCH: a console line of typical length");
+        }));
+
+        results.push_back(runBench("ConsoleCapture::addLine/truncated", [] {
+            consoleCapture.addLine("BENCH: a console line that is far too long to fit inside the console window");
+        }));
+
+        results.push_back(runBench("FrameArena::format", [] {
+            keep(frameArena.format("CL: Speed set to %d", 450).size());
+            frameArena.reset();
+        }));
+
+        EntityStore entities;
+        Player player(entities, config.screenWidth / 2.0f, config.screenHeight / 2.0f, config.playerSpeed,
+                      config.friction, config.maxSpeed, Texture2D{});
+        CommandParser commandParser;
+
+        results.push_back(runBench("CommandParser::parseAndExecute", [&] {
+            commandParser.parseAndExecute("profiler on", player);
+            frameArena.reset();
+        }));
+
+        results.push_back(runBench("CommandParser::parseAndExecute/unknown", [&] {
+            commandParser.parseAndExecute("warp 10 20", player);
+            frameArena.reset();
+        }));
+
+        GameConfig cvarConfig = config;
+        cvarConfig.registerCVars(commandParser.cvars());
+        results.push_back(runBench("CommandParser::parseAndExecute/cvar", [&] {
+            commandParser.parseAndExecute("player_friction 8", player);
+            frameArena.reset();
+        }));
+
+        results.push_back(runBench("CommandParser::complete", [&] {
+            const std::string completed = commandParser.complete("player_f");
+        }));
+
+        results.push_back(runBench("CommandParser::execute", [&] {
+            keep(commandParser.execute("profiler on", player));
+        }));
+
+        // A scenario script that runs one command per tick, restarted whenever it finishes.
+        const std::string scriptPath = "bench_script.cfg";
+        {
+            std::ofstream script(scriptPath);
+            for (int i = 0; i < 4096; ++i) {
+                script << "profiler on\nwait 1\n";
+            }
+        }
+        results.push_back(runBench("CommandParser::update/script", [&] {
+            if (!commandParser.scriptRunning()) commandParser.execScript(scriptPath);
+            commandParser.update(player);
+            frameArena.reset();
+        }));
+        std::remove(scriptPath.c_str());
+
+        player.setSpeed(player.baseSpeed(), player.baseMaxSpeed());
+        InputSnapshot input;
+        input.setDown(InputAction::MOVE_RIGHT);
+        input.setDown(InputAction::MOVE_DOWN);
+        const float tickDelta = 1.0f / static_cast<float>(config.tickRate);
+        long long tick = 0;
+        results.push_back(runBench("Player::update", [&] {
+            // Reverse direction every second so the player keeps moving instead of resting on a wall.
+            if (++tick % config.tickRate == 0) {
+                input = InputSnapshot{};
+                input.setDown((tick / config.tickRate) % 2 ? InputAction::MOVE_LEFT : InputAction::MOVE_RIGHT);
+                input.setDown((tick / config.tickRate) % 2 ? InputAction::MOVE_UP : InputAction::MOVE_DOWN);
+            }
+            player.update(tickDelta, config.screenWidth, config.screenHeight, input, false);
+        }));
+        keep(player.position());
+
+        GameState gameState;
+        ConsoleInput consoleInput;
+        RewindBuffer rewindBuffer(static_cast<size_t>(config.rewindMemoryKB) * 1024, config.rewindKeyframeInterval);
+        results.push_back(runBench("hashSimulationState", [&] {
+            entities.posX[0] += 1.0f;
+            keep(hashSimulationState(entities, gameState, consoleInput, rewindBuffer).combined());
+        }));
+        // A save captured after an hour of play, when the rewind history is full.
+        for (int tick = 0; tick < 3600 * config.tickRate; ++tick) {
+            PlayerState state = player.captureState();
+            state.position.x = static_cast<float>(tick % 800);
+            rewindBuffer.record(state);
+        }
+        SaveImage saveImage;
+        results.push_back(runBench("captureSave", [&] {
+            captureSave(saveImage, entities, gameState, consoleInput, rewindBuffer, 0, config.tickRate);
+            keep(saveImage.data().data());
+        }));
+        std::cout << "    " << saveImage.data().size() << " bytes" << std::endl;
+
+        // Archive three hours of play, then seek to random times in it, as scrubbing through a
+        // long session does.
+        const std::string archivePath = "bench_timeline.tla";
+        TimelineWriter timeline;
+        timeline.open(archivePath, entities, 0, config.tickRate);
+        results.push_back(runBench("TimelineWriter::record", [&] {
+            entities.posX[0] += 1.0f;
+            timeline.record(entities);
+        }));
+        const uint64_t archiveTicks = 3ull * 3600 * static_cast<uint64_t>(config.tickRate);
+        while (timeline.tickCount() < archiveTicks) {
+            if (++tick % config.tickRate == 0) {
+                input = InputSnapshot{};
+                input.setDown((tick / config.tickRate) % 2 ? InputAction::MOVE_LEFT : InputAction::MOVE_RIGHT);
+                input.setDown((tick / config.tickRate) % 5 ? InputAction::MOVE_UP : InputAction::MOVE_DOWN);
+            }
+            player.update(tickDelta, config.screenWidth, config.screenHeight, input, false);
+            timeline.record(entities);
+        }
+        timeline.close();
+        std::cout << "    " << timeline.bytesWritten() << " bytes for " << timeline.tickCount() << " ticks" << std::endl;
+        TimelineReader archive;
+        archive.open(archivePath);
+        EntityStore restored;
+        uint64_t seekState = 1;
+        results.push_back(runBench("TimelineReader::seek/3h", [&] {
+            seekState = seekState * 6364136223846793005ull + 1442695040888963407ull;
+            keep(archive.seek((seekState >> 32) % archive.tickCount(), restored));
+        }));
+        std::remove(archivePath.c_str());
+        const std::vector<unsigned char> block(64 * 1024, 0x5a);
+        results.push_back(runBench("hashBytes/64KB", [&block] {
+            keep(hashBytes(block.data(), block.size()));
+        }));
+
+        runBroadphaseBenches(results);
+    }
+
+#ifndef HEADLESS_BUILD
+    // Benchmarks the render helpers into an offscreen render texture behind a hidden window.
+    // This measures the CPU cost of building and submitting draw batches, not GPU time.
+    void runRenderBenches(std::vector<BenchResult>& results) {
+        ConfigFile configFile;
+        configFile.open("resources/conf.ini");
+        GameConfig config;
+        config.loadFromConfig(configFile);
+
+        SetTraceLogLevel(LOG_WARNING);
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+        InitWindow(config.screenWidth, config.screenHeight, "bench");
+        if (!IsWindowReady()) {
+            std::cerr << "BENCH: Could not create a window, skipping render benchmarks" << std::endl;
+            return;
+        }
+
+        const RenderTexture2D target = LoadRenderTexture(config.screenWidth, config.screenHeight);
+        const Texture2D playerTexture = LoadPlayerTexture(config.spritePath);
+        EntityStore entities;
+        const Player player(entities, config.screenWidth / 2.0f, config.screenHeight / 2.0f, config.playerSpeed,
+                            config.friction, config.maxSpeed, playerTexture);
+        ConsoleInput consoleInput;
+        consoleInput.text = "speed 2";
+        consoleInput.cursorPosition = static_cast<int>(consoleInput.text.size());
+        consoleInput.active = true;
+        for (int i = 0; i < 15; ++i) {
+            consoleCapture.addLine("BENCH: console line " + std::to_string(i));
+        }
+
+        // Draws one frame's worth of a helper into the render texture.
+        const auto offscreen = [&target](auto draw) {
+            return [&target, draw] {
+                BeginTextureMode(target);
+                draw();
+                EndTextureMode();
+            };
+        };
+
+        results.push_back(runBench("render/DrawTitleScreen", offscreen([&config] {
+            DrawTitleScreen(config.screenWidth, config.screenHeight);
+        })));
+        results.push_back(runBench("render/DrawPauseScreen", offscreen([&config] {
+            DrawPauseScreen(config.screenWidth, config.screenHeight);
+        })));
+        results.push_back(runBench("render/DrawConsole", offscreen([&config, &consoleInput] {
+            DrawConsole(config.showFPS, config.consoleWidth, config.consoleHeight, config.consoleFontSize, consoleInput);
+        })));
+        results.push_back(runBench("render/DrawConsole/changed", offscreen([&config, &consoleInput] {
+            consoleCapture.addLine("BENCH: a new console line");
+            DrawConsole(config.showFPS, config.consoleWidth, config.consoleHeight, config.consoleFontSize, consoleInput);
+        })));
+        results.push_back(runBench("render/DrawProfilerOverlay", offscreen([&config] {
+            DrawProfilerOverlay(config.screenWidth);
+        })));
+        SpriteBatch spriteBatch;
+        spriteBatch.atlas().add(playerTexture);
+        results.push_back(runBench("render/Player::draw", offscreen([&player, &spriteBatch] {
+            spriteBatch.begin();
+            player.draw(spriteBatch, 0.5f);
+            spriteBatch.end();
+        })));
+        
+        // Faded sprites spread over the screen, like timeline ghosts.
+        for (const int count : {1000, 10000, 100000}) {
+            std::vector<Vector2> positions;
+            for (int i = 0; i < count; ++i) {
+                positions.push_back({static_cast<float>((i * 37) % config.screenWidth),
+                                     static_cast<float>((i * 91) % config.screenHeight)});
+            }
+            results.push_back(runBench("render/SpriteBatch/" + std::to_string(count), 
+                                       offscreen([&positions, &spriteBatch, &playerTexture] {
+                spriteBatch.begin();
+                for (const Vector2& position : positions) {
+                    spriteBatch.draw(playerTexture, position, Fade(WHITE, 0.5f), SPRITE_LAYER_GHOSTS);
+                }
+                spriteBatch.end();
+            })));
+            std::cout << "    " << spriteBatch.drawCalls() << " draw calls" << std::endl;
+        }
+        spriteBatch.atlas().unload();
+
+        UnloadUIResources();
+        UnloadTexture(playerTexture);
+        UnloadRenderTexture(target);
+        CloseWindow();
+    }
+#endif // HEADLESS_BUILD
+}
+
+int main(int argc, char* argv[]) {
+    std::string outPath = "bench_results.csv";
+    std::string baselinePath;
+    double thresholdPercent = DEFAULT_REGRESSION_PERCENT;
+    bool failOnRegression = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--out" && hasValue) {
+            outPath = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            baselinePath = argv[++i];
+        } else if (arg == "--threshold" && hasValue) {
+            thresholdPercent = std::atof(argv[++i]);
+        } else if (arg == "--fail-on-regression") {
+            failOnRegression = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--out results.csv] [--baseline baseline.csv] [--threshold percent]"
+                      << " [--fail-on-regression]" << std::endl;
+            return 2;
+        }
+    }
+
+    std::cout << "Running benchmarks (fastest of " << BENCH_SAMPLES << " samples):" << std::endl;
+    std::vector<BenchResult> results;
+    runLogicBenches(results);
+#ifndef HEADLESS_BUILD
+    runRenderBenches(results);
+#endif
+
+    if (!writeResults(outPath, results)) {
+        std::cerr << "BENCH: Could not write " << outPath << std::endl;
+        return 2;
+    }
+    std::cout << "Wrote " << results.size() << " results to " << outPath << std::endl;
+
+    if (baselinePath.empty()) return 0;
+    const auto baseline = loadResults(baselinePath);
+    if (baseline.empty()) {
+        std::cout << "No baseline in " << baselinePath << ", nothing to compare" << std::endl;
+        return 0;
+    }
+
+    std::cout << "Change against " << baselinePath << " (threshold +" << thresholdPercent << "%):" << std::endl;
+    const int regressions = compareResults(results, baseline, thresholdPercent);
+    // Runs of the same build can differ by more than any useful threshold from one process to the
+    // next, so regressions are only reported unless the caller asks for them to fail the run.
+    if (regressions > 0) {
+        std::cout << regressions << " benchmark(s) regressed" << std::endl;
+        return failOnRegression ? 1 : 0;
+    }
+    std::cout << "No regressions" << std::endl;
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include "CVarRegistry.h"
+#include "ConfigParser.h"
+#include "ConsoleCapture.h"
+
+// CVar implementation
+std::string CVar::value() const {
+    switch (type) {
+        case CVarType::INT: return std::to_string(*intValue);
+        case CVarType::FLOAT: return formatConfigNumber(*floatValue);
+        case CVarType::BOOL: return *boolValue ? "true" : "false";
+        case CVarType::STRING: return "\"" + *stringValue + "\"";
+    }
+    return {};
+}
+
+// Matches value(), without the heap.
+std::string_view CVar::value(FrameArena& arena) const {
+    switch (type) {
+        case CVarType::INT: return arena.format("%d", *intValue);
+        case CVarType::FLOAT: return arena.format("%g", static_cast<double>(*floatValue));
+        case CVarType::BOOL: return *boolValue ? "true" : "false";
+        case CVarType::STRING: return arena.format("\"%s\"", stringValue->c_str());
+    }
+    return {};
+}
+
+// CVarRegistry implementation
+bool CVarRegistry::add(CVar var) {
+    const int index = static_cast<int>(entries.size());
+    if (!names.insert(var.name, index)) {
+        consoleCapture.addLine("CVAR: Cannot register \"" + var.name + "\"");
+        return false;
+    }
+    entries.push_back({std::move(var), {}});
+    return true;
+}
+
+bool CVarRegistry::addInt(std::string_view name, int& value, int minValue, int maxValue, bool readOnly) {
+    CVar var;
+    var.name = name;
+    var.type = CVarType::INT;
+    var.intValue = &value;
+    var.minValue = minValue;
+    var.maxValue = maxValue;
+    var.readOnly = readOnly;
+    return add(std::move(var));
+}
+
+bool CVarRegistry::addFloat(std::string_view name, float& value, float minValue, float maxValue, bool readOnly) {
+    CVar var;
+    var.name = name;
+    var.type = CVarType::FLOAT;
+    var.floatValue = &value;
+    var.minValue = minValue;
+    var.maxValue = maxValue;
+    var.readOnly = readOnly;
+    return add(std::move(var));
+}
+
+bool CVarRegistry::addBool(std::string_view name, bool& value, bool readOnly) {
+    CVar var;
+    var.name = name;
+    var.type = CVarType::BOOL;
+    var.boolValue = &value;
+    var.readOnly = readOnly;
+    return add(std::move(var));
+}
+
+bool CVarRegistry::addString(std::string_view name, std::string& value, bool readOnly) {
+    CVar var;
+    var.name = name;
+    var.type = CVarType::STRING;
+    var.stringValue = &value;
+    var.readOnly = readOnly;
+    return add(std::move(var));
+}
+
+bool CVarRegistry::onChange(std::string_view name, ChangeCallback callback) {
+    const int index = names.find(name);
+    if (index < 0) return false;
+    entries[index].callbacks.push_back(std::move(callback));
+    return true;
+}
+
+bool CVarRegistry::markSimulation(std::string_view name) {
+    const int index = names.find(name);
+    if (index < 0) return false;
+    entries[index].var.simulation = true;
+    return true;
+}
+
+const CVar* CVarRegistry::find(std::string_view name) const {
+    const int index = names.find(name);
+    return index >= 0 ? &entries[index].var : nullptr;
+}
+
+// Converts the text to the variable's type and checks its range before storing anything.
+bool CVarRegistry::set(std::string_view name, std::string_view value) {
+    const int index = names.find(name);
+    if (index < 0) {
+        consoleCapture.addLine("CVAR: Unknown variable " + std::string(name));
+        return false;
+    }
+    CVar& var = entries[index].var;
+    if (var.readOnly) {
+        consoleCapture.addLine("CVAR: " + var.name + " is read-only");
+        return false;
+    }
+    if (var.simulation && simulationHeld) {
+        consoleCapture.addLine("CVAR: " + var.name + " is held while recording or replaying");
+        return false;
+    }
+
+    const auto range = [&var] {
+        return "between " + formatConfigNumber(var.minValue) + " and " + formatConfigNumber(var.maxValue);
+    };
+    switch (var.type) {
+        case CVarType::INT: {
+            int parsed = 0;
+            if (!parseConfigInt(value, parsed) || parsed < var.minValue || parsed > var.maxValue) {
+                consoleCapture.addLine("CVAR: " + var.name + " must be a whole number " + range());
+                return false;
+            }
+            *var.intValue = parsed;
+            break;
+        }
+        case CVarType::FLOAT: {
+            float parsed = 0.0f;
+            if (!parseConfigFloat(value, parsed) || parsed < var.minValue || parsed > var.maxValue) {
+                consoleCapture.addLine("CVAR: " + var.name + " must be a number " + range());
+                return false;
+            }
+            *var.floatValue = parsed;
+            break;
+        }
+        case CVarType::BOOL:
+            if (!parseConfigBool(value, *var.boolValue)) {
+                consoleCapture.addLine("CVAR: " + var.name + " must be true or false");
+                return false;
+            }
+            break;
+        case CVarType::STRING:
+            var.stringValue->assign(value.data(), value.size());
+            break;
+    }
+
+    consoleCapture.addLine(frameArena.concat({"CL: ", var.name, " = ", var.value(frameArena)}));
+    for (const ChangeCallback& callback : entries[index].callbacks) {
+        callback(var);
+    }
+    return true;
+}
+
+void CVarRegistry::notifyChanged(std::string_view name) const {
+    const int index = names.find(name);
+    if (index < 0) return;
+    for (const ChangeCallback& callback : entries[index].callbacks) {
+        callback(entries[index].var);
+    }
+}
+
+size_t CVarRegistry::complete(std::string_view prefix, std::vector<const CVar*>& matches, size_t maxResults) const {
+    std::vector<int> ids;
+    const size_t total = names.collect(prefix, ids, maxResults);
+    for (int id : ids) {
+        matches.push_back(&entries[id].var);
+    }
+    return total;
+}
@@ -0,0 +1,91 @@
+#ifndef CVAR_REGISTRY_H
+#define CVAR_REGISTRY_H
+
+#include "PrefixTrie.h"
+#include "FrameArena.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The type of value a console variable holds.
+enum class CVarType : uint8_t { INT, FLOAT, BOOL, STRING };
+
+// The CVar struct is a console variable: a name bound to a value that lives elsewhere, such as a
+// GameConfig field, and the range new values must fall in.
+struct CVar {
+    std::string name;
+    CVarType type = CVarType::INT;
+    int* intValue = nullptr;
+    float* floatValue = nullptr;
+    bool* boolValue = nullptr;
+    std::string* stringValue = nullptr;
+    double minValue = 0.0;   // The inclusive range for numeric variables.
+    double maxValue = 0.0;
+    bool readOnly = false;   // Whether the console may only read the variable.
+    bool simulation = false; // Whether replays depend on the variable, so it is held while one runs.
+
+    // Formats the current value the way it would be typed.
+    std::string value() const;
+    // Formats the current value into the frame arena.
+    std::string_view value(FrameArena& arena) const;
+};
+
+// The CVarRegistry class holds the console variables and looks them up by name.
+// Names are kept in a prefix trie, so lookups and completions cost the same however many
+// variables are registered. Values are parsed and range checked before they are stored, and
+// change callbacks run after every successful write.
+class CVarRegistry {
+public:
+    // A function run after a variable changes.
+    using ChangeCallback = std::function<void(const CVar&)>;
+
+    // Registers a variable bound to a value, which must outlive the registry. Names may use
+    // lowercase letters, digits and '_'. Returns false if the name is invalid or already taken.
+    bool addInt(std::string_view name, int& value, int minValue, int maxValue, bool readOnly = false);
+    bool addFloat(std::string_view name, float& value, float minValue, float maxValue, bool readOnly = false);
+    bool addBool(std::string_view name, bool& value, bool readOnly = false);
+    bool addString(std::string_view name, std::string& value, bool readOnly = false);
+    // Adds a callback to run after a variable changes. Returns false for an unknown name.
+    bool onChange(std::string_view name, ChangeCallback callback);
+    // Marks a variable that replays depend on. Returns false for an unknown name.
+    bool markSimulation(std::string_view name);
+    // Holds the variables replays depend on while recording or replaying, so setting one is
+    // rejected rather than making the replay diverge from the recording.
+    void holdSimulation(bool hold) { simulationHeld = hold; }
+    // Checks if the variables replays depend on are held.
+    bool isSimulationHeld() const { return simulationHeld; }
+
+    // Returns the variable with a name, or nullptr. Valid until the next variable is added.
+    const CVar* find(std::string_view name) const;
+    // Parses, validates and stores a new value, then runs the callbacks. Problems are reported
+    // to the console. Returns false if the value was rejected.
+    bool set(std::string_view name, std::string_view value);
+    // Runs a variable's callbacks after its value was changed some other way.
+    void notifyChanged(std::string_view name) const;
+    // Appends up to maxResults variables whose names start with prefix, in alphabetical order.
+    // Returns the total number of matches.
+    size_t complete(std::string_view prefix, std::vector<const CVar*>& matches, size_t maxResults) const;
+    // Returns the longest prefix shared by every variable name that starts with prefix.
+    std::string commonPrefix(std::string_view prefix) const { return names.commonPrefix(prefix); }
+    // Returns the number of registered variables.
+    size_t size() const { return entries.size(); }
+
+private:
+    // The Entry struct is a variable and the callbacks watching it.
+    struct Entry {
+        CVar var;
+        std::vector<ChangeCallback> callbacks;
+    };
+
+    // Adds a variable to the list and the trie.
+    bool add(CVar var);
+
+    std::vector<Entry> entries;
+    PrefixTrie names;        // Maps names to indices in entries.
+    bool simulationHeld = false;
+};
+
+#endif // CVAR_REGISTRY_H
@@ -2,7 +2,7 @@
 #define COMMAND_H
 
 #include "Player.h"
-#include <string>
+#include <string_view>
 #include <vector>
 
 // The Command class is an abstract base class for all commands in the game.
@@ -12,8 +12,9 @@ public:
     // Virtual destructor.
     virtual ~Command() = default;
     // The pure virtual execute function that must be implemented by all derived classes.
-    // It takes a vector of string arguments and a reference to the Player object.
-    virtual void execute(const std::vector<std::string>& args, Player& player) = 0;
+    // It takes the arguments, which point into the command line and are only valid during the
+    // call, and a reference to the Player object.
+    virtual void execute(const std::vector<std::string_view>& args, Player& player) = 0;
 };
 
 #endif // COMMAND_H
\ No newline at end of file
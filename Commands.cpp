@@ -1,67 +1,420 @@
 #include "Commands.h"
 #include "Player.h"
 #include "ConsoleCapture.h"
-#include <iostream>
-#include <sstream>
+#include "Profiler.h"
+#include "ConfigParser.h"
+#include "PerfectHash.h"
+#include "FrameArena.h"
+#include "RewindBuffer.h"
+#include "TimelineArchive.h"
+#include <algorithm>
+#include <fstream>
 #include <vector>
 
-// SpeedCommand implementation
-// Defines a command to change the player's speed.
-class SpeedCommand : public Command {
+namespace {
+    // Maps a command name to its index in COMMAND_NAMES.
+    constexpr PerfectHash<16> COMMAND_HASH = PerfectHash<16>::build(COMMAND_NAMES);
+    static_assert(COMMAND_HASH.valid, "COMMAND_NAMES must be unique; grow the table if they collide");
+
+    // Returns whether a character separates the words of a command.
+    bool isCommandSpace(char ch) {
+        return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+    }
+}
+
+// Splits a line into words without copying them.
+size_t tokenizeCommand(std::string_view line, std::vector<std::string_view>& words) {
+    words.clear();
+    size_t i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && isCommandSpace(line[i])) ++i;
+        const size_t start = i;
+        while (i < line.size() && !isCommandSpace(line[i])) ++i;
+        if (i > start) words.push_back(line.substr(start, i - start));
+    }
+    return words.size();
+}
+
+// ProfilerCommand implementation
+// Defines a command to show or hide the profiler overlay.
+class ProfilerCommand : public Command {
 public:
-    // Executes the speed command.
-    // Takes a vector of string arguments and a reference to the Player object.
-    void execute(const std::vector<std::string>& args, Player& player) override {
-        // Check if the correct number of arguments is provided.
+    // Executes the profiler command. Takes an optional "on" or "off" argument; toggles otherwise.
+    void execute(const std::vector<std::string_view>& args, Player&) override {
+        if (args.empty()) {
+            profiler.overlayVisible = !profiler.overlayVisible;
+        } else if (args[0] == "on" || args[0] == "off") {
+            profiler.overlayVisible = args[0] == "on";
+        } else {
+            consoleCapture.addLine("PROFILER: Usage: profiler [on|off]");
+            return;
+        }
+        consoleCapture.addLine(profiler.overlayVisible ? "CL: Profiler overlay on" : "CL: Profiler overlay off");
+    }
+};
+
+// ProfDumpCommand implementation
+// Defines a command to write the last frames as a Chrome trace (open in chrome://tracing or Perfetto).
+class ProfDumpCommand : public Command {
+public:
+    // Executes the profdump command. Takes an optional frame count and output path.
+    void execute(const std::vector<std::string_view>& args, Player&) override {
+        size_t frames = 120;
+        std::string path = "profile.json";
+        if (args.size() > 2) {
+            consoleCapture.addLine("PROFDUMP: Usage: profdump [frames] [path]");
+            return;
+        }
+        int requested = 0;
+        if (!args.empty()) {
+            if (!parseConfigInt(args[0], requested)) {
+                consoleCapture.addLine("PROFDUMP: Frame count must be a number");
+                return;
+            }
+            frames = static_cast<size_t>(std::max(1, requested));
+        }
+        if (args.size() == 2) path = args[1];
+        
+        frames = std::min(frames, profiler.frameCount());
+        if (profiler.writeChromeTrace(path, frames)) {
+            consoleCapture.addLine("CL: Wrote " + std::to_string(frames) + " frames to " + path);
+        } else {
+            consoleCapture.addLine("PROFDUMP: Could not write " + path);
+        }
+    }
+};
+
+// CvarsCommand implementation
+// Defines a command to list the console variables and their values.
+class CvarsCommand : public Command {
+public:
+    explicit CvarsCommand(const CVarRegistry& registry) : registry(registry) {}
+    
+    // Executes the cvars command. Takes an optional name prefix.
+    void execute(const std::vector<std::string_view>& args, Player&) override {
+        if (args.size() > 1) {
+            consoleCapture.addLine("CVARS: Usage: cvars [prefix]");
+            return;
+        }
+        std::vector<const CVar*> matches;
+        const size_t total = registry.complete(args.empty() ? std::string_view() : args[0], matches, registry.size());
+        for (const CVar* var : matches) {
+            consoleCapture.addLine("CL: " + var->name + " = " + var->value() + (var->readOnly ? " (read-only)" : ""));
+        }
+        consoleCapture.addLine("CL: " + std::to_string(total) + " variables");
+    }
+
+private:
+    const CVarRegistry& registry;
+};
+
+// ExecCommand implementation
+// Defines a command to run a script of console commands.
+class ExecCommand : public Command {
+public:
+    explicit ExecCommand(CommandParser& parser) : parser(parser) {}
+
+    // Executes the exec command. Takes the script's path. The script starts once this returns.
+    void execute(const std::vector<std::string_view>& args, Player&) override {
         if (args.size() != 1) {
-            consoleCapture.addLine("SPEED: No arguments");
+            consoleCapture.addLine("EXEC: Usage: exec <file>");
+            return;
+        }
+        parser.execScript(std::string(args[0]));
+    }
+
+private:
+    CommandParser& parser;
+};
+
+// WaitCommand implementation
+// Defines a command to pause the running script.
+class WaitCommand : public Command {
+public:
+    explicit WaitCommand(CommandParser& parser) : parser(parser) {}
+
+    // Executes the wait command. Takes an optional tick count, 1 by default.
+    void execute(const std::vector<std::string_view>& args, Player&) override {
+        int ticks = 1;
+        if (args.size() > 1 || (args.size() == 1 && (!parseConfigInt(args[0], ticks) || ticks < 1 ||
+                                                     ticks > SCRIPT_MAX_WAIT))) {
+            consoleCapture.addLine("WAIT: Usage: wait [ticks], at most " + std::to_string(SCRIPT_MAX_WAIT));
+            return;
+        }
+        parser.waitTicks(ticks);
+    }
+
+private:
+    CommandParser& parser;
+};
+
+// ScrubCommand implementation
+// Defines a command to move the world to a time in the timeline archive.
+class ScrubCommand : public Command {
+public:
+    ScrubCommand(TimelineWriter& timeline, RewindBuffer& rewindBuffer, const CVarRegistry& registry)
+        : timeline(timeline), rewindBuffer(rewindBuffer), registry(registry) {}
+
+    // Executes the scrub command. Takes the time in seconds from the start of the archive, or back
+    // from now if negative; without one, prints how much the archive holds. A replay cannot read
+    // the archive the recording scrubbed through, so scrubbing is held like the simulation cvars.
+    void execute(const std::vector<std::string_view>& args, Player& player) override {
+        float seconds = 0.0f;
+        if (args.size() > 1 || (args.size() == 1 && !parseConfigFloat(args[0], seconds))) {
+            consoleCapture.addLine("SCRUB: Usage: scrub [seconds], negative to count back from now");
             return;
         }
-        try {
-            // Convert the argument to a float to use as a speed multiplier.
-            float speedMultiplier = std::stof(args[0]);
-            // Update player's speed and max speed based on the multiplier.
-            player.speed = player.baseSpeed * speedMultiplier;
-            player.maxSpeed = player.baseMaxSpeed * speedMultiplier;
-            // Log the new speed to the console.
-            consoleCapture.addLine("CL: Speed set to " + std::to_string(static_cast<int>(player.speed)));
-        } catch (const std::invalid_argument& e) {
-            // Handle cases where the argument is not a valid number. (NUMBERS BABY NUMBERS!)
-            consoleCapture.addLine("CL: NUMERS BABY NUMBERS"); // I seriously don't know why I did this as a reference to the Apollo lmao
+        if (!timeline.isOpen()) {
+            consoleCapture.addLine("SCRUB: No timeline is being archived (see archive_path)");
+            return;
         }
+        const uint64_t lastTick = timeline.tickCount() - 1;
+        const double rate = static_cast<double>(timeline.tickRate());
+        if (args.empty()) {
+            consoleCapture.addLine(frameArena.format("CL: Timeline holds %.2f s (%llu ticks)", static_cast<double>(lastTick) / rate,
+                                                     static_cast<unsigned long long>(lastTick + 1)));
+            return;
+        }
+        if (registry.isSimulationHeld()) {
+            consoleCapture.addLine("SCRUB: Scrubbing is held while recording or replaying");
+            return;
+        }
+
+        const double ticksBack = seconds < 0.0f ? static_cast<double>(lastTick) + seconds * rate : seconds * rate;
+        const uint64_t offset = static_cast<uint64_t>(std::clamp(ticksBack + 0.5, 0.0, static_cast<double>(lastTick)));
+        if (!timeline.seek(timeline.firstTick() + offset, *player.store)) return;
+        // The rewind history belongs to the time left behind.
+        rewindBuffer.clear();
+        consoleCapture.addLine(frameArena.format("CL: Scrubbed to %.2f s", static_cast<double>(offset) / rate));
     }
+
+private:
+    TimelineWriter& timeline;
+    RewindBuffer& rewindBuffer;
+    const CVarRegistry& registry;
 };
 
 // CommandParser implementation
 // Manages and processes registered commands.
 CommandParser::CommandParser() {
-    // Register the "speed" command.
-    commands["speed"] = std::make_unique<SpeedCommand>();
+    // Register the profiler commands.
+    addCommand("profiler", std::make_unique<ProfilerCommand>());
+    addCommand("profdump", std::make_unique<ProfDumpCommand>());
+    // Register the console variable listing.
+    addCommand("cvars", std::make_unique<CvarsCommand>(variables));
+    // Register the script commands.
+    addCommand("exec", std::make_unique<ExecCommand>(*this));
+    addCommand("wait", std::make_unique<WaitCommand>(*this));
 }
 
-// Parses a command string and executes the corresponding command.
+void CommandParser::bindTimeline(TimelineWriter& timeline, RewindBuffer& rewindBuffer) {
+    addCommand("scrub", std::make_unique<ScrubCommand>(timeline, rewindBuffer, variables));
+}
+
+// Stores a command in the dispatch table and its name in the completion trie.
+void CommandParser::addCommand(std::string_view name, std::unique_ptr<Command> command) {
+    const int index = COMMAND_HASH.find(name);
+    if (index < 0 || COMMAND_NAMES[index] != name) {
+        consoleCapture.addLine("CL: Cannot register command " + std::string(name));
+        return;
+    }
+    commandTrie.insert(name, index);
+    commands[index] = std::move(command);
+}
+
+// Echoes a command string to the console, then executes it.
 void CommandParser::parseAndExecute(const std::string& input, Player& player) {
     // Log the command to the console.
-    consoleCapture.addLine("> " + input);
-    std::stringstream ss(input);
-    std::string commandName;
-    // Extract the command name from the input string.
-    ss >> commandName;
-
-    // Extract the arguments from the input string.
-    std::vector<std::string> args;
-    std::string arg;
-    while (ss >> arg) {
-        args.push_back(arg);
-    }
-
-    // Find the command in the commands map.
-    auto it = commands.find(commandName);
-    if (it != commands.end()) {
-        // If found, execute the command with the provided arguments.
-        it->second->execute(args, player);
-    } else {
+    consoleCapture.addLine(frameArena.concat({"> ", input}));
+
+    if (!execute(input, player)) {
         // If not found, log an error message.
         consoleCapture.addLine("CL: Illegal command");
     }
-}
\ No newline at end of file
+    // A script started by the command runs until its first wait.
+    runScripts(player);
+}
+
+// Splits off the command name, then looks it up with one hash and one comparison.
+bool CommandParser::execute(std::string_view line, Player& player) {
+    size_t start = 0;
+    while (start < line.size() && isCommandSpace(line[start])) ++start;
+    size_t end = start;
+    while (end < line.size() && !isCommandSpace(line[end])) ++end;
+    const std::string_view commandName = line.substr(start, end - start);
+    tokenizeCommand(line.substr(end), args);
+
+    const int index = COMMAND_HASH.find(commandName);
+    if (index >= 0 && COMMAND_NAMES[index] == commandName && commands[index]) {
+        // If found, execute the command with the provided arguments.
+        commands[index]->execute(args, player);
+    } else if (const CVar* var = variables.find(commandName)) {
+        // A variable name alone prints the value; with one argument it sets it.
+        if (args.empty()) {
+            std::string text = "CL: " + var->name + " = " + var->value();
+            if (var->type == CVarType::INT || var->type == CVarType::FLOAT) {
+                text += " (" + formatConfigNumber(var->minValue) + " to " + formatConfigNumber(var->maxValue) + ")";
+            }
+            consoleCapture.addLine(text + (var->readOnly ? " (read-only)" : ""));
+        } else if (args.size() == 1) {
+            variables.set(commandName, args[0]);
+        } else {
+            consoleCapture.addLine("CVAR: Usage: " + var->name + " [value]");
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Reads the whole file and indexes its command lines, skipping blank lines and comments.
+bool CommandParser::execScript(const std::string& path) {
+    // A script that ends with exec is finished, so the new one takes its place rather than nesting.
+    while (scriptDepth > 0 && scripts[scriptDepth - 1].wait == 0 &&
+           scripts[scriptDepth - 1].next >= scripts[scriptDepth - 1].lines.size()) {
+        --scriptDepth;
+    }
+    if (scriptDepth >= SCRIPT_MAX_DEPTH) {
+        consoleCapture.addLine("EXEC: Scripts are nested too deeply to run " + path);
+        return false;
+    }
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        consoleCapture.addLine("EXEC: Could not read " + path);
+        return false;
+    }
+    const std::streamoff size = file.tellg();
+    if (size < 0 || size > static_cast<std::streamoff>(UINT32_MAX)) {
+        consoleCapture.addLine("EXEC: Could not read " + path);
+        return false;
+    }
+
+    if (scripts.size() <= scriptDepth) {
+        scripts.emplace_back();
+    }
+    Script& script = scripts[scriptDepth];
+    script.text.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    if (!file.read(script.text.data(), size)) {
+        consoleCapture.addLine("EXEC: Could not read " + path);
+        return false;
+    }
+    script.path = path;
+    script.lines.clear();
+    script.next = 0;
+    script.wait = 0;
+
+    uint32_t number = 0;
+    for (size_t lineStart = 0; lineStart < script.text.size();) {
+        size_t lineEnd = lineStart;
+        while (lineEnd < script.text.size() && script.text[lineEnd] != '\n') ++lineEnd;
+        ++number;
+
+        size_t first = lineStart;
+        while (first < lineEnd && isCommandSpace(script.text[first])) ++first;
+        const bool comment = first < lineEnd && (script.text[first] == '#' ||
+            (script.text[first] == '/' && first + 1 < lineEnd && script.text[first + 1] == '/'));
+        if (first < lineEnd && !comment) {
+            script.lines.push_back({static_cast<uint32_t>(first), static_cast<uint32_t>(lineEnd - first), number});
+        }
+        lineStart = lineEnd + 1;
+    }
+
+    ++scriptDepth;
+    consoleCapture.addLine("CL: Running " + path + " (" + std::to_string(script.lines.size()) + " commands)");
+    return true;
+}
+
+void CommandParser::waitTicks(long long ticks) {
+    if (scriptDepth == 0) {
+        consoleCapture.addLine("WAIT: Only scripts can wait");
+        return;
+    }
+    scripts[scriptDepth - 1].wait = std::min(ticks, SCRIPT_MAX_WAIT);
+}
+
+// Resumes the innermost script once its wait has run out.
+void CommandParser::update(Player& player) {
+    if (scriptDepth == 0) return;
+    Script& script = scripts[scriptDepth - 1];
+    if (script.wait > 0 && --script.wait > 0) return;
+    runScripts(player);
+}
+
+// Runs the innermost script's lines in order. A line may start a nested script, which then runs
+// before the rest of this one, or pause the innermost script with a wait. Finished scripts are
+// left in the list so their buffers can be reused.
+void CommandParser::runScripts(Player& player) {
+    while (scriptDepth > 0) {
+        // Look the script up for each line, since exec may grow the list.
+        const size_t depth = scriptDepth - 1;
+        if (scripts[depth].wait > 0) return;
+        if (scripts[depth].next >= scripts[depth].lines.size()) {
+            --scriptDepth;
+            continue;
+        }
+
+        const Script::Line line = scripts[depth].lines[scripts[depth].next++];
+        const std::string_view text(scripts[depth].text.data() + line.offset, line.length);
+        if (!execute(text, player)) {
+            const Script& script = scripts[depth];
+            consoleCapture.addLine("EXEC: " + script.path + ":" + std::to_string(line.number) + ": Illegal command");
+        }
+    }
+}
+
+// Completes the first word from the command and variable names. Both lists are sorted, so the
+// listing merges them in order.
+std::string CommandParser::complete(const std::string& input) const {
+    if (input.find(' ') != std::string::npos) {
+        return input;
+    }
+    
+    std::vector<int> commandIds;
+    std::vector<const CVar*> cvarMatches;
+    const size_t commandTotal = commandTrie.collect(input, commandIds, COMPLETION_LIST_MAX);
+    const size_t cvarTotal = variables.complete(input, cvarMatches, COMPLETION_LIST_MAX);
+    const size_t total = commandTotal + cvarTotal;
+    if (total == 0) {
+        return input;
+    }
+    if (total == 1) {
+        return (commandTotal == 1 ? std::string(COMMAND_NAMES[commandIds[0]]) : cvarMatches[0]->name) + " ";
+    }
+    
+    // Extend the input as far as every match agrees.
+    std::string extended;
+    if (commandTotal == 0) {
+        extended = variables.commonPrefix(input);
+    } else if (cvarTotal == 0) {
+        extended = commandTrie.commonPrefix(input);
+    } else {
+        const std::string fromCommands = commandTrie.commonPrefix(input);
+        const std::string fromCvars = variables.commonPrefix(input);
+        size_t length = input.size();
+        while (length < fromCommands.size() && length < fromCvars.size() && fromCommands[length] == fromCvars[length]) {
+            ++length;
+        }
+        extended = fromCommands.substr(0, length);
+    }
+    if (extended.size() > input.size()) {
+        return extended;
+    }
+    
+    // Nothing to add, so list the candidates instead.
+    std::string listing = "CL:";
+    size_t listed = 0;
+    size_t commandIndex = 0, cvarIndex = 0;
+    while (listed < COMPLETION_LIST_MAX && (commandIndex < commandIds.size() || cvarIndex < cvarMatches.size())) {
+        const bool takeCommand = cvarIndex >= cvarMatches.size() || 
+            (commandIndex < commandIds.size() && COMMAND_NAMES[commandIds[commandIndex]] < cvarMatches[cvarIndex]->name);
+        listing += ' ';
+        listing += takeCommand ? COMMAND_NAMES[commandIds[commandIndex++]] : std::string_view(cvarMatches[cvarIndex++]->name);
+        ++listed;
+    }
+    if (total > listed) {
+        listing += " (+" + std::to_string(total - listed) + " more)";
+    }
+    consoleCapture.addLine(listing);
+    return input;
+}
@@ -2,22 +2,99 @@
 #define COMMANDS_H
 
 #include "Command.h"
+#include "CVarRegistry.h"
+#include "PrefixTrie.h"
+#include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
-#include <unordered_map>
+
+class RewindBuffer;
+class TimelineWriter;
+
+// Constants for console completion.
+constexpr size_t COMPLETION_LIST_MAX = 8; // The most matches listed in the console for an ambiguous completion.
+
+// Constants for console scripts.
+constexpr size_t SCRIPT_MAX_DEPTH = 8;          // The most scripts that can be running inside each other.
+constexpr long long SCRIPT_MAX_WAIT = 1000000;  // The most ticks a single wait may pause a script for.
+
+// The names of the built-in commands, in alphabetical order. A command's position in this list
+// is its index in the dispatch table.
+constexpr std::array<std::string_view, 6> COMMAND_NAMES = {"cvars", "exec", "profdump", "profiler", "scrub", "wait"};
+
+// Splits a command line into words separated by spaces or tabs. The words point into the line.
+// The vector is cleared first, so reusing one keeps its capacity. Returns the number of words.
+size_t tokenizeCommand(std::string_view line, std::vector<std::string_view>& words);
 
 // The CommandParser class is responsible for parsing user input and executing the corresponding commands.
+// Input whose first word is not a command is treated as a console variable: "name" prints its
+// value and "name value" sets it.
+//
+// Scripts started with "exec <file>" run one command per line. They run to the end at once, unless
+// a "wait [ticks]" line pauses them; update() resumes paused scripts each tick, so a script can
+// replay a scenario tick by tick.
 class CommandParser {
 public:
     // Constructor that initializes the command parser and registers the available commands.
     CommandParser();
-    // Parses the given input string and executes the corresponding command.
+    // Echoes the input to the console, executes it and runs any script it started.
     void parseAndExecute(const std::string& input, Player& player);
+    // Executes one command line without echoing it. Returns false, without reporting it, if the
+    // first word is neither a command nor a variable.
+    bool execute(std::string_view line, Player& player);
+    // Completes the command or variable name at the start of the input. A single match is
+    // completed in full; several are extended to their longest common prefix, and listed in the
+    // console if that adds nothing. Returns the new input.
+    std::string complete(const std::string& input) const;
+
+    // Loads a script to run from its first line. Returns false if the file cannot be read or too
+    // many scripts are already running.
+    bool execScript(const std::string& path);
+    // Pauses the innermost running script for a number of ticks.
+    void waitTicks(long long ticks);
+    // Counts down a wait and runs the scripts until they pause or finish. Called once per tick.
+    void update(Player& player);
+    // Returns whether a script is loaded and has lines left to run.
+    bool scriptRunning() const { return scriptDepth > 0; }
+
+    // Registers the scrub command, which moves the world to a time in the given archive and drops
+    // the rewind history. Both must outlive any command run through the parser.
+    void bindTimeline(TimelineWriter& timeline, RewindBuffer& rewindBuffer);
+
+    // Returns the console variables the parser reads and writes.
+    CVarRegistry& cvars() { return variables; }
 
 private:
-    // A map that stores the registered commands, mapping command names to Command objects.
-    std::unordered_map<std::string, std::unique_ptr<Command>> commands;
+    // The Script struct is a loaded script file and the position reached in it. Its buffers are
+    // reused by the next script loaded at the same depth.
+    struct Script {
+        struct Line {
+            uint32_t offset;
+            uint32_t length;
+            uint32_t number;   // The line number in the file, for messages.
+        };
+        std::string path;
+        std::vector<char> text;
+        std::vector<Line> lines;
+        size_t next = 0;       // The index of the next line to run.
+        long long wait = 0;    // The ticks left before the script resumes.
+    };
+
+    // Registers a command under one of COMMAND_NAMES.
+    void addCommand(std::string_view name, std::unique_ptr<Command> command);
+    // Runs script lines until the scripts finish or a wait pauses them.
+    void runScripts(Player& player);
+
+    // The registered commands, indexed like COMMAND_NAMES.
+    std::array<std::unique_ptr<Command>, COMMAND_NAMES.size()> commands;
+    PrefixTrie commandTrie;   // Maps command names to their index, for completion.
+    CVarRegistry variables;
+    std::vector<std::string_view> args;    // The arguments of the line being executed.
+    std::vector<Script> scripts;           // The running scripts, innermost last, and spare buffers.
+    size_t scriptDepth = 0;                // The number of entries in scripts that are running.
 };
 
-#endif // COMMANDS_H
\ No newline at end of file
+#endif // COMMANDS_H
@@ -1,82 +1,173 @@
 #include "ConfigParser.h"
 #include "ConsoleCapture.h"
-#include <fstream>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <algorithm>
 
 namespace {
-    // Helper function to trim whitespace from both ends of a string.
-    void trimWhitespace(std::string& str) {
-        // Trim leading whitespace.
-        str.erase(str.begin(), std::find_if(str.begin(), str.end(), [](unsigned char ch) {
-            return !std::isspace(ch);
-        }));
-        
-        // Trim trailing whitespace.
-        str.erase(std::find_if(str.rbegin(), str.rend(), [](unsigned char ch) {
-            return !std::isspace(ch);
-        }).base(), str.end());
+    // Checks if a character is INI whitespace.
+    bool isSpace(char ch) {
+        return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == '\f' || ch == '\v';
     }
-    
-    // Helper function to trim quotes from the beginning and end of a string.
-    void trimQuotes(std::string& str) {
+
+    // Helper function to trim whitespace from both ends of a view.
+    std::string_view trimWhitespace(std::string_view str) {
+        while (!str.empty() && isSpace(str.front())) str.remove_prefix(1);
+        while (!str.empty() && isSpace(str.back())) str.remove_suffix(1);
+        return str;
+    }
+
+    // Helper function to trim quotes from the beginning and end of a view.
+    std::string_view trimQuotes(std::string_view str) {
         if (!str.empty() && (str.front() == '"' || str.front() == '\'')) {
-            str.erase(0, 1);
+            str.remove_prefix(1);
         }
         if (!str.empty() && (str.back() == '"' || str.back() == '\'')) {
-            str.pop_back();
+            str.remove_suffix(1);
         }
+        return str;
     }
-    
+
     // Checks if a line is a comment or empty and should be skipped.
-    bool shouldSkipLine(const std::string& line) {
-        return line.empty() || line[0] == '#';
+    bool shouldSkipLine(std::string_view line) {
+        return line.empty() || line[0] == '#' || line[0] == ';';
+    }
+
+    // Reports a problem with a line of the file.
+    void reportLine(const std::string& filepath, int line, const std::string& message) {
+        consoleCapture.addLine("CONFIG: " + filepath + ":" + std::to_string(line) + ": " + message);
     }
 }
 
-// Parses an INI file and returns a map of key-value pairs.
-std::unordered_map<std::string, std::string> parseINI(const std::string& filepath) {
-    std::unordered_map<std::string, std::string> result;
-    
-    std::ifstream file(filepath);
-    if (!file.is_open()) {
+// ConfigFile implementation
+// Reads or maps the whole file. Mapping has a fixed cost that only pays off for large files.
+// An empty file has nothing to load and simply has no entries.
+bool ConfigFile::open(const std::string& filepath) {
+    close();
+    filePath = filepath;
+
+    if (!file.open(filepath, CONFIG_MAP_THRESHOLD)) {
         const std::string errorMsg = "Failed to open " + filepath;
         std::cerr << errorMsg << '\n';
         consoleCapture.addLine(errorMsg);
-        return result;
+        return false;
     }
-    
-    std::string line;
-    line.reserve(256);  // Reserve space to reduce re-allocations in the loop.
-    
-    // Read the file line by line.
-    while (std::getline(file, line)) {
-        trimWhitespace(line);
-        
+
+    parse();
+    return true;
+}
+
+// Unmaps the file and drops its entries. The read buffer keeps its capacity for the next open().
+void ConfigFile::close() {
+    file.close();
+    parsedEntries.clear();
+}
+
+// Walks the text line by line. Only the entry list allocates, and it is reserved up front.
+void ConfigFile::parse() {
+    const std::string_view text(reinterpret_cast<const char*>(file.data()), file.size());
+    size_t lineCount = 1;
+    for (char ch : text) {
+        lineCount += ch == '\n';
+    }
+    parsedEntries.reserve(lineCount);
+
+    std::string_view section;
+    int lineNumber = 0;
+    size_t lineStart = 0;
+    while (lineStart < text.size()) {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) lineEnd = text.size();
+        const std::string_view line = trimWhitespace(text.substr(lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
+        ++lineNumber;
+
         if (shouldSkipLine(line)) {
             continue;
         }
-        
+
+        // A section header applies to every key until the next header.
+        if (line.front() == '[') {
+            if (line.back() != ']') {
+                reportLine(filePath, lineNumber, "Unterminated section header");
+                continue;
+            }
+            section = trimWhitespace(line.substr(1, line.size() - 2));
+            continue;
+        }
+
         // Find the position of the '=' separator.
         const size_t equalPos = line.find('=');
-        if (equalPos == std::string::npos) {
-            continue;  // Skip lines that do not contain a '='.
+        if (equalPos == std::string_view::npos) {
+            reportLine(filePath, lineNumber, "Expected key = value");
+            continue;
         }
-        
-        // Extract the key and value from the line.
-        std::string key = line.substr(0, equalPos);
-        std::string value = line.substr(equalPos + 1);
-        
-        // Clean up the key and value.
-        trimWhitespace(key);
-        trimWhitespace(value);
-        trimQuotes(value);
-        
-        // Add the key-value pair to the map if the key is not empty.
-        if (!key.empty()) {
-            result.emplace(std::move(key), std::move(value));
+
+        const std::string_view key = trimWhitespace(line.substr(0, equalPos));
+        const std::string_view value = trimQuotes(trimWhitespace(line.substr(equalPos + 1)));
+        if (key.empty()) {
+            reportLine(filePath, lineNumber, "Missing key");
+            continue;
         }
+        parsedEntries.push_back({section, key, value, lineNumber});
+    }
+}
+
+// Value parsing
+bool parseConfigInt(std::string_view text, int& out) {
+    const char* first = text.data();
+    const char* last = first + text.size();
+    if (first != last && *first == '+') ++first;
+    int value = 0;
+    const auto [end, error] = std::from_chars(first, last, value);
+    if (error != std::errc() || end != last) return false;
+    out = value;
+    return true;
+}
+
+// Standard libraries without floating-point from_chars fall back to strtof, which needs a
+// terminated string, so the text is copied to the stack first.
+bool parseConfigFloat(std::string_view text, float& out) {
+    float value = 0.0f;
+#if defined(__cpp_lib_to_chars)
+    const char* first = text.data();
+    const char* last = first + text.size();
+    if (first != last && *first == '+') ++first;
+    const auto [end, error] = std::from_chars(first, last, value);
+    if (error != std::errc() || end != last || !std::isfinite(value)) return false;
+#else
+    char buffer[64];
+    if (text.empty() || text.size() >= sizeof(buffer)) return false;
+    std::memcpy(buffer, text.data(), text.size());
+    buffer[text.size()] = '\0';
+
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtof(buffer, &end);
+    if (end != buffer + text.size() || errno == ERANGE || !std::isfinite(value)) return false;
+#endif
+    out = value;
+    return true;
+}
+
+bool parseConfigBool(std::string_view text, bool& out) {
+    if (text == "true" || text == "1" || text == "yes" || text == "on") {
+        out = true;
+        return true;
+    }
+    if (text == "false" || text == "0" || text == "no" || text == "off") {
+        out = false;
+        return true;
     }
-    
-    return result;
+    return false;
+}
+
+std::string formatConfigNumber(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%g", value);
+    return buffer;
 }
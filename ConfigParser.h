@@ -1,11 +1,64 @@
 #ifndef CONFIG_PARSER_H
 #define CONFIG_PARSER_H
 
-#include <unordered_map>
+#include "MappedFile.h"
+#include <cstddef>
 #include <string>
+#include <string_view>
+#include <vector>
 
-// Declares the function to parse an INI file.
-// The function takes a file path as input and returns a map of key-value pairs.
-std::unordered_map<std::string, std::string> parseINI(const std::string& filepath);
+// Constants for config loading.
+constexpr size_t CONFIG_MAP_THRESHOLD = 256 * 1024; // Files this large are memory-mapped; smaller ones are read.
 
-#endif // CONFIG_PARSER_H
\ No newline at end of file
+// The ConfigEntry struct is one key-value pair from an INI file.
+// The views point into the file's mapping and stay valid for as long as the ConfigFile does.
+struct ConfigEntry {
+    std::string_view section;  // The [section] the key appeared under, empty before the first header.
+    std::string_view key;
+    std::string_view value;    // Trimmed, with surrounding quotes removed.
+    int line = 0;              // The 1-based line number, for error messages.
+};
+
+// The ConfigFile class loads an INI file and splits it into entries in place, without copying
+// keys or values. Large files are memory-mapped; small ones are cheaper to read into a buffer,
+// which is kept for the next open(). Lines starting with '#' or ';' are comments, and "[name]"
+// starts a section. Lines without an '=' are reported and skipped.
+class ConfigFile {
+public:
+    ConfigFile() = default;
+
+    ConfigFile(ConfigFile&& other) noexcept = default;
+    ConfigFile& operator=(ConfigFile&& other) noexcept = default;
+    ConfigFile(const ConfigFile&) = delete;
+    ConfigFile& operator=(const ConfigFile&) = delete;
+
+    // Loads and parses a file, replacing anything opened before. Returns false if it cannot be read.
+    bool open(const std::string& filepath);
+    // Releases the file. Any views taken from it become invalid.
+    void close();
+
+    // Returns the entries in file order.
+    const std::vector<ConfigEntry>& entries() const { return parsedEntries; }
+    // Returns the path the file was opened from.
+    const std::string& path() const { return filePath; }
+
+private:
+    // Splits the mapped text into entries.
+    void parse();
+
+    std::string filePath;
+    MappedFile file;           // The file's contents, mapped or read depending on its size.
+    std::vector<ConfigEntry> parsedEntries;
+};
+
+// Parses a whole value as a decimal integer, without allocating or throwing.
+// Returns false, leaving out unchanged, if the value is not one.
+bool parseConfigInt(std::string_view text, int& out);
+// Parses a whole value as a finite float, without allocating or throwing.
+bool parseConfigFloat(std::string_view text, float& out);
+// Parses "true"/"false", "1"/"0", "yes"/"no" or "on"/"off".
+bool parseConfigBool(std::string_view text, bool& out);
+// Formats a number the way it would be written in a config file, without trailing zeros.
+std::string formatConfigNumber(double value);
+
+#endif // CONFIG_PARSER_H
@@ -0,0 +1,142 @@
+#include "ConfigWatcher.h"
+#include "ConsoleCapture.h"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+// Sets up the watch and starts the watcher thread.
+bool ConfigWatcher::start(const std::string& filepath, const GameConfig& loaded) {
+    stop();
+    path = filepath;
+    fileConfig = loaded;
+    stopping = false;
+    ready = false;
+
+#ifdef __linux__
+    // Watch the directory rather than the file, since saving by rename replaces the file's inode.
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    if (directory.empty()) directory = ".";
+    watchHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wakeHandle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (watchHandle < 0 || wakeHandle < 0 ||
+        inotify_add_watch(watchHandle, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        if (watchHandle >= 0) close(watchHandle);
+        if (wakeHandle >= 0) close(wakeHandle);
+        watchHandle = wakeHandle = -1;
+        consoleCapture.addLine("CONFIG: Cannot watch " + path);
+        return false;
+    }
+#else
+    std::error_code error;
+    if (!std::filesystem::exists(path, error)) {
+        consoleCapture.addLine("CONFIG: Cannot watch " + path);
+        return false;
+    }
+#endif
+
+    watcher = std::thread(&ConfigWatcher::watchLoop, this);
+    return true;
+}
+
+// Wakes the watcher thread and waits for it to finish.
+void ConfigWatcher::stop() {
+    if (!watcher.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+#ifdef __linux__
+    const uint64_t one = 1;
+    [[maybe_unused]] const ssize_t written = write(wakeHandle, &one, sizeof(one));
+#endif
+    wake.notify_all();
+    watcher.join();
+
+#ifdef __linux__
+    close(watchHandle);
+    close(wakeHandle);
+    watchHandle = wakeHandle = -1;
+#endif
+}
+
+// Hands the pending reload to the main thread.
+bool ConfigWatcher::poll(ConfigReload& reload) {
+    if (!ready.load(std::memory_order_acquire)) return false;
+    std::lock_guard<std::mutex> lock(mutex);
+    reload = pending;
+    ready.store(false, std::memory_order_relaxed);
+    return true;
+}
+
+// Waits for the file to change, then reparses it once it has been quiet for a moment, since
+// editors often write a file in several steps.
+void ConfigWatcher::watchLoop() {
+    const std::string name = std::filesystem::path(path).filename().string();
+    bool changed = false;
+
+#ifdef __linux__
+    alignas(inotify_event) char events[4096];
+    while (!stopping) {
+        pollfd handles[2] = {{watchHandle, POLLIN, 0}, {wakeHandle, POLLIN, 0}};
+        const int result = ::poll(handles, 2, changed ? CONFIG_WATCH_SETTLE_MS : -1);
+        if (result > 0 && (handles[0].revents & POLLIN)) {
+            ssize_t length;
+            while ((length = read(watchHandle, events, sizeof(events))) > 0) {
+                for (char* next = events; next < events + length;) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(next);
+                    if (event->len > 0 && name == event->name) changed = true;
+                    next += sizeof(inotify_event) + event->len;
+                }
+            }
+        } else if (result == 0 && changed) {
+            changed = false;
+            reload();
+        }
+    }
+#else
+    std::error_code error;
+    auto lastWrite = std::filesystem::last_write_time(path, error);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wake.wait_for(lock, std::chrono::milliseconds(changed ? CONFIG_WATCH_SETTLE_MS : CONFIG_WATCH_POLL_MS),
+                          [this] { return stopping.load(); })) {
+        const auto writeTime = std::filesystem::last_write_time(path, error);
+        if (!error && writeTime != lastWrite) {
+            lastWrite = writeTime;
+            changed = true;
+        } else if (changed) {
+            changed = false;
+            lock.unlock();
+            reload();
+            lock.lock();
+        }
+    }
+#endif
+}
+
+// Loads the file from scratch, so the result can be compared with the previous load.
+void ConfigWatcher::reload() {
+    if (!file.open(path)) return;   // A later change will retry.
+    GameConfig next;
+    next.loadFromConfig(file);
+    file.close();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // Reloads the main thread has not picked up yet are merged, keeping the oldest "before".
+    if (!ready.load(std::memory_order_relaxed)) {
+        pending.before = fileConfig;
+    }
+    pending.after = next;
+    fileConfig = next;
+    ready.store(true, std::memory_order_release);
+}
@@ -0,0 +1,68 @@
+#ifndef CONFIG_WATCHER_H
+#define CONFIG_WATCHER_H
+
+#include "ConfigParser.h"
+#include "GameConfig.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Constants for config watching.
+constexpr int CONFIG_WATCH_SETTLE_MS = 50;  // How long the file must stay quiet before it is reparsed.
+constexpr int CONFIG_WATCH_POLL_MS = 250;   // How often the file is checked where inotify is unavailable.
+
+// The ConfigReload struct is a reparsed config file, along with what the file held before the
+// change, so only the settings the edit touched are applied.
+struct ConfigReload {
+    GameConfig before;
+    GameConfig after;
+};
+
+// The ConfigWatcher class watches a config file and reparses it on a background thread whenever
+// it is saved. On Linux it waits on inotify for the file's directory, which also catches editors
+// that save by renaming a new file over the old one; elsewhere it polls the modification time.
+// The main thread picks up reloads with poll() at a frame boundary.
+class ConfigWatcher {
+public:
+    ConfigWatcher() = default;
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    // Starts watching a file. loaded is the config as last loaded from the file, before any
+    // other overrides. Returns false if the file cannot be watched.
+    bool start(const std::string& filepath, const GameConfig& loaded);
+    // Stops watching.
+    void stop();
+
+    // Takes the pending reload, if the file changed since the last call. Edits made between two
+    // calls are merged into one reload. Cheap when nothing changed.
+    bool poll(ConfigReload& reload);
+
+private:
+    // Runs on the watcher thread until stop().
+    void watchLoop();
+    // Reparses the file and queues the result for poll().
+    void reload();
+
+    std::string path;
+    std::thread watcher;
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> ready{false};  // Whether a reload is waiting for poll().
+    int watchHandle = -1;            // The inotify descriptor, on Linux.
+    int wakeHandle = -1;             // An eventfd that wakes the watcher for stop(), on Linux.
+
+    // Only the watcher thread touches these.
+    ConfigFile file;
+    GameConfig fileConfig;           // The config as the file last loaded.
+
+    // Shared with the main thread, guarded by mutex.
+    std::mutex mutex;
+    std::condition_variable wake;    // Wakes the polling fallback for stop().
+    ConfigReload pending;
+};
+
+#endif // CONFIG_WATCHER_H
@@ -1,36 +1,221 @@
 #include "ConsoleCapture.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 
 // Global console capture instance initialization.
 ConsoleCapture consoleCapture;
 
+namespace {
+    // How often the file sink wakes up to write new lines.
+    constexpr auto SINK_INTERVAL = std::chrono::milliseconds(50);
+
+    // The text appended to lines that are cut short.
+    constexpr std::string_view ELLIPSIS = "...";
+}
+
+// ConsoleCapture constructor. Allocates storage for every line up front.
+ConsoleCapture::ConsoleCapture() : slots(new Slot[CAPACITY]) {
+}
+
+// ConsoleCapture destructor. Flushes the log file, if there is one.
+ConsoleCapture::~ConsoleCapture() {
+    stopFileSink();
+}
+
 // Sets the maximum number of characters to display for each line in the console.
 void ConsoleCapture::setMaxDisplayChars(int maxChars) {
-    maxDisplayChars = maxChars;
+    maxDisplayChars.store(maxChars, std::memory_order_relaxed);
 }
 
-// Adds a line to the console, truncating it if it's too long.
-void ConsoleCapture::addLine(const std::string& line) {
-    // If the line is longer than the maximum displayable characters, truncate it.
-    if (line.length() > static_cast<size_t>(maxDisplayChars)) {
-        addTruncatedLine(line);
+// Adds a line to the console. Claims the next index, then writes the line into its slot.
+void ConsoleCapture::addLine(std::string_view line) {
+    const uint64_t index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots[index % CAPACITY];
+
+    // Take the slot unless a writer from a later lap already owns it, in which case this line
+    // would be overwritten immediately anyway.
+    uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    do {
+        if (sequence > 2 * index) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    } while (!slot.sequence.compare_exchange_weak(sequence, 2 * index + 1, std::memory_order_acquire,
+                                                  std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // Build the line on the stack, truncating it if it does not fit.
+    uint64_t words[LINE_WORDS] = {};
+    char* text = reinterpret_cast<char*>(words);
+    if (line.size() < LINE_BYTES) {
+        std::memcpy(text, line.data(), line.size());
     } else {
-        // Otherwise, add the line as is.
-        lines.emplace_back(line);
-    }
-    
-    // If the number of lines exceeds the maximum, remove the oldest line.
-    if (lines.size() > MAX_LINES) {
-        lines.pop_front();
-    }
-}
-
-// Helper function to add a truncated line to the console.
-void ConsoleCapture::addTruncatedLine(const std::string& line) {
-    // Reserve memory for the truncated string to avoid re-allocations.
-    std::string truncated;
-    truncated.reserve(maxDisplayChars);
-    // Truncate the line and add an ellipsis.
-    truncated = line.substr(0, maxDisplayChars - 3) + "...";
-    // Add the truncated line to the console.
-    lines.emplace_back(std::move(truncated));
-}
\ No newline at end of file
+        const size_t kept = LINE_BYTES - 1 - ELLIPSIS.size();
+        std::memcpy(text, line.data(), kept);
+        std::memcpy(text + kept, ELLIPSIS.data(), ELLIPSIS.size());
+    }
+    for (size_t i = 0; i < LINE_WORDS; ++i) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    // Publish the line, unless a later writer took the slot in the meantime.
+    uint64_t writing = 2 * index + 1;
+    slot.sequence.compare_exchange_strong(writing, committedSequence(index), std::memory_order_release,
+                                          std::memory_order_relaxed);
+}
+
+// Returns the number of lines that can be read back.
+size_t ConsoleCapture::lineCount() const {
+    return static_cast<size_t>(std::min<uint64_t>(nextIndex.load(std::memory_order_acquire), CAPACITY));
+}
+
+// Copies a line from the tail of the ring as stored.
+bool ConsoleCapture::fullTailLine(size_t back, LineBuffer& out) const {
+    const uint64_t newest = nextIndex.load(std::memory_order_acquire);
+    if (back >= std::min<uint64_t>(newest, CAPACITY)) return false;
+    return readSlot(newest - 1 - back, out);
+}
+
+// Copies a line from the tail of the ring, truncated to the display width.
+bool ConsoleCapture::tailLine(size_t back, LineBuffer& out) const {
+    if (!fullTailLine(back, out)) return false;
+
+    // Cut the line to fit the console, ending it with an ellipsis.
+    const size_t maxChars = static_cast<size_t>(std::max(static_cast<int>(ELLIPSIS.size()),
+                                                          maxDisplayChars.load(std::memory_order_relaxed)));
+    if (maxChars < LINE_BYTES - 1 && std::strlen(out.data()) > maxChars) {
+        std::memcpy(out.data() + maxChars - ELLIPSIS.size(), ELLIPSIS.data(), ELLIPSIS.size());
+        out[maxChars] = '\0';
+    }
+    return true;
+}
+
+// Copies the line with the given index out of its slot, checking that it was not written meanwhile.
+bool ConsoleCapture::readSlot(uint64_t index, LineBuffer& out) const {
+    const Slot& slot = slots[index % CAPACITY];
+    const uint64_t expected = committedSequence(index);
+    if (slot.sequence.load(std::memory_order_acquire) != expected) return false;
+
+    uint64_t words[LINE_WORDS];
+    for (size_t i = 0; i < LINE_WORDS; ++i) {
+        words[i] = slot.words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != expected) return false;
+
+    std::memcpy(out.data(), words, LINE_BYTES);
+    out[LINE_BYTES - 1] = '\0';
+    return true;
+}
+
+// Opens the log file and starts the sink thread. A log left by an earlier session is rotated
+// away first, the same as a full one, so its history is kept.
+bool ConsoleCapture::startFileSink(const std::string& path, size_t maxBytes, int keepFiles) {
+    stopFileSink();
+
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    logPath = path;
+    logMaxBytes = std::max<size_t>(maxBytes, LINE_BYTES);
+    logKeepFiles = std::max(0, keepFiles);
+    logFile = nullptr;
+    std::error_code error;
+    const auto existingBytes = std::filesystem::file_size(path, error);
+    if (!error && existingBytes > 0) {
+        rotateLogFile();
+    } else {
+        logFile = std::fopen(path.c_str(), "w");
+        logBytes = 0;
+    }
+    if (!logFile) return false;
+
+    // Start with the oldest line still in the ring.
+    const uint64_t newest = nextIndex.load(std::memory_order_acquire);
+    sinkIndex = newest > CAPACITY ? newest - CAPACITY : 0;
+
+    sinkRunning = true;
+    sinkThread = std::thread(&ConsoleCapture::sinkLoop, this);
+    return true;
+}
+
+// Stops the sink thread, which writes any remaining lines before it exits.
+void ConsoleCapture::stopFileSink() {
+    {
+        std::lock_guard<std::mutex> lock(sinkMutex);
+        if (!sinkRunning) return;
+        sinkRunning = false;
+    }
+    sinkWake.notify_one();
+    sinkThread.join();
+
+    if (logFile) std::fclose(logFile);
+    logFile = nullptr;
+}
+
+// Drains new lines to the log file at a fixed interval until stopped.
+void ConsoleCapture::sinkLoop() {
+    std::unique_lock<std::mutex> lock(sinkMutex);
+    while (sinkRunning) {
+        lock.unlock();
+        drainToFile();
+        if (logFile) std::fflush(logFile);
+        lock.lock();
+        sinkWake.wait_for(lock, SINK_INTERVAL, [this] { return !sinkRunning; });
+    }
+    lock.unlock();
+
+    // One last pass for lines added since the previous one. A line still being written is given up on.
+    drainToFile();
+    if (logFile) std::fflush(logFile);
+}
+
+// Writes every complete line past sinkIndex to the log file.
+bool ConsoleCapture::drainToFile() {
+    LineBuffer line;
+    const uint64_t newest = nextIndex.load(std::memory_order_acquire);
+    while (sinkIndex < newest) {
+        // Lines that have already been overwritten are lost; skip ahead to the oldest one left.
+        if (newest - sinkIndex > CAPACITY) {
+            dropped.fetch_add(newest - CAPACITY - sinkIndex, std::memory_order_relaxed);
+            sinkIndex = newest - CAPACITY;
+        }
+
+        if (!readSlot(sinkIndex, line)) {
+            const uint64_t sequence = slots[sinkIndex % CAPACITY].sequence.load(std::memory_order_acquire);
+            if (sequence < committedSequence(sinkIndex)) return false; // Still being written.
+            dropped.fetch_add(1, std::memory_order_relaxed);           // Overwritten by a later lap.
+            ++sinkIndex;
+            continue;
+        }
+
+        const size_t length = std::strlen(line.data());
+        if (logBytes + length + 1 > logMaxBytes) {
+            rotateLogFile();
+        }
+        if (logFile) {
+            std::fwrite(line.data(), 1, length, logFile);
+            std::fputc('\n', logFile);
+            logBytes += length + 1;
+        }
+        ++sinkIndex;
+    }
+    return true;
+}
+
+// Shifts path.N-1 to path.N, ..., path to path.1, and reopens an empty log file.
+void ConsoleCapture::rotateLogFile() {
+    if (logFile) std::fclose(logFile);
+
+    if (logKeepFiles > 0) {
+        std::remove((logPath + "." + std::to_string(logKeepFiles)).c_str());
+        for (int i = logKeepFiles - 1; i >= 1; --i) {
+            std::rename((logPath + "." + std::to_string(i)).c_str(),
+                        (logPath + "." + std::to_string(i + 1)).c_str());
+        }
+        std::rename(logPath.c_str(), (logPath + ".1").c_str());
+    }
+
+    logFile = std::fopen(logPath.c_str(), "w");
+    logBytes = 0;
+}
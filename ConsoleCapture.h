@@ -1,40 +1,104 @@
 #ifndef CONSOLE_CAPTURE_H
 #define CONSOLE_CAPTURE_H
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <deque>
+#include <string_view>
+#include <thread>
 
 // The ConsoleCapture class is responsible for capturing and managing console output lines.
-// It stores a limited number of lines and provides methods to add and retrieve them.
+// Lines go into a fixed-capacity ring with preallocated storage. Any thread may add lines
+// without locking or allocating; the oldest lines are overwritten once the ring is full.
+// A background file sink can drain the full history to a rotating log file.
 class ConsoleCapture {
-private:
-    // A deque to store the console lines.
-    std::deque<std::string> lines;
-    // The maximum number of lines to store.
-    static const int MAX_LINES = 15;
-    // The maximum number of characters to display per line.
-    int maxDisplayChars = 50;
-    
 public:
-    // Default constructor.
-    ConsoleCapture() = default;
-    
+    static constexpr size_t CAPACITY = 1024;  // The number of lines kept in memory (a power of two).
+    static constexpr size_t LINE_BYTES = 128; // The storage per line, including the terminator.
+
+    // A buffer large enough to hold any stored line.
+    using LineBuffer = std::array<char, LINE_BYTES>;
+
+    ConsoleCapture();
+    ~ConsoleCapture();
+
+    ConsoleCapture(const ConsoleCapture&) = delete;
+    ConsoleCapture& operator=(const ConsoleCapture&) = delete;
+
     // Sets the maximum number of displayable characters for each line.
     void setMaxDisplayChars(int maxChars);
-    // Adds a new line to the console.
-    // If the line is longer than maxDisplayChars, it will be truncated.
-    void addLine(const std::string& line);
-    // Returns a constant reference to the deque of lines.
-    const std::deque<std::string>& getLines() const { return lines; }
-    // Clears all lines from the console.
-    void clear() { lines.clear(); }
-    
+    // Adds a new line to the console. Lines longer than LINE_BYTES - 1 are truncated.
+    // Safe to call from any thread.
+    void addLine(std::string_view line);
+
+    // Returns a number that changes whenever a line is added, so views can tell when to redraw.
+    uint64_t version() const { return nextIndex.load(std::memory_order_acquire); }
+    // Returns the number of lines that can currently be read back, up to CAPACITY.
+    size_t lineCount() const;
+    // Copies the line `back` lines before the newest (0 is the newest) into out, truncated to
+    // the display width. Returns false if the line has been overwritten or is still being written.
+    bool tailLine(size_t back, LineBuffer& out) const;
+    // Like tailLine, but copies the line as stored, for output without a display width.
+    bool fullTailLine(size_t back, LineBuffer& out) const;
+    // Returns the number of lines the file sink lost because they were overwritten first.
+    uint64_t droppedLines() const { return dropped.load(std::memory_order_relaxed); }
+
+    // Starts a background thread that appends every line to a log file, rotating it once it
+    // exceeds maxBytes and keeping keepFiles old files (path.1 is the newest). A log from an
+    // earlier session is rotated the same way before the new one starts. Lines already in the
+    // ring are written first. Returns false if the file cannot be opened.
+    bool startFileSink(const std::string& path, size_t maxBytes, int keepFiles);
+    // Writes any remaining lines and stops the file sink.
+    void stopFileSink();
+
 private:
-    // A helper function to add a truncated line to the deque.
-    void addTruncatedLine(const std::string& line);
+    static constexpr size_t LINE_WORDS = LINE_BYTES / sizeof(uint64_t);
+
+    // The Slot struct holds one line. The sequence number is odd while the line is being written
+    // and even once it is complete, so readers can detect torn or overwritten lines.
+    // The text is stored as atomic words so that concurrent reads and writes are well defined.
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        std::array<std::atomic<uint64_t>, LINE_WORDS> words;
+    };
+
+    // Copies the line with the given index out of the ring. Returns false if it is not available.
+    bool readSlot(uint64_t index, LineBuffer& out) const;
+    // Returns the sequence number a slot holds once the line with the given index is complete.
+    static uint64_t committedSequence(uint64_t index) { return 2 * index + 2; }
+
+    // Runs on the sink thread, draining lines until the sink is stopped.
+    void sinkLoop();
+    // Writes all complete lines past sinkIndex to the log file. Returns false if it had to stop
+    // at a line that is still being written.
+    bool drainToFile();
+    // Renames the log file to path.1, shifting older files up, and starts a new one.
+    void rotateLogFile();
+
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> nextIndex{0};  // The index the next line will be written to.
+    std::atomic<int> maxDisplayChars{50};
+    std::atomic<uint64_t> dropped{0};
+
+    // File sink state. Only the sink thread touches the file; the mutex guards starting and stopping.
+    std::thread sinkThread;
+    std::mutex sinkMutex;
+    std::condition_variable sinkWake;
+    bool sinkRunning = false;
+    FILE* logFile = nullptr;
+    std::string logPath;
+    size_t logMaxBytes = 0;
+    int logKeepFiles = 0;
+    size_t logBytes = 0;
+    uint64_t sinkIndex = 0; // The index of the next line to write to the file.
 };
 
 // A global instance of the ConsoleCapture class that can be accessed from anywhere in the application.
 extern ConsoleCapture consoleCapture;
 
-#endif // CONSOLE_CAPTURE_H
\ No newline at end of file
+#endif // CONSOLE_CAPTURE_H
@@ -0,0 +1,111 @@
+#include "EntityStore.h"
+#include "PhysicsKernel.h"
+
+// EntityStore constructor.
+EntityStore::EntityStore(size_t initialCapacity) {
+    reserve(initialCapacity);
+}
+
+// Adds an entity, reusing a released slot when one is available.
+EntityHandle EntityStore::create(const EntityDesc& desc) {
+    // Grow in large steps, so crowds of entities do not reallocate every array one by one.
+    if (size() == posX.capacity()) {
+        reserve(std::max<size_t>(64, size() * 2));
+    }
+    
+    uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(generation.size());
+        generation.push_back(0);
+        denseIndex.push_back(0);
+    }
+    
+    denseIndex[slot] = static_cast<uint32_t>(size());
+    slotOf.push_back(slot);
+    posX.push_back(desc.x);
+    posY.push_back(desc.y);
+    prevX.push_back(desc.x);
+    prevY.push_back(desc.y);
+    velX.push_back(0.0f);
+    velY.push_back(0.0f);
+    speed.push_back(desc.speed);
+    baseSpeed.push_back(desc.speed);
+    maxSpeed.push_back(desc.maxSpeed);
+    baseMaxSpeed.push_back(desc.maxSpeed);
+    friction.push_back(desc.friction);
+    width.push_back(desc.width);
+    height.push_back(desc.height);
+    texture.push_back(desc.texture);
+    return {slot, generation[slot]};
+}
+
+// Removes an entity by moving the last entity into its place, keeping the arrays dense.
+void EntityStore::destroy(EntityHandle handle) {
+    if (!isAlive(handle)) return;
+    
+    const uint32_t index = denseIndex[handle.slot];
+    const uint32_t last = static_cast<uint32_t>(size() - 1);
+    const auto moveLast = [index, last](auto& column) {
+        column[index] = column[last];
+        column.pop_back();
+    };
+    moveLast(posX); moveLast(posY);
+    moveLast(prevX); moveLast(prevY);
+    moveLast(velX); moveLast(velY);
+    moveLast(speed); moveLast(baseSpeed);
+    moveLast(maxSpeed); moveLast(baseMaxSpeed);
+    moveLast(friction);
+    moveLast(width); moveLast(height);
+    moveLast(texture);
+    
+    const uint32_t movedSlot = slotOf[last];
+    slotOf[index] = movedSlot;
+    denseIndex[movedSlot] = index;
+    slotOf.pop_back();
+    
+    // Bump the generation, so outstanding handles to the old entity become stale.
+    ++generation[handle.slot];
+    freeSlots.push_back(handle.slot);
+}
+
+// Destroying from the end moves nothing, so the entities that stay keep their indices and handles.
+void EntityStore::resize(size_t count) {
+    const Texture2D firstTexture = size() > 0 ? texture[0] : Texture2D{};
+    while (size() < count) {
+        EntityDesc desc;
+        desc.texture = firstTexture;
+        create(desc);
+    }
+    while (size() > count) {
+        destroy(handleAt(size() - 1));
+    }
+}
+
+// Checks if the handle still refers to a live entity.
+bool EntityStore::isAlive(EntityHandle handle) const {
+    return handle.slot < generation.size() && generation[handle.slot] == handle.generation;
+}
+
+// Steps the motion of the entities in [first, last) with one linear pass over the arrays,
+// using the vectorized kernel the CPU supports.
+void EntityStore::integrateRange(size_t first, size_t last, float deltaTime, int screenWidth, int screenHeight) {
+    const MotionArrays arrays = {
+        posX.data(), posY.data(), prevX.data(), prevY.data(), velX.data(), velY.data(),
+        friction.data(), maxSpeed.data(), width.data(), height.data()
+    };
+    integrateMotionRange(arrays, first, last, deltaTime,
+                         static_cast<float>(screenWidth), static_cast<float>(screenHeight));
+}
+
+// Reserves room in every component array.
+void EntityStore::reserve(size_t capacity) {
+    for (auto* column : {&posX, &posY, &prevX, &prevY, &velX, &velY, &speed, &baseSpeed,
+                         &maxSpeed, &baseMaxSpeed, &friction, &width, &height}) {
+        column->reserve(capacity);
+    }
+    texture.reserve(capacity);
+    slotOf.reserve(capacity);
+}
@@ -0,0 +1,106 @@
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+
+#include "raylib.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The EntityHandle struct identifies an entity in an EntityStore.
+// The generation changes whenever a slot is reused, so stale handles are detected.
+struct EntityHandle {
+    uint32_t slot = UINT32_MAX;  // The entity's slot in the store's pool.
+    uint32_t generation = 0;     // The slot's generation when the handle was issued.
+    
+    bool operator==(const EntityHandle& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const EntityHandle& other) const { return !(*this == other); }
+};
+
+// The EntityDesc struct holds the initial values for a new entity.
+struct EntityDesc {
+    float x = 0.0f, y = 0.0f;   // The starting position.
+    float speed = 0.0f;         // The movement speed.
+    float friction = 0.0f;      // The friction applied to movement.
+    float maxSpeed = 0.0f;      // The maximum speed.
+    float width = 0.0f;         // The sprite width, used for screen clamping.
+    float height = 0.0f;        // The sprite height, used for screen clamping.
+    Texture2D texture{};        // The sprite texture.
+};
+
+// Clamps a value as min(max(value, lo), hi). Spelled out rather than std::clamp, so the result
+// is defined even when lo > hi and the vector kernels can reproduce it exactly.
+inline float clampMotion(float value, float lo, float hi) {
+    return std::min(std::max(value, lo), hi);
+}
+
+// Steps one entity's motion by deltaTime: friction, speed clamp, integration and screen clamp.
+// The SoA sweep and code that steps single PlayerState copies both use this, so they agree exactly.
+inline void integrateMotion(float& posX, float& posY, float& velX, float& velY, float friction,
+                            float maxSpeed, float maxX, float maxY, float deltaTime) {
+    const float frictionDelta = friction * deltaTime;
+    
+    // Apply friction to slow the entity down.
+    velX -= velX * frictionDelta;
+    velY -= velY * frictionDelta;
+    
+    // Clamp the velocity to the maximum speed.
+    velX = clampMotion(velX, -maxSpeed, maxSpeed);
+    velY = clampMotion(velY, -maxSpeed, maxSpeed);
+    
+    // Update the position based on the velocity, then keep it on screen.
+    posX = clampMotion(posX + velX * deltaTime, 0.0f, maxX);
+    posY = clampMotion(posY + velY * deltaTime, 0.0f, maxY);
+}
+
+// The EntityStore class keeps entity components in parallel, densely packed arrays (SoA).
+// Live entities always occupy indices [0, size()), so systems update them with a linear sweep.
+// Handles point at pooled slots that map to dense indices; destroying an entity moves the
+// last entity into its place and recycles the slot with a new generation.
+class EntityStore {
+public:
+    // Creates a store with room for the given number of entities before any reallocation.
+    explicit EntityStore(size_t initialCapacity = 256);
+    
+    // Adds an entity and returns its handle.
+    EntityHandle create(const EntityDesc& desc);
+    // Removes an entity. Stale or invalid handles are ignored.
+    void destroy(EntityHandle handle);
+    // Creates or destroys entities at the end of the dense arrays until count are live, for
+    // restoring a stored world. New entities are blank and take the first entity's texture.
+    void resize(size_t count);
+    // Checks if the handle still refers to a live entity.
+    bool isAlive(EntityHandle handle) const;
+    // Returns the dense index of a live entity.
+    size_t indexOf(EntityHandle handle) const { return denseIndex[handle.slot]; }
+    // Returns the handle of the entity at a dense index.
+    EntityHandle handleAt(size_t index) const { return {slotOf[index], generation[slotOf[index]]}; }
+    // Returns the number of live entities.
+    size_t size() const { return posX.size(); }
+    
+    // Steps the motion of every entity.
+    void integrate(float deltaTime, int screenWidth, int screenHeight) { integrateRange(0, size(), deltaTime, screenWidth, screenHeight); }
+    // Steps the motion of the entities in [first, last).
+    void integrateRange(size_t first, size_t last, float deltaTime, int screenWidth, int screenHeight);
+    
+    // Component arrays, all indexed by dense index.
+    std::vector<float> posX, posY;          // Positions.
+    std::vector<float> prevX, prevY;        // Positions at the previous tick, for render interpolation.
+    std::vector<float> velX, velY;          // Velocities.
+    std::vector<float> speed, baseSpeed;    // Current and base movement speed.
+    std::vector<float> maxSpeed, baseMaxSpeed; // Current and base maximum speed.
+    std::vector<float> friction;            // Friction.
+    std::vector<float> width, height;       // Sprite size.
+    std::vector<Texture2D> texture;         // Sprite texture (cold; only used when drawing).
+
+private:
+    // Reserves room in every component array.
+    void reserve(size_t capacity);
+    
+    std::vector<uint32_t> denseIndex;  // Slot -> dense index.
+    std::vector<uint32_t> generation;  // Slot -> current generation.
+    std::vector<uint32_t> slotOf;      // Dense index -> slot.
+    std::vector<uint32_t> freeSlots;   // Released slots, reused before the pool grows.
+};
+
+#endif // ENTITY_STORE_H
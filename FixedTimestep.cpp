@@ -0,0 +1,36 @@
+#include "FixedTimestep.h"
+#include <algorithm>
+
+// FixedTimestep constructor.
+// The tick rate and per-frame limits are clamped to sane minimums.
+FixedTimestep::FixedTimestep(int tickRate, float maxFrame, int maxTicks)
+    : tickDelta(1.0f / static_cast<float>(std::max(1, tickRate))),
+      maxFrameTime(std::max(maxFrame, tickDelta)),
+      maxTicksPerFrame(std::max(1, maxTicks)) {
+}
+
+// Accumulates the frame time and returns the number of whole ticks that are due.
+int FixedTimestep::advance(float frameTime) {
+    // Clamp long frames (breakpoints, window drags, hitches) so that a single
+    // slow frame never turns into a huge backlog of ticks.
+    accumulator += std::clamp(frameTime, 0.0f, maxFrameTime);
+    
+    int ticks = static_cast<int>(accumulator / tickDelta);
+    
+    // Spiral-of-death guard: if the simulation cannot keep up, drop the excess
+    // time instead of trying to catch up and falling further behind.
+    if (ticks > maxTicksPerFrame) {
+        droppedTicks += static_cast<unsigned long long>(ticks - maxTicksPerFrame);
+        ticks = maxTicksPerFrame;
+        accumulator = 0.0;
+        return ticks;
+    }
+    
+    accumulator -= static_cast<double>(ticks) * tickDelta;
+    return ticks;
+}
+
+// Returns the fraction of a tick that has elapsed since the last simulated tick.
+float FixedTimestep::interpolationAlpha() const {
+    return std::clamp(static_cast<float>(accumulator / tickDelta), 0.0f, 1.0f);
+}
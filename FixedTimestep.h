@@ -0,0 +1,24 @@
+#ifndef FIXED_TIMESTEP_H
+#define FIXED_TIMESTEP_H
+
+// The FixedTimestep struct drives the simulation at a constant tick rate,
+// independently of how fast frames are rendered.
+// Frame time is accumulated and consumed in whole ticks; the remainder is
+// exposed as an interpolation factor for rendering between the last two ticks.
+struct FixedTimestep {
+    float tickDelta;        // The duration of a single simulation tick, in seconds.
+    float maxFrameTime;     // The longest frame time that is fed into the accumulator.
+    int maxTicksPerFrame;   // The most ticks that may be simulated in a single frame.
+    double accumulator = 0.0; // The unsimulated time carried over between frames.
+    unsigned long long droppedTicks = 0; // The number of ticks discarded by the spiral-of-death guard.
+    
+    // FixedTimestep constructor.
+    FixedTimestep(int tickRate, float maxFrameTime, int maxTicksPerFrame);
+    
+    // Adds the given frame time to the accumulator and returns how many ticks to simulate.
+    int advance(float frameTime);
+    // Returns how far (0..1) the renderer is between the previous and the current tick.
+    float interpolationAlpha() const;
+};
+
+#endif // FIXED_TIMESTEP_H
@@ -0,0 +1,270 @@
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__SANITIZE_ADDRESS__)
+#define FRAME_ARENA_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define FRAME_ARENA_ASAN 1
+#endif
+#endif
+
+#ifdef FRAME_ARENA_ASAN
+#include <sanitizer/asan_interface.h>
+#define POISON_ARENA(address, size) ASAN_POISON_MEMORY_REGION(address, size)
+#define UNPOISON_ARENA(address, size) ASAN_UNPOISON_MEMORY_REGION(address, size)
+#else
+#define POISON_ARENA(address, size) ((void)(address), (void)(size))
+#define UNPOISON_ARENA(address, size) ((void)(address), (void)(size))
+#endif
+
+namespace {
+#ifdef DEBUG
+    // The byte freed memory is filled with in debug builds, so stale reads stand out.
+    constexpr unsigned char FREED_PATTERN = 0xdd;
+
+    // The number of calls to operator new made by each thread, and the main thread's count for
+    // the last frame, updated by reset().
+    thread_local uint64_t heapCalls = 0;
+    uint64_t heapCallsAtReset = 0;
+    uint64_t lastHeapCalls = 0;
+
+    // Reports a misuse of the arena and stops, since the memory involved can no longer be trusted.
+    [[noreturn]] void arenaMisuse(const char* message) {
+        std::fprintf(stderr, "FRAME ARENA: %s\n", message);
+        std::abort();
+    }
+
+    // The AllocationStamp struct sits just before every pmr allocation in debug builds and records
+    // the generation it was made in, so freeing it in a later frame is caught even when the
+    // address is inside memory handed out again since.
+    struct AllocationStamp {
+        uint64_t generation; // The arena's generation when the memory was allocated.
+        uint64_t check;      // The generation mixed with the address, to tell a stamp from stale bytes.
+    };
+
+    // The key mixed into a stamp's check.
+    constexpr uint64_t STAMP_KEY = 0x9e3779b97f4a7c15ull;
+
+    // Returns the check value of a stamp for an allocation.
+    uint64_t stampCheck(uint64_t generation, const void* pointer) {
+        return generation ^ STAMP_KEY ^ static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pointer));
+    }
+
+    // Returns the room reserved before an allocation for its stamp, keeping the allocation aligned.
+    size_t stampSpace(size_t alignment) {
+        return std::max(sizeof(AllocationStamp), alignment);
+    }
+#endif
+
+    // Rounds an address up to a power-of-two alignment.
+    uintptr_t alignUp(uintptr_t address, size_t alignment) {
+        return (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    }
+}
+
+#ifdef DEBUG
+// Debug builds count heap allocations, so frames that still use the heap can be found.
+void* operator new(size_t size) {
+    ++heapCalls;
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+#endif
+
+// Global frame arena instance initialization.
+FrameArena frameArena;
+
+// FrameArena implementation
+FrameArena::FrameArena(size_t capacity)
+    : block(static_cast<unsigned char*>(::operator new(capacity))), blockSize(capacity) {
+    POISON_ARENA(block, blockSize);
+}
+
+FrameArena::~FrameArena() {
+    freeOverflow();
+    UNPOISON_ARENA(block, blockSize);
+    ::operator delete(block);
+}
+
+// Bumps the offset past the allocation. Once the block is full, allocations come from the newest
+// heap block, and another is taken when that one is full too.
+void* FrameArena::bump(size_t bytes, size_t alignment) {
+    if (overflow == nullptr) {
+        const uintptr_t base = reinterpret_cast<uintptr_t>(block);
+        const size_t offset = static_cast<size_t>(alignUp(base + used, alignment) - base);
+        if (offset <= blockSize && bytes <= blockSize - offset) {
+            used = offset + bytes;
+            UNPOISON_ARENA(block + offset, bytes);
+            return block + offset;
+        }
+    } else {
+        unsigned char* data = reinterpret_cast<unsigned char*>(overflow + 1);
+        const uintptr_t base = reinterpret_cast<uintptr_t>(data);
+        const size_t offset = static_cast<size_t>(alignUp(base + overflow->used, alignment) - base);
+        if (offset <= overflow->size && bytes <= overflow->size - offset) {
+            overflowBytes += offset + bytes - overflow->used;
+            overflow->used = offset + bytes;
+            return data + offset;
+        }
+    }
+
+    // Room for the alignment padding is added, since the data may start at any address.
+    const size_t size = std::max(blockSize, bytes + alignment);
+    Overflow* chunk = static_cast<Overflow*>(::operator new(sizeof(Overflow) + size));
+    chunk->next = overflow;
+    chunk->size = size;
+    chunk->used = 0;
+    overflow = chunk;
+    return bump(bytes, alignment);
+}
+
+// Debug builds put a stamp of the current generation in front of the allocation.
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+#ifdef DEBUG
+    ++liveAllocations;
+    const size_t space = stampSpace(alignment);
+    unsigned char* pointer = static_cast<unsigned char*>(
+        bump(space + bytes, std::max(alignment, alignof(AllocationStamp)))) + space;
+    AllocationStamp* stamp = reinterpret_cast<AllocationStamp*>(pointer) - 1;
+    stamp->generation = resets;
+    stamp->check = stampCheck(resets, pointer);
+    return pointer;
+#else
+    return bump(bytes, alignment);
+#endif
+}
+
+// Individual frees are ignored; reset() frees everything. Debug builds check that the memory is
+// from the current frame: inside what was handed out, and stamped with the current generation.
+// The stamp is then spoiled, so a second free of the same memory is caught too.
+void FrameArena::do_deallocate([[maybe_unused]] void* pointer, size_t, size_t) {
+#ifdef DEBUG
+    if (!isLive(pointer)) arenaMisuse("memory from an earlier frame was freed after reset()");
+    AllocationStamp* stamp = static_cast<AllocationStamp*>(pointer) - 1;
+    if (stamp->generation != resets || stamp->check != stampCheck(resets, pointer)) {
+        arenaMisuse("memory from an earlier frame, or already freed, was freed again");
+    }
+    stamp->check = ~stamp->check;
+    --liveAllocations;
+#endif
+}
+
+std::string_view FrameArena::copy(std::string_view text) {
+    char* data = allocateArray<char>(text.size() + 1);
+    std::memcpy(data, text.data(), text.size());
+    data[text.size()] = '\0';
+    return {data, text.size()};
+}
+
+std::string_view FrameArena::concat(std::initializer_list<std::string_view> parts) {
+    size_t length = 0;
+    for (std::string_view part : parts) length += part.size();
+    char* data = allocateArray<char>(length + 1);
+    char* next = data;
+    for (std::string_view part : parts) {
+        std::memcpy(next, part.data(), part.size());
+        next += part.size();
+    }
+    *next = '\0';
+    return {data, length};
+}
+
+// Formats straight into the free part of the block, and only measures first when that is too small.
+std::string_view FrameArena::format(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list retryArgs;
+    va_copy(retryArgs, args);
+    int length = -1;
+    char* data = nullptr;
+    if (overflow == nullptr && used < blockSize) {
+        data = reinterpret_cast<char*>(block + used);
+        UNPOISON_ARENA(data, blockSize - used);
+        length = std::vsnprintf(data, blockSize - used, format, args);
+        if (length >= 0 && static_cast<size_t>(length) < blockSize - used) {
+            used += static_cast<size_t>(length) + 1;
+            POISON_ARENA(block + used, blockSize - used);
+        } else {
+            POISON_ARENA(data, blockSize - used);
+            data = nullptr;
+        }
+    } else {
+        length = std::vsnprintf(nullptr, 0, format, args);
+    }
+    if (data == nullptr && length >= 0) {
+        data = allocateArray<char>(static_cast<size_t>(length) + 1);
+        std::vsnprintf(data, static_cast<size_t>(length) + 1, format, retryArgs);
+    }
+    va_end(retryArgs);
+    va_end(args);
+    return length >= 0 ? std::string_view(data, static_cast<size_t>(length)) : std::string_view();
+}
+
+// Frees the frame's memory. If the frame overflowed, the block is replaced by one with room for
+// twice what the frame used, so the same work fits next time.
+void FrameArena::reset() {
+#ifdef DEBUG
+    if (liveAllocations != 0) arenaMisuse("a pmr allocation is still in use at reset()");
+    lastHeapCalls = heapCalls - heapCallsAtReset;
+    heapCallsAtReset = heapCalls;
+    UNPOISON_ARENA(block, used);
+    std::memset(block, FREED_PATTERN, used);
+#endif
+    lastFrameUsed = bytesUsed();
+    peakUsed = std::max(peakUsed, lastFrameUsed);
+    if (overflow != nullptr) {
+        ++overflowCount;
+        freeOverflow();
+        UNPOISON_ARENA(block, blockSize);
+        ::operator delete(block);
+        blockSize = std::max(blockSize, lastFrameUsed) * 2;
+        block = static_cast<unsigned char*>(::operator new(blockSize));
+    }
+    POISON_ARENA(block, blockSize);
+    used = 0;
+    overflowBytes = 0;
+    ++resets;
+}
+
+bool FrameArena::isLive(const void* pointer) const {
+    const auto* address = static_cast<const unsigned char*>(pointer);
+    if (address >= block && address < block + used) return true;
+    for (const Overflow* chunk = overflow; chunk != nullptr; chunk = chunk->next) {
+        const auto* data = reinterpret_cast<const unsigned char*>(chunk + 1);
+        if (address >= data && address < data + chunk->used) return true;
+    }
+    return false;
+}
+
+void FrameArena::freeOverflow() {
+    while (overflow != nullptr) {
+        Overflow* next = overflow->next;
+#ifdef DEBUG
+        std::memset(overflow + 1, FREED_PATTERN, overflow->used);
+#endif
+        ::operator delete(overflow);
+        overflow = next;
+    }
+}
+
+uint64_t FrameArena::lastFrameHeapCalls() {
+#ifdef DEBUG
+    return lastHeapCalls;
+#else
+    return 0;
+#endif
+}
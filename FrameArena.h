@@ -0,0 +1,104 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory_resource>
+#include <string_view>
+
+// Constants for the frame arena.
+constexpr size_t FRAME_ARENA_BYTES = 64 * 1024; // The arena's starting capacity. It grows to fit the busiest frame.
+
+// The FrameArena class hands out scratch memory that lives until the end of the current frame.
+// Allocating bumps an offset and reset() frees everything at once, so per-frame temporaries such
+// as console messages cost no calls to the general-purpose heap. A frame that needs more than
+// the capacity takes the rest from the heap, and the next reset() grows the arena to fit it, so
+// a steady-state frame never touches the heap.
+//
+// The arena is a std::pmr::memory_resource, so pmr containers can use it:
+//     std::pmr::vector<int> scratch(&frameArena);
+// Memory from the arena must not be used after reset(). Debug builds stamp every pmr allocation
+// with the generation it was made in and stop if one is still live at reset() or is freed in a
+// later frame. They also fill freed memory with a pattern, but a stale read or write is only
+// reported in ASan builds, which poison freed memory. The arena belongs to the main thread.
+class FrameArena : public std::pmr::memory_resource {
+public:
+    explicit FrameArena(size_t capacity = FRAME_ARENA_BYTES);
+    ~FrameArena() override;
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Returns an uninitialized array of count values. Destructors are never run.
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(bump(sizeof(T) * count, alignof(T)));
+    }
+    // Copies text into the arena. The copy is null-terminated.
+    std::string_view copy(std::string_view text);
+    // Joins pieces of text into the arena. The result is null-terminated.
+    std::string_view concat(std::initializer_list<std::string_view> parts);
+    // Formats text printf-style into the arena. The result is null-terminated.
+    std::string_view format(const char* format, ...)
+#if defined(__GNUC__)
+        __attribute__((format(printf, 2, 3)))
+#endif
+        ;
+
+    // Frees everything allocated this frame and records the frame's usage.
+    void reset();
+
+    // Returns whether a pointer is inside memory handed out this frame.
+    bool isLive(const void* pointer) const;
+    // Returns the bytes allocated so far this frame, including any taken from the heap.
+    size_t bytesUsed() const { return used + overflowBytes; }
+    // Returns the bytes the last frame used, as recorded by reset().
+    size_t lastFrameBytes() const { return lastFrameUsed; }
+    // Returns the most bytes any frame has used.
+    size_t peakBytes() const { return peakUsed; }
+    // Returns the size of the arena's block.
+    size_t capacity() const { return blockSize; }
+    // Returns the number of frames that outgrew the block and needed the heap.
+    uint64_t overflowFrames() const { return overflowCount; }
+    // Returns the number of resets so far. Memory from an earlier generation is gone.
+    uint64_t generation() const { return resets; }
+
+    // Returns the number of calls the main thread made to the global operator new during the
+    // last frame. Only counted in debug builds; always 0 otherwise.
+    static uint64_t lastFrameHeapCalls();
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+    // The Overflow struct heads a heap block taken when the arena is full. Its data follows it.
+    struct Overflow {
+        Overflow* next;   // The heap block taken before this one.
+        size_t size;      // The bytes of data.
+        size_t used;      // The bytes of data handed out.
+    };
+
+    // Returns aligned memory from the block, or from a new heap block if the block is full.
+    void* bump(size_t bytes, size_t alignment);
+    // Frees the heap blocks taken this frame.
+    void freeOverflow();
+
+    unsigned char* block = nullptr;
+    size_t blockSize = 0;
+    size_t used = 0;                 // The bytes of the block handed out this frame.
+    Overflow* overflow = nullptr;    // The heap blocks taken this frame, newest first.
+    size_t overflowBytes = 0;        // The bytes handed out from heap blocks this frame.
+    size_t lastFrameUsed = 0;
+    size_t peakUsed = 0;
+    uint64_t overflowCount = 0;
+    uint64_t resets = 0;
+    size_t liveAllocations = 0;      // The pmr allocations not yet freed, counted in debug builds.
+};
+
+// A global instance of the FrameArena class, reset at the end of every frame.
+extern FrameArena frameArena;
+
+#endif // FRAME_ARENA_H
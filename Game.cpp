@@ -0,0 +1,109 @@
+#include "Game.h"
+#include "ConsoleCapture.h"
+#include "Profiler.h"
+
+// Creates the player entity in the store, positioning it in the center of the screen.
+Player createPlayer(EntityStore& store, const GameConfig& config, Texture2D texture) {
+    const float startX = static_cast<float>(config.screenWidth) / 2.0f - 
+                        static_cast<float>(texture.width) / 2.0f;
+    const float startY = static_cast<float>(config.screenHeight) / 2.0f - 
+                        static_cast<float>(texture.height) / 2.0f;
+    
+    return Player(store, startX, startY, config.playerSpeed, 
+                 config.friction, config.maxSpeed, texture);
+}
+
+// Registers the config as console variables, and keeps the player and console in step with them.
+void bindGameCVars(CVarRegistry& cvars, GameConfig& config, Player player) {
+    config.registerCVars(cvars);
+    
+    const auto retunePlayer = [&config, player](const CVar&) mutable {
+        player.retune(config.playerSpeed, config.friction, config.maxSpeed);
+    };
+    cvars.onChange("player_speed", retunePlayer);
+    cvars.onChange("player_friction", retunePlayer);
+    cvars.onChange("player_max_speed", retunePlayer);
+    
+    // The speed multiplier is only set from the console, so it is not in the config schema.
+    cvars.addFloat("speed", config.speedMultiplier, 0.0f, 100.0f);
+    cvars.markSimulation("speed");
+    cvars.onChange("speed", [&config, player](const CVar&) mutable {
+        player.setSpeed(player.baseSpeed() * config.speedMultiplier, player.baseMaxSpeed() * config.speedMultiplier);
+    });
+    
+    const auto resizeConsoleLines = [&config](const CVar&) {
+        consoleCapture.setMaxDisplayChars(config.calculateMaxDisplayChars());
+    };
+    cvars.onChange("console_font_size", resizeConsoleLines);
+    cvars.onChange("console_width", resizeConsoleLines);
+    cvars.onChange("show_profiler", [&config](const CVar&) { profiler.overlayVisible = config.showProfiler; });
+}
+
+// Advances the game by one fixed simulation tick, handling all input and game logic.
+void updateGame(Player& player, GameState& gameState, const GameConfig& config, const InputSnapshot& input,
+                float tickDelta, CommandParser& commandParser, ConsoleInput& consoleInput, RewindBuffer& rewindBuffer) {
+    // Resume any console script waiting for this tick.
+    commandParser.update(player);
+
+    // Handle input based on the current game state.
+    if (gameState.isOnTitleScreen()) {
+        gameState.handleTitleInput(input);
+        player.holdPosition();
+        return;
+    }
+    
+    // Toggle console input with ALT+C.
+    if (gameState.consoleVisible && input.isPressed(InputAction::TOGGLE_CONSOLE_INPUT)) {
+        consoleInput.active = !consoleInput.active;
+    }
+
+    // If console input is active, process text input.
+    if (consoleInput.active) {
+        if (input.typedChar != 0) {
+            consoleInput.text.insert(consoleInput.cursorPosition, 1, static_cast<char>(input.typedChar));
+            consoleInput.cursorPosition++;
+        }
+
+        // Handle backspace for deleting characters.
+        if (input.isPressed(InputAction::BACKSPACE)) {
+            if (consoleInput.cursorPosition > 0) {
+                consoleInput.text.erase(consoleInput.cursorPosition - 1, 1);
+                consoleInput.cursorPosition--;
+            }
+        }
+
+        // Handle TAB to complete the name being typed.
+        if (input.isPressed(InputAction::COMPLETE)) {
+            consoleInput.text = commandParser.complete(consoleInput.text);
+            consoleInput.cursorPosition = static_cast<int>(consoleInput.text.size());
+        }
+
+        // Handle ENTER to execute the command.
+        if (input.isPressed(InputAction::SUBMIT)) {
+            commandParser.parseAndExecute(consoleInput.text, player);
+            consoleInput.text.clear();
+            consoleInput.cursorPosition = 0;
+        }
+    } else {
+        // Otherwise, handle normal game input.
+        gameState.handleGameInput(input, config.consoleEnabled);
+    }
+
+    // Update the player only when the game is in the PLAYING state.
+    // While REWIND is held, step back one recorded tick instead of simulating forward.
+    gameState.rewinding = gameState.isInGame() && !consoleInput.active && input.isDown(InputAction::REWIND);
+    if (gameState.rewinding) {
+        PlayerState state;
+        if (rewindBuffer.rewind(state)) {
+            player.restoreState(state);
+        } else {
+            player.holdPosition();
+        }
+    } else if (gameState.isInGame()) {
+        player.update(tickDelta, config.screenWidth, config.screenHeight, input, consoleInput.active);
+        rewindBuffer.record(player.captureState());
+    } else {
+        // Keep the interpolation endpoints together so a frozen player does not jitter.
+        player.holdPosition();
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include "raylib.h"
+#include "Player.h"
+#include "GameState.h"
+#include "GameConfig.h"
+#include "Commands.h"
+#include "UIRenderer.h"
+#include "Input.h"
+#include "RewindBuffer.h"
+
+// Creates the player entity in the store, positioning it in the center of the screen.
+Player createPlayer(EntityStore& store, const GameConfig& config, Texture2D texture);
+
+// Registers the config fields as console variables, with callbacks that retune the player and
+// resize the console lines when the matching variables change, and the "speed" variable that
+// scales the player's speeds. The config and the player's entity must outlive the registry.
+void bindGameCVars(CVarRegistry& cvars, GameConfig& config, Player player);
+
+// Advances the game by one fixed simulation tick, handling all input and game logic.
+// The result depends only on the current state and the tick's input snapshot, so replaying
+// the same snapshots reproduces a run exactly. This never touches the window, so it is
+// shared by the windowed and headless runs.
+void updateGame(Player& player, GameState& gameState, const GameConfig& config, const InputSnapshot& input,
+                float tickDelta, CommandParser& commandParser, ConsoleInput& consoleInput, RewindBuffer& rewindBuffer);
+
+#endif // GAME_H
@@ -1,25 +1,292 @@
 #include "GameConfig.h"
-#include <stdexcept>
-
-// Loads the game configuration from a given map of key-value pairs.
-void GameConfig::loadFromConfig(const std::unordered_map<std::string, std::string>& config) {
-    // Set various configuration values using a helper function.
-    setConfigValue(config, "window_width", screenWidth);
-    setConfigValue(config, "window_height", screenHeight);
-    setConfigValue(config, "player_speed", playerSpeed);
-    setConfigValue(config, "player_friction", friction);
-    setConfigValue(config, "player_max_speed", maxSpeed);
-    setConfigValue(config, "console_font_size", consoleFontSize);
-    setConfigValue(config, "console_width", consoleWidth);
-    setConfigValue(config, "console_height", consoleHeight);
-    
-    // Handle boolean configuration values separately.
-    setBoolConfig(config, "show_fps", showFPS);
-    setBoolConfig(config, "show_console", consoleEnabled);
-    
-    // Handle string configuration values.
-    if (auto it = config.find("player_sprite"); it != config.end()) {
-        spritePath = it->second;
+#include "ConfigParser.h"
+#include "CVarRegistry.h"
+#include "ConsoleCapture.h"
+#include "PerfectHash.h"
+#include "Rollback.h"
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+namespace {
+    // The type of value a config key holds.
+    enum class FieldType : uint8_t { INT, FLOAT, BOOL, STRING };
+
+    // The ConfigField struct binds one INI key to a GameConfig member.
+    // Keys are unique across sections, so a file without section headers still loads.
+    struct ConfigField {
+        std::string_view key;
+        std::string_view section;
+        FieldType type = FieldType::INT;
+        int GameConfig::* intMember = nullptr;
+        float GameConfig::* floatMember = nullptr;
+        bool GameConfig::* boolMember = nullptr;
+        std::string GameConfig::* stringMember = nullptr;
+        double minValue = 0.0;   // The inclusive range for numeric fields.
+        double maxValue = 0.0;
+        bool needsRestart = false; // Whether the game only reads the field at startup.
+        bool simulation = false;   // Whether replays depend on the field.
+    };
+
+    constexpr ConfigField intField(std::string_view section, std::string_view key, int GameConfig::* member,
+                                   int minValue, int maxValue) {
+        ConfigField field;
+        field.key = key;
+        field.section = section;
+        field.type = FieldType::INT;
+        field.intMember = member;
+        field.minValue = minValue;
+        field.maxValue = maxValue;
+        return field;
+    }
+
+    constexpr ConfigField floatField(std::string_view section, std::string_view key, float GameConfig::* member,
+                                     double minValue, double maxValue) {
+        ConfigField field;
+        field.key = key;
+        field.section = section;
+        field.type = FieldType::FLOAT;
+        field.floatMember = member;
+        field.minValue = minValue;
+        field.maxValue = maxValue;
+        return field;
+    }
+
+    constexpr ConfigField boolField(std::string_view section, std::string_view key, bool GameConfig::* member) {
+        ConfigField field;
+        field.key = key;
+        field.section = section;
+        field.type = FieldType::BOOL;
+        field.boolMember = member;
+        return field;
+    }
+
+    constexpr ConfigField stringField(std::string_view section, std::string_view key,
+                                      std::string GameConfig::* member) {
+        ConfigField field;
+        field.key = key;
+        field.section = section;
+        field.type = FieldType::STRING;
+        field.stringMember = member;
+        return field;
+    }
+
+    // Marks a field that is only read at startup, so changing it in a running game has no effect.
+    constexpr ConfigField restartRequired(ConfigField field) {
+        field.needsRestart = true;
+        return field;
+    }
+
+    // Marks a field that replays depend on, so it is held while recording or replaying.
+    constexpr ConfigField simulationSetting(ConfigField field) {
+        field.simulation = true;
+        return field;
+    }
+
+    // The schema for every configurable field.
+    constexpr ConfigField CONFIG_SCHEMA[] = {
+        restartRequired(stringField("save", "archive_path", &GameConfig::archivePath)),
+        stringField("save", "autosave_path", &GameConfig::autosavePath),
+        intField("save", "autosave_seconds", &GameConfig::autosaveSeconds, 0, 86400),
+        intField("console", "console_font_size", &GameConfig::consoleFontSize, 6, 200),
+        intField("console", "console_height", &GameConfig::consoleHeight, 50, 16384),
+        intField("console", "console_width", &GameConfig::consoleWidth, 50, 16384),
+        restartRequired(stringField("log", "log_file", &GameConfig::logFile)),
+        restartRequired(intField("log", "log_files", &GameConfig::logFiles, 0, 100)),
+        restartRequired(intField("log", "log_max_kb", &GameConfig::logMaxKB, 1, 1048576)),
+        floatField("simulation", "max_frame_time", &GameConfig::maxFrameTime, 0.001, 10.0),
+        intField("simulation", "max_ticks_per_frame", &GameConfig::maxTicksPerFrame, 1, 100),
+        restartRequired(intField("net", "net_input_delay", &GameConfig::netInputDelay, 0, NET_MAX_INPUT_DELAY)),
+        restartRequired(intField("net", "net_port", &GameConfig::netPort, 1024, 65534)),
+        restartRequired(intField("net", "net_rollback_ticks", &GameConfig::netRollbackTicks, 1, ROLLBACK_MAX_WINDOW)),
+        simulationSetting(floatField("player", "player_friction", &GameConfig::friction, 0.0, 1000.0)),
+        simulationSetting(floatField("player", "player_max_speed", &GameConfig::maxSpeed, 0.0, 100000.0)),
+        simulationSetting(floatField("player", "player_speed", &GameConfig::playerSpeed, 0.0, 100000.0)),
+        restartRequired(stringField("player", "player_sprite", &GameConfig::spritePath)),
+        restartRequired(intField("rewind", "rewind_keyframe_interval", &GameConfig::rewindKeyframeInterval, 1, 10000)),
+        restartRequired(intField("rewind", "rewind_memory_kb", &GameConfig::rewindMemoryKB, 1, 1048576)),
+        simulationSetting(boolField("display", "show_console", &GameConfig::consoleEnabled)),
+        boolField("display", "show_fps", &GameConfig::showFPS),
+        boolField("display", "show_profiler", &GameConfig::showProfiler),
+        intField("simulation", "target_fps", &GameConfig::targetFPS, 0, 1000),
+        simulationSetting(intField("simulation", "tick_rate", &GameConfig::tickRate, 1, 1000)),
+        restartRequired(boolField("display", "watch_config", &GameConfig::watchConfig)),
+        simulationSetting(intField("window", "window_height", &GameConfig::screenHeight, 1, 16384)),
+        simulationSetting(intField("window", "window_width", &GameConfig::screenWidth, 1, 16384)),
+        restartRequired(intField("simulation", "worker_threads", &GameConfig::workerThreads, 0, 256)),
+    };
+    constexpr size_t CONFIG_FIELD_COUNT = std::size(CONFIG_SCHEMA);
+
+    // Collects the schema's keys for hashing.
+    constexpr std::array<std::string_view, CONFIG_FIELD_COUNT> schemaKeys() {
+        std::array<std::string_view, CONFIG_FIELD_COUNT> keys{};
+        for (size_t i = 0; i < CONFIG_FIELD_COUNT; ++i) {
+            keys[i] = CONFIG_SCHEMA[i].key;
+        }
+        return keys;
+    }
+
+    // Maps each key to its schema field, built at compile time.
+    constexpr PerfectHash<64> CONFIG_KEY_HASH = PerfectHash<64>::build(schemaKeys());
+    static_assert(CONFIG_KEY_HASH.valid, "CONFIG_SCHEMA keys must be unique; grow the table if they collide");
+
+    // Finds the schema field for a key, or returns nullptr for an unknown key.
+    const ConfigField* findField(std::string_view key) {
+        const int index = CONFIG_KEY_HASH.find(key);
+        return index >= 0 && CONFIG_SCHEMA[index].key == key ? &CONFIG_SCHEMA[index] : nullptr;
+    }
+
+    // Reports a problem with one entry. Only called on errors, so allocating here is fine.
+    void reportEntry(const ConfigFile& file, const ConfigEntry& entry, const std::string& message) {
+        consoleCapture.addLine("CONFIG: " + file.path() + ":" + std::to_string(entry.line) + ": " +
+                               std::string(entry.key) + " " + message);
+    }
+
+    // Converts and range checks an entry's value and stores it in the bound member.
+    // Returns false, leaving the member unchanged, if the value is invalid.
+    bool applyField(GameConfig& config, const ConfigField& field, const ConfigFile& file, const ConfigEntry& entry) {
+        switch (field.type) {
+            case FieldType::INT: {
+                int value = 0;
+                if (!parseConfigInt(entry.value, value)) {
+                    reportEntry(file, entry, "expects a whole number, got \"" + std::string(entry.value) + "\"");
+                    return false;
+                }
+                if (value < field.minValue || value > field.maxValue) {
+                    reportEntry(file, entry, "must be between " + formatConfigNumber(field.minValue) + " and " +
+                                             formatConfigNumber(field.maxValue) + ", got " + std::string(entry.value));
+                    return false;
+                }
+                config.*field.intMember = value;
+                return true;
+            }
+            case FieldType::FLOAT: {
+                float value = 0.0f;
+                if (!parseConfigFloat(entry.value, value)) {
+                    reportEntry(file, entry, "expects a number, got \"" + std::string(entry.value) + "\"");
+                    return false;
+                }
+                if (value < field.minValue || value > field.maxValue) {
+                    reportEntry(file, entry, "must be between " + formatConfigNumber(field.minValue) + " and " +
+                                             formatConfigNumber(field.maxValue) + ", got " + std::string(entry.value));
+                    return false;
+                }
+                config.*field.floatMember = value;
+                return true;
+            }
+            case FieldType::BOOL: {
+                bool value = false;
+                if (!parseConfigBool(entry.value, value)) {
+                    reportEntry(file, entry, "expects true or false, got \"" + std::string(entry.value) + "\"");
+                    return false;
+                }
+                config.*field.boolMember = value;
+                return true;
+            }
+            case FieldType::STRING:
+                (config.*field.stringMember).assign(entry.value.data(), entry.value.size());
+                return true;
+        }
+        return false;
+    }
+}
+
+// Loads the game configuration from a parsed INI file, one schema lookup per entry.
+int GameConfig::loadFromConfig(const ConfigFile& file) {
+    int problems = 0;
+    std::bitset<CONFIG_FIELD_COUNT> seen;
+
+    for (const ConfigEntry& entry : file.entries()) {
+        const ConfigField* field = findField(entry.key);
+        if (field == nullptr) {
+            reportEntry(file, entry, "is not a known setting");
+            ++problems;
+            continue;
+        }
+        // Keys outside any section are accepted, so older flat files keep working.
+        if (!entry.section.empty() && entry.section != field->section) {
+            reportEntry(file, entry, "belongs in [" + std::string(field->section) + "], not [" +
+                                     std::string(entry.section) + "]");
+            ++problems;
+            continue;
+        }
+
+        const size_t index = static_cast<size_t>(field - CONFIG_SCHEMA);
+        if (seen.test(index)) {
+            reportEntry(file, entry, "is set more than once, the last value wins");
+            ++problems;
+        }
+        seen.set(index);
+
+        if (!applyField(*this, *field, file, entry)) {
+            ++problems;
+        }
+    }
+    return problems;
+}
+
+// Copies the fields that differ between two loads of the file and reports each one.
+int GameConfig::applyChanges(const GameConfig& before, const GameConfig& after, const CVarRegistry* registry) {
+    int changed = 0;
+    for (const ConfigField& field : CONFIG_SCHEMA) {
+        std::string value;
+        switch (field.type) {
+            case FieldType::INT:
+                if (before.*field.intMember == after.*field.intMember) continue;
+                this->*field.intMember = after.*field.intMember;
+                value = std::to_string(after.*field.intMember);
+                break;
+            case FieldType::FLOAT:
+                if (before.*field.floatMember == after.*field.floatMember) continue;
+                this->*field.floatMember = after.*field.floatMember;
+                value = formatConfigNumber(after.*field.floatMember);
+                break;
+            case FieldType::BOOL:
+                if (before.*field.boolMember == after.*field.boolMember) continue;
+                this->*field.boolMember = after.*field.boolMember;
+                value = after.*field.boolMember ? "true" : "false";
+                break;
+            case FieldType::STRING:
+                if (before.*field.stringMember == after.*field.stringMember) continue;
+                this->*field.stringMember = after.*field.stringMember;
+                value = "\"" + after.*field.stringMember + "\"";
+                break;
+        }
+        consoleCapture.addLine("CONFIG: " + std::string(field.key) + " = " + value +
+                               (field.needsRestart ? " (after a restart)" : ""));
+        if (registry != nullptr) {
+            registry->notifyChanged(field.key);
+        }
+        ++changed;
+    }
+    return changed;
+}
+
+// Binds each schema field to a console variable.
+void GameConfig::registerCVars(CVarRegistry& registry) {
+    for (const ConfigField& field : CONFIG_SCHEMA) {
+        switch (field.type) {
+            case FieldType::INT:
+                registry.addInt(field.key, this->*field.intMember, static_cast<int>(field.minValue),
+                                static_cast<int>(field.maxValue), field.needsRestart);
+                break;
+            case FieldType::FLOAT:
+                registry.addFloat(field.key, this->*field.floatMember, static_cast<float>(field.minValue),
+                                  static_cast<float>(field.maxValue), field.needsRestart);
+                break;
+            case FieldType::BOOL:
+                registry.addBool(field.key, this->*field.boolMember, field.needsRestart);
+                break;
+            case FieldType::STRING:
+                registry.addString(field.key, this->*field.stringMember, field.needsRestart);
+                break;
+        }
+        if (field.simulation) {
+            registry.markSimulation(field.key);
+        }
     }
 }
 
@@ -29,37 +296,7 @@ int GameConfig::calculateMaxDisplayChars() const {
     const int estimatedCharWidth = static_cast<int>(consoleFontSize * charWidthRatio);
     const int padding = consoleFontSize / 2;
     const int usableWidth = consoleWidth - (padding * 2);
-    
+
     // Ensure that at least one character can be displayed.
     return std::max(1, usableWidth / estimatedCharWidth);
 }
-
-// Template function to set a configuration value of a given type.
-// This avoids code duplication for different numeric types.
-template<typename T>
-void GameConfig::setConfigValue(const std::unordered_map<std::string, std::string>& config,
-                               const std::string& key, T& target) {
-    if (auto it = config.find(key); it != config.end()) {
-        try {
-            // Use `if constexpr` to handle different types at compile time.
-            if constexpr (std::is_same_v<T, int>) {
-                target = std::stoi(it->second);
-            } else if constexpr (std::is_same_v<T, float>) {
-                target = std::stof(it->second);
-            }
-        } catch (const std::exception&) {
-            // Silently ignore invalid values and keep the default.
-            // A log message could be added here for debugging purposes.
-        }
-    }
-}
-
-// Sets a boolean configuration value based on a string representation.
-void GameConfig::setBoolConfig(const std::unordered_map<std::string, std::string>& config,
-                              const std::string& key, bool& target) {
-    if (auto it = config.find(key); it != config.end()) {
-        const std::string& value = it->second;
-        // Treat "true", "1", and "yes" as true, and anything else as false.
-        target = (value == "true" || value == "1" || value == "yes");
-    }
-}
\ No newline at end of file
@@ -2,7 +2,9 @@
 #define GAME_CONFIG_H
 
 #include <string>
-#include <unordered_map>
+
+class ConfigFile;
+class CVarRegistry;
 
 // The GameConfig struct holds all the configuration settings for the game.
 // It provides default values and can be loaded from a configuration file.
@@ -16,31 +18,60 @@ struct GameConfig {
     float friction = 10.0f;         // The friction applied to the player's movement.
     float maxSpeed = 200.0f;        // The maximum speed the player can reach.
     std::string spritePath = "resources/test/testsprite.png"; // The path to the player's sprite.
+    float speedMultiplier = 1.0f;   // The multiplier on the player's speeds, set by the "speed" console variable.
+    
+    // Simulation settings
+    int tickRate = 60;              // The number of fixed simulation ticks per second.
+    int maxTicksPerFrame = 5;       // The most ticks simulated in one frame before time is dropped.
+    float maxFrameTime = 0.25f;     // The longest frame time (in seconds) fed into the simulation.
+    int targetFPS = 60;             // The render frame rate cap (0 for uncapped).
+    int workerThreads = 0;          // The number of simulation threads (0 for one per core).
+    
+    // Rewind settings
+    int rewindMemoryKB = 1024;      // The hard memory cap for the rewind history, in kilobytes.
+    int rewindKeyframeInterval = 30; // The number of ticks between full rewind keyframes.
+    
+    // Network settings
+    int netPort = 7777;             // The UDP port of player 0 in a netplay session; player 1 uses the next one.
+    int netInputDelay = 2;          // The ticks local input is held back in a netplay session, to hide latency.
+    int netRollbackTicks = 8;       // The most ticks the remote input may be predicted before the session stalls.
+    
+    // Save settings
+    int autosaveSeconds = 30;       // The seconds of play between autosaves (0 to disable).
+    std::string autosavePath = "autosave.sav"; // The file the game is autosaved to, and saved to on exit.
+    std::string archivePath = "timeexe.tla"; // The file every tick of the session is archived to, for scrubbing (empty to disable).
+    
+    // Log settings
+    std::string logFile = "timeexe.log"; // The file console output is written to (empty to disable).
+    int logMaxKB = 1024;            // The size at which the log file is rotated, in kilobytes.
+    int logFiles = 3;               // The number of rotated log files kept.
     
     // Debug/Display settings
     bool showFPS = false;           // Whether to display the FPS counter.
+    bool showProfiler = false;      // Whether to display the frame profiler overlay.
     bool consoleEnabled = false;    // Whether the developer console is enabled.
+    bool watchConfig = true;        // Whether edits to the config file are applied while the game runs.
     
     // Console settings
     int consoleFontSize = 14;       // The font size used in the console.
     int consoleWidth = 450;         // The width of the console window.
     int consoleHeight = 280;        // The height of the console window.
     
-    // Loads the configuration from a map of key-value pairs.
-    void loadFromConfig(const std::unordered_map<std::string, std::string>& config);
+    // Loads the configuration from a parsed INI file. Unknown keys, values that do not parse or
+    // are out of range, and keys in the wrong section are reported to the console one by one,
+    // and the affected fields keep their current values. Returns the number of entries reported.
+    int loadFromConfig(const ConfigFile& file);
+    // Copies every field that differs between two loads of the config file into this config, and
+    // reports each change to the console. Fields the file did not change keep their current
+    // values, even if they were overridden since. If a registry is given, the change callbacks
+    // of each copied field run. Returns the number of fields copied.
+    int applyChanges(const GameConfig& before, const GameConfig& after, const CVarRegistry* registry = nullptr);
+    // Registers every field as a console variable named after its config key, with the same
+    // range. Fields only read at startup are read-only.
+    void registerCVars(CVarRegistry& registry);
     
     // Calculates the maximum number of characters that can be displayed in a single console line.
     int calculateMaxDisplayChars() const;
-
-private:
-    // A template helper function to set a configuration value of a given type.
-    template<typename T>
-    void setConfigValue(const std::unordered_map<std::string, std::string>& config, 
-                       const std::string& key, T& target);
-    
-    // A helper function to set a boolean configuration value.
-    void setBoolConfig(const std::unordered_map<std::string, std::string>& config,
-                      const std::string& key, bool& target);
 };
 
-#endif // GAME_CONFIG_H
\ No newline at end of file
+#endif // GAME_CONFIG_H
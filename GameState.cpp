@@ -1,28 +1,27 @@
 #include "GameState.h"
-#include "raylib.h"
 
 // Handles input when the game is on the title screen.
-void GameState::handleTitleInput() {
+void GameState::handleTitleInput(const InputSnapshot& input) {
     // Pressing SPACE starts the game.
-    if (IsKeyPressed(KEY_SPACE)) {
+    if (input.isPressed(InputAction::START)) {
         setState(GameStateType::PLAYING);
     }
     
     // Pressing ESCAPE quits the game.
-    if (IsKeyPressed(KEY_ESCAPE)) {
+    if (input.isPressed(InputAction::BACK)) {
         shouldQuit = true;
     }
 }
 
 // Handles input during the main game loop (playing and paused states).
-void GameState::handleGameInput(bool consoleEnabled) {
+void GameState::handleGameInput(const InputSnapshot& input, bool consoleEnabled) {
     // Toggle the console visibility with the GRAVE key if the console is enabled.
-    if (consoleEnabled && IsKeyPressed(KEY_GRAVE)) {
+    if (consoleEnabled && input.isPressed(InputAction::TOGGLE_CONSOLE)) {
         consoleVisible = !consoleVisible;
     }
     
     // Toggle between playing and paused states with the ESCAPE key.
-    if (IsKeyPressed(KEY_ESCAPE)) {
+    if (input.isPressed(InputAction::BACK)) {
         if (currentState == GameStateType::PLAYING) {
             setState(GameStateType::PAUSED);
         } else if (currentState == GameStateType::PAUSED) {
@@ -33,11 +32,11 @@ void GameState::handleGameInput(bool consoleEnabled) {
     // Handle input specific to the paused state.
     if (currentState == GameStateType::PAUSED) {
         // Pressing Q quits the game.
-        if (IsKeyPressed(KEY_Q)) {
+        if (input.isPressed(InputAction::QUIT)) {
             shouldQuit = true;
         }
         // Pressing T returns to the title screen.
-        if (IsKeyPressed(KEY_T)) {
+        if (input.isPressed(InputAction::RETURN_TO_TITLE)) {
             setState(GameStateType::TITLE_SCREEN);
         }
     }
@@ -1,6 +1,8 @@
 #ifndef GAME_STATE_H
 #define GAME_STATE_H
 
+#include "Input.h"
+
 // Enum to represent the different states of the game.
 enum class GameStateType {
     TITLE_SCREEN, // The game is on the title screen.
@@ -13,11 +15,12 @@ struct GameState {
     GameStateType currentState = GameStateType::TITLE_SCREEN; // The current state of the game.
     bool consoleVisible = false; // Whether the developer console is visible.
     bool shouldQuit = false;     // Whether the game should quit.
+    bool rewinding = false;      // Whether the player is being rewound this tick.
     
     // Handles input when the game is on the title screen.
-    void handleTitleInput();
+    void handleTitleInput(const InputSnapshot& input);
     // Handles input during the main game loop (playing and paused states).
-    void handleGameInput(bool consoleEnabled);
+    void handleGameInput(const InputSnapshot& input, bool consoleEnabled);
     // Sets the new game state.
     void setState(GameStateType newState);
     
@@ -0,0 +1,575 @@
+#include "Headless.h"
+#include "Game.h"
+#include "ConsoleCapture.h"
+#include "TextureLoader.h"
+#include "InputReplay.h"
+#include "FrameArena.h"
+#include "FixedTimestep.h"
+#include "Timeline.h"
+#include "PhysicsKernel.h"
+#include "Rollback.h"
+#include "StateHash.h"
+#include "SaveState.h"
+#include "TimelineArchive.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+namespace {
+    // The number of ticks the synthetic input holds each movement direction.
+    constexpr long long MOVE_PHASE_TICKS = 90;
+    // The number of idle entities added to the world in a timeline soak.
+    constexpr size_t TIMELINE_CROWD_SIZE = 4096;
+    // The number of ticks each branch is simulated in a timeline soak, unless --ticks is given.
+    constexpr long long TIMELINE_SOAK_TICKS = 600;
+    // The number of entities stepped by one job in a timeline soak.
+    constexpr size_t TIMELINE_BATCH_SIZE = 512;
+    // The number of ticks a crowd benchmark runs, unless --ticks is given.
+    constexpr long long CROWD_BENCH_TICKS = 600;
+    // The number of entities stepped by one job when a crowd benchmark is given --threads. It is
+    // odd, so the vector kernels also run their scalar tail and unaligned loads mid-crowd.
+    constexpr size_t CROWD_BATCH_SIZE = 1001;
+    
+    // Builds a deterministic input snapshot for the given tick.
+    // The game is started on the first tick, then the player is steered around in a repeating
+    // pattern that includes a short rewind.
+    InputSnapshot syntheticInput(long long tick) {
+        InputSnapshot input;
+        if (tick == 0) {
+            input.setPressed(InputAction::START);
+            return input;
+        }
+        
+        switch ((tick / MOVE_PHASE_TICKS) % 7) {
+            case 0: input.setDown(InputAction::MOVE_RIGHT); break;
+            case 1: input.setDown(InputAction::MOVE_DOWN); break;
+            case 2: input.setDown(InputAction::MOVE_LEFT); break;
+            case 3: input.setDown(InputAction::MOVE_UP); break;
+            case 4: input.setDown(InputAction::MOVE_RIGHT); input.setDown(InputAction::MOVE_UP); break;
+            case 5: if (tick % MOVE_PHASE_TICKS < MOVE_PHASE_TICKS / 2) input.setDown(InputAction::REWIND); break;
+            default: break; // Let friction bring the player to rest.
+        }
+        return input;
+    }
+}
+
+namespace {
+    // Hashes every entity state bitwise (FNV-1a), so runs with different thread counts can be compared.
+    uint64_t hashWorld(const WorldState& world) {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < world.size(); ++i) {
+            const auto* bytes = reinterpret_cast<const unsigned char*>(&world.get(i));
+            for (size_t b = 0; b < sizeof(PlayerState); ++b) {
+                hash = (hash ^ bytes[b]) * 1099511628211ull;
+            }
+        }
+        return hash;
+    }
+    
+    // Forks a world of one moving player and an idle crowd into several timelines, steers the
+    // player differently in each, then merges every branch back into the root.
+    int runTimelineSoak(const GameConfig& config, const Player& prototype, const LaunchOptions& options) {
+        const FixedTimestep timestep(config.tickRate, config.maxFrameTime, config.maxTicksPerFrame);
+        const long long ticks = options.ticks > 0 ? options.ticks : TIMELINE_SOAK_TICKS;
+        
+        WorldState world;
+        world.push_back(prototype.captureState());
+        for (size_t i = 0; i < TIMELINE_CROWD_SIZE; ++i) {
+            PlayerState idle = prototype.captureState();
+            idle.position.x = static_cast<float>(i % 64) * 10.0f;
+            idle.position.y = static_cast<float>(i / 64) * 5.0f;
+            world.push_back(idle);
+        }
+        TimelineManager manager(world);
+        
+        using Clock = std::chrono::steady_clock;
+        const auto forkStart = Clock::now();
+        const std::vector<int> branches = manager.fork(manager.rootId(), options.timelines);
+        const auto simulateStart = Clock::now();
+        
+        // Each tick, every branch is stepped in entity batches across the job system.
+        // Every entity shares the prototype's tuning; only the first one receives input.
+        const float friction = prototype.friction();
+        const float maxX = static_cast<float>(config.screenWidth) - static_cast<float>(FALLBACK_TEXTURE_SIZE);
+        const float maxY = static_cast<float>(config.screenHeight) - static_cast<float>(FALLBACK_TEXTURE_SIZE);
+        const float tickDelta = timestep.tickDelta;
+        JobSystem jobSystem(options.threads >= 0 ? options.threads : config.workerThreads);
+        JobGraph graph;
+        std::vector<std::vector<PlayerState>> scratch(branches.size());
+        for (long long tick = 0; tick < ticks; ++tick) {
+            graph.clear();
+            for (size_t b = 0; b < branches.size(); ++b) {
+                const long long phase = static_cast<long long>(b) * MOVE_PHASE_TICKS / 2;
+                const InputSnapshot input = syntheticInput(tick + phase + 1);
+                manager.find(branches[b])->scheduleSimulation(graph, scratch[b], TIMELINE_BATCH_SIZE,
+                    [=](size_t entity, PlayerState& state) {
+                        if (entity == 0) {
+                            applyMovementInput(state.velocity.x, state.velocity.y, state.speed, input, tickDelta);
+                        }
+                        integrateMotion(state.position.x, state.position.y, state.velocity.x, state.velocity.y,
+                                        friction, state.maxSpeed, maxX, maxY, tickDelta);
+                    });
+            }
+            jobSystem.run(graph);
+        }
+        
+        const auto mergeStart = Clock::now();
+        MergeResult total;
+        for (int id : branches) {
+            const MergeResult result = manager.merge(id, manager.rootId(), MergePolicy::PREFER_NEWER);
+            total.changed += result.changed;
+            total.conflicts += result.conflicts;
+        }
+        const auto end = Clock::now();
+        
+        const auto micros = [](Clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); };
+        std::cout << "TIMELINES: " << branches.size() << " branches of " << world.size() << " entities, "
+                  << ticks << " ticks each, " << jobSystem.threadCount() << " thread(s)\n";
+        std::cout << "TIMELINES: fork " << micros(simulateStart - forkStart) << " us, simulate "
+                  << micros(mergeStart - simulateStart) << " us, merge " << micros(end - mergeStart) << " us\n";
+        std::cout << "TIMELINES: merged " << total.changed << " entities with " << total.conflicts
+                  << " conflicts, " << manager.liveCount() << " live timeline(s) left\n";
+        std::cout << "TIMELINES: root world hash " << std::hex << hashWorld(manager.find(manager.rootId())->world)
+                  << std::dec << '\n';
+        return 0;
+    }
+}
+
+namespace {
+    // Steps a crowd of entities through the SoA store's motion sweep and reports the cost per tick.
+    // With --threads the sweep is split into batches across the job system, and with --hash-out
+    // the state of the crowd is hashed after every tick, so kernels, thread counts and builds can
+    // be checked against each other.
+    int runCrowdBench(const GameConfig& config, const LaunchOptions& options) {
+        const FixedTimestep timestep(config.tickRate, config.maxFrameTime, config.maxTicksPerFrame);
+        const long long ticks = options.ticks > 0 ? options.ticks : CROWD_BENCH_TICKS;
+        
+        // Spread the crowd over the screen with deterministic pseudo-random velocities.
+        EntityStore store(static_cast<size_t>(options.entities));
+        uint32_t seed = 12345;
+        const auto nextRandom = [&seed]() {
+            seed = seed * 1664525u + 1013904223u;
+            return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+        };
+        for (int i = 0; i < options.entities; ++i) {
+            EntityDesc desc;
+            desc.x = nextRandom() * static_cast<float>(config.screenWidth);
+            desc.y = nextRandom() * static_cast<float>(config.screenHeight);
+            desc.speed = config.playerSpeed;
+            desc.friction = config.friction * nextRandom();
+            desc.maxSpeed = config.maxSpeed;
+            desc.width = static_cast<float>(FALLBACK_TEXTURE_SIZE);
+            desc.height = static_cast<float>(FALLBACK_TEXTURE_SIZE);
+            const EntityHandle handle = store.create(desc);
+            store.velX[store.indexOf(handle)] = (nextRandom() - 0.5f) * 2.0f * config.maxSpeed;
+            store.velY[store.indexOf(handle)] = (nextRandom() - 0.5f) * 2.0f * config.maxSpeed;
+        }
+        
+        StateHashWriter stateHashes;
+        if (!options.hashPath.empty() && !stateHashes.open(options.hashPath)) {
+            return 1;
+        }
+        
+        JobSystem jobSystem(options.threads >= 0 ? options.threads : 1);
+        JobGraph graph;
+        if (options.threads >= 0) {
+            for (size_t first = 0; first < store.size(); first += CROWD_BATCH_SIZE) {
+                const size_t last = std::min(store.size(), first + CROWD_BATCH_SIZE);
+                graph.add([&store, &timestep, &config, first, last]() {
+                    store.integrateRange(first, last, timestep.tickDelta, config.screenWidth, config.screenHeight);
+                });
+            }
+        }
+        
+        const auto start = std::chrono::steady_clock::now();
+        for (long long tick = 0; tick < ticks; ++tick) {
+            if (options.threads >= 0) {
+                jobSystem.run(graph);
+            } else {
+                store.integrate(timestep.tickDelta, config.screenWidth, config.screenHeight);
+            }
+            if (stateHashes.isOpen()) {
+                stateHashes.record(hashEntityState(store));
+            }
+        }
+        const auto end = std::chrono::steady_clock::now();
+        stateHashes.close();
+        
+        // Hash the final positions, so kernels can be checked against each other.
+        uint64_t hash = 14695981039346656037ull;
+        for (const auto* column : {&store.posX, &store.posY, &store.velX, &store.velY}) {
+            for (float value : *column) {
+                uint32_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                hash = (hash ^ bits) * 1099511628211ull;
+            }
+        }
+        
+        const double micros = std::chrono::duration<double, std::micro>(end - start).count();
+        std::cout << "CROWD: " << options.entities << " entities, " << ticks << " ticks, "
+                  << physicsKernelName(activePhysicsKernel()) << " kernel, " << jobSystem.threadCount() << " thread(s)\n";
+        std::cout << "CROWD: " << micros / static_cast<double>(ticks) << " us/tick, "
+                  << micros * 1000.0 / (static_cast<double>(ticks) * options.entities) << " ns/entity\n";
+        std::cout << "CROWD: state hash " << std::hex << hash << std::dec << '\n';
+        return 0;
+    }
+}
+
+namespace {
+    // The number of ticks a netplay session runs, unless --ticks is given.
+    constexpr long long NETPLAY_TICKS = 600;
+    // The number of ticks each netplay input is held before the next one is picked.
+    constexpr long long NETPLAY_INPUT_TICKS = 12;
+    // How long a netplay peer waits for the other one to start.
+    constexpr double NETPLAY_CONNECT_SECONDS = 10.0;
+    // How long a netplay peer waits at the end for the inputs it is missing.
+    constexpr double NETPLAY_DRAIN_SECONDS = 2.0;
+    // How long a netplay peer keeps answering after it has every input, so the other one does too.
+    constexpr double NETPLAY_LINGER_SECONDS = 0.25;
+
+    // Builds a player's input for the tick it applies to. It depends only on the tick and the
+    // player, so every run of a session sees the same inputs whatever the network did, and the
+    // final checksum must match between runs as well as between the two peers.
+    InputSnapshot netplayInput(long long tick, int player) {
+        uint32_t hash = static_cast<uint32_t>(tick / NETPLAY_INPUT_TICKS) * 2654435761u +
+                        static_cast<uint32_t>(player) * 40503u;
+        hash ^= hash >> 15;
+        hash *= 2246822519u;
+        hash ^= hash >> 13;
+        constexpr InputAction moves[] = {InputAction::MOVE_RIGHT, InputAction::MOVE_LEFT,
+                                         InputAction::MOVE_DOWN, InputAction::MOVE_UP};
+        InputSnapshot input;
+        if (hash & 1u) input.setDown(moves[(hash >> 1) & 3u]);
+        if (hash & 8u) input.setDown(moves[(hash >> 4) & 3u]);
+        return input;
+    }
+
+    // Runs one peer of a two-player rollback session against another process on this machine,
+    // at the real tick rate, and reports the rollback cost and the latency the players see.
+    int runNetplay(const GameConfig& config, const LaunchOptions& options) {
+        using Clock = std::chrono::steady_clock;
+        const FixedTimestep timestep(config.tickRate, config.maxFrameTime, config.maxTicksPerFrame);
+        const long long ticks = options.ticks > 0 ? options.ticks : NETPLAY_TICKS;
+        const int local = options.netPlayer;
+
+        // The players start a third of the screen apart, with the placeholder sprite size.
+        Texture2D placeholder{};
+        placeholder.width = FALLBACK_TEXTURE_SIZE;
+        placeholder.height = FALLBACK_TEXTURE_SIZE;
+        const float startY = static_cast<float>(config.screenHeight - FALLBACK_TEXTURE_SIZE) / 2.0f;
+        const float third = static_cast<float>(config.screenWidth) / 3.0f;
+        const float half = static_cast<float>(FALLBACK_TEXTURE_SIZE) / 2.0f;
+        EntityStore entities;
+        const std::array<Player, NET_PLAYERS> players = {
+            Player(entities, third - half, startY, config.playerSpeed, config.friction, config.maxSpeed, placeholder),
+            Player(entities, 2.0f * third - half, startY, config.playerSpeed, config.friction, config.maxSpeed, placeholder)};
+
+        UdpTransport transport;
+        const NetConditions conditions = {options.netLoss, options.netLatency, options.netJitter};
+        const int localPort = config.netPort + local;
+        const int remotePort = config.netPort + 1 - local;
+        if (!transport.open(static_cast<uint16_t>(localPort), static_cast<uint16_t>(remotePort), conditions,
+                            12345u + static_cast<uint32_t>(local))) {
+            return 1;
+        }
+        RollbackSession session(players, local, config, timestep.tickDelta, transport);
+        const double tickMs = timestep.tickDelta * 1000.0;
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "NETPLAY: player " << local << ", port " << localPort << " -> " << remotePort
+                  << ", input delay " << config.netInputDelay << " ticks, rollback window "
+                  << config.netRollbackTicks << " ticks\n";
+        std::cout << "NETPLAY: simulating " << conditions.lossPercent << "% loss, " << conditions.latencyMs
+                  << " ms latency, " << conditions.jitterMs << " ms jitter" << std::endl;
+        if (!session.connect(NETPLAY_CONNECT_SECONDS)) {
+            std::cerr << "NETPLAY: no peer answered on port " << remotePort << '\n';
+            return 1;
+        }
+
+        // Packets are flushed between ticks too, so the simulated latency is not rounded up to
+        // whole ticks.
+        const auto tickTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timestep.tickDelta));
+        const auto start = Clock::now();
+        auto nextTick = start;
+        while (session.currentTick() < ticks) {
+            session.advance(netplayInput(session.inputTick(), local));
+            nextTick += tickTime;
+            while (Clock::now() < nextTick) {
+                transport.flush();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        const auto end = Clock::now();
+
+        // Keep exchanging packets until both peers have every input of the session.
+        const auto drainEnd = end + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(NETPLAY_DRAIN_SECONDS));
+        auto lingerEnd = drainEnd;
+        while (Clock::now() < std::min(drainEnd, lingerEnd)) {
+            session.poll();
+            if (lingerEnd == drainEnd && session.remoteConfirmedTick() >= ticks - 1 &&
+                session.localAcknowledgedTick() >= ticks - 1) {
+                lingerEnd = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                               std::chrono::duration<double>(NETPLAY_LINGER_SECONDS));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const bool complete = session.remoteConfirmedTick() >= ticks - 1;
+
+        const RollbackStats& stats = session.stats();
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        const double perRollback = stats.rollbacks > 0 ? static_cast<double>(stats.resimulatedTicks) / stats.rollbacks : 0.0;
+        const double perTick = stats.resimulatedTicks > 0 ? stats.resimulationMicros / stats.resimulatedTicks : 0.0;
+        const double late = stats.lateInputs > 0 ? static_cast<double>(stats.lateTicks) / stats.lateInputs : 0.0;
+        std::cout << "NETPLAY: " << ticks << " ticks in " << seconds << " s, " << stats.stalls
+                  << " stalled ticks, round trip " << stats.roundTripMs << " ms\n";
+        std::cout << "NETPLAY: " << stats.rollbacks << " rollbacks resimulated " << stats.resimulatedTicks
+                  << " ticks (" << perRollback << " on average, " << stats.longestRollback << " at most), "
+                  << perTick << " us per resimulated tick, " << stats.worstResimulationMicros << " us worst rollback\n";
+        std::cout << "NETPLAY: local input shows after " << config.netInputDelay * tickMs << " ms; "
+                  << stats.predictedTicks << " ticks predicted, remote input corrected "
+                  << late * tickMs << " ms after its tick on average\n";
+        std::cout << "NETPLAY: packets sent " << transport.packetsSent() << ", dropped " << transport.packetsDropped()
+                  << ", received " << transport.packetsReceived() << '\n';
+        if (stats.desyncs > 0) {
+            std::cout << "NETPLAY: the peers' states first differed before tick " << stats.firstDesyncTick << '\n';
+        }
+        std::cout << "NETPLAY: " << stats.desyncs << " desyncs, state checksum " << std::hex << session.checksum()
+                  << std::dec << " after tick " << ticks << (complete ? "" : " (remote input incomplete)") << '\n';
+        std::cout << std::defaultfloat << std::setprecision(9);
+        for (int p = 0; p < NET_PLAYERS; ++p) {
+            std::cout << "NETPLAY: player " << p << " final position " << players[p].position().x << ", "
+                      << players[p].position().y << '\n';
+        }
+        return complete && stats.desyncs == 0 ? 0 : 1;
+    }
+}
+
+namespace {
+    // Restores a time from a timeline archive and prints where the player was then, with the
+    // time the open and the seek took.
+    int runScrub(const GameConfig& config, const LaunchOptions& options) {
+        const auto start = std::chrono::steady_clock::now();
+        TimelineReader archive;
+        if (!archive.open(options.scrubPath)) {
+            return 1;
+        }
+        const auto opened = std::chrono::steady_clock::now();
+        const uint64_t offset = std::min(static_cast<uint64_t>(options.scrubSeconds * archive.tickRate() + 0.5f),
+                                         archive.tickCount() - 1);
+        EntityStore entities;
+        const Player player = createPlayer(entities, config, Texture2D{});
+        if (!archive.seek(archive.firstTick() + offset, entities)) {
+            return 1;
+        }
+        const auto restored = std::chrono::steady_clock::now();
+        
+        ConsoleCapture::LineBuffer line;
+        for (size_t back = consoleCapture.lineCount(); back-- > 0;) {
+            if (consoleCapture.fullTailLine(back, line)) {
+                std::cout << line.data() << '\n';
+            }
+        }
+        std::cout << "HEADLESS: scrubbed to tick " << archive.firstTick() + offset << " ("
+                  << static_cast<double>(offset) / archive.tickRate() << " s) of " << options.scrubPath << ", which holds "
+                  << archive.tickCount() << " ticks in " << archive.chunkCount() << " chunks\n";
+        std::cout << "HEADLESS: opened in " << std::chrono::duration<double, std::micro>(opened - start).count()
+                  << " us, seek in " << std::chrono::duration<double, std::micro>(restored - opened).count() << " us\n";
+        std::cout << std::setprecision(9) << "HEADLESS: position " << player.position().x << ", "
+                  << player.position().y << '\n';
+        return 0;
+    }
+}
+
+// Runs the game logic without a window, stepping one fixed tick per iteration.
+int RunHeadless(GameConfig config, const LaunchOptions& options) {
+    if (!options.compareHashPaths[0].empty()) {
+        return compareStateHashes(options.compareHashPaths[0], options.compareHashPaths[1]);
+    }
+    if (!options.scrubPath.empty()) {
+        return runScrub(config, options);
+    }
+    // Force a physics kernel, e.g. to compare them against each other.
+    if (!options.kernel.empty()) {
+        bool selected = false;
+        for (PhysicsKernel kernel : {PhysicsKernel::SCALAR, PhysicsKernel::SSE2, PhysicsKernel::AVX2}) {
+            if (options.kernel == physicsKernelName(kernel)) {
+                selected = selectPhysicsKernel(kernel);
+            }
+        }
+        if (!selected) {
+            std::cerr << "Physics kernel '" << options.kernel << "' is not available on this CPU\n";
+            return 1;
+        }
+    }
+    if (options.entities > 0) {
+        return runCrowdBench(config, options);
+    }
+    if (options.sprites > 0) {
+        std::cerr << "The sprite benchmark needs a window; run it without --headless\n";
+        return 1;
+    }
+    if (options.netPlayer >= 0) {
+        return runNetplay(config, options);
+    }
+    
+    // No texture is loaded; the player only needs the sprite size for its screen bounds.
+    Texture2D placeholder{};
+    placeholder.width = FALLBACK_TEXTURE_SIZE;
+    placeholder.height = FALLBACK_TEXTURE_SIZE;
+    
+    // A replay brings its own settings and sprite size, so the run matches the recording bit for bit.
+    InputReplay replay;
+    if (!options.replayPath.empty()) {
+        if (!replay.open(options.replayPath)) {
+            return 1;
+        }
+        replay.getHeader().applyTo(config);
+        placeholder.width = replay.getHeader().playerWidth;
+        placeholder.height = replay.getHeader().playerHeight;
+    }
+    
+    EntityStore entities;
+    Player player = createPlayer(entities, config, placeholder);
+    if (options.timelines > 0) {
+        return runTimelineSoak(config, player, options);
+    }
+    
+    GameState gameState;
+    CommandParser commandParser;
+    bindGameCVars(commandParser.cvars(), config, player);
+    if (!options.execPath.empty()) {
+        commandParser.execScript(options.execPath);
+    }
+    ConsoleInput consoleInput;
+    RewindBuffer rewindBuffer(static_cast<size_t>(config.rewindMemoryKB) * 1024, config.rewindKeyframeInterval);
+    // A tick rate set from the console applies from the next tick, as it does between frames in the window.
+    FixedTimestep timestep(config.tickRate, config.maxFrameTime, config.maxTicksPerFrame);
+    bool timestepChanged = false;
+    commandParser.cvars().onChange("tick_rate", [&timestepChanged](const CVar&) { timestepChanged = true; });
+    StateHashWriter stateHashes;
+    if (!options.hashPath.empty() && !stateHashes.open(options.hashPath)) {
+        return 1;
+    }
+    
+    // A loaded save continues from its tick: the synthetic input picks up where it left off, and a
+    // replay skips the ticks between its start and the save.
+    uint64_t simulatedTicks = 0;
+    if (!options.loadPath.empty() &&
+        !loadSave(options.loadPath, entities, gameState, consoleInput, rewindBuffer, simulatedTicks)) {
+        return 1;
+    }
+    if (replay.isActive() && !replay.skipTo(simulatedTicks)) {
+        return 1;
+    }
+    // A recording starts at the loaded tick, so replaying it needs the same save.
+    InputRecorder recorder;
+    if (!options.recordPath.empty()) {
+        ReplayHeader header = ReplayHeader::fromConfig(config, placeholder.width, placeholder.height);
+        header.startTick = simulatedTicks;
+        recorder.open(options.recordPath, header);
+    }
+    commandParser.cvars().holdSimulation(replay.isActive() || recorder.isOpen());
+    // With --archive, every tick from here on is archived, starting with the state as loaded. After
+    // --load, the archive the save was made alongside is carried on from the save's tick.
+    TimelineWriter timeline;
+    if (!options.archivePath.empty() &&
+        !(options.loadPath.empty() ? timeline.open(options.archivePath, entities, simulatedTicks, config.tickRate)
+                                   : timeline.resume(options.archivePath, entities, simulatedTicks, config.tickRate))) {
+        return 1;
+    }
+    commandParser.bindTimeline(timeline, rewindBuffer);
+    // With --save, the run also autosaves every autosave_seconds of simulated time.
+    AutoSaver autosaver;
+    const uint64_t autosaveTicks =
+        options.savePath.empty() ? 0 : static_cast<uint64_t>(config.autosaveSeconds) * static_cast<uint64_t>(config.tickRate);
+    
+    // Replays run to their end by default; synthetic input runs for a fixed number of ticks.
+    long long tickLimit = options.ticks;
+    if (tickLimit == 0) {
+        tickLimit = replay.isActive() ? std::numeric_limits<long long>::max() : DEFAULT_HEADLESS_TICKS;
+    }
+    
+    long long ticksRun = 0;
+    const auto start = std::chrono::steady_clock::now();
+    while (ticksRun < tickLimit && !gameState.shouldQuit) {
+        if (timestepChanged) {
+            timestep = FixedTimestep(config.tickRate, config.maxFrameTime, config.maxTicksPerFrame);
+            timestepChanged = false;
+        }
+        InputSnapshot input;
+        if (replay.isActive()) {
+            if (!replay.next(input)) break;
+        } else {
+            input = syntheticInput(static_cast<long long>(simulatedTicks));
+        }
+        recorder.record(input);
+        updateGame(player, gameState, config, input, timestep.tickDelta, commandParser, consoleInput, rewindBuffer);
+        if (stateHashes.isOpen()) {
+            stateHashes.record(hashSimulationState(entities, gameState, consoleInput, rewindBuffer));
+        }
+        ++simulatedTicks;
+        timeline.record(entities);
+        if (autosaveTicks > 0 && simulatedTicks % autosaveTicks == 0) {
+            autosaver.save(options.savePath, entities, gameState, consoleInput, rewindBuffer, simulatedTicks, config.tickRate);
+        }
+        frameArena.reset();
+        ++ticksRun;
+    }
+    const auto end = std::chrono::steady_clock::now();
+    recorder.close();
+    stateHashes.close();
+    timeline.close();
+    if (!options.savePath.empty()) {
+        autosaver.wait();
+        autosaver.save(options.savePath, entities, gameState, consoleInput, rewindBuffer, simulatedTicks, config.tickRate);
+        autosaver.stop();
+    }
+    
+    // Echo the captured console output, since there is no on-screen console.
+    ConsoleCapture::LineBuffer line;
+    for (size_t back = consoleCapture.lineCount(); back-- > 0;) {
+        if (consoleCapture.fullTailLine(back, line)) {
+            std::cout << line.data() << '\n';
+        }
+    }
+    
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    const double ticks = static_cast<double>(std::max(1LL, ticksRun));
+    std::cout << "HEADLESS: " << ticksRun << " ticks in " << seconds << " s ("
+              << (seconds > 0.0 ? ticks / seconds : 0.0) << " ticks/s, "
+              << (seconds * 1e6) / ticks << " us/tick)\n";
+    std::cout << "HEADLESS: rewind history " << rewindBuffer.tickCount() << " ticks in "
+              << rewindBuffer.bytesUsed() << " bytes\n";
+    std::cout << "HEADLESS: frame arena peak " << frameArena.peakBytes() << " of " << frameArena.capacity()
+              << " bytes, " << frameArena.overflowFrames() << " ticks overflowed\n";
+#ifdef DEBUG
+    std::cout << "HEADLESS: " << FrameArena::lastFrameHeapCalls() << " heap allocations in the last tick\n";
+#endif
+    if (!options.hashPath.empty()) {
+        std::cout << "HEADLESS: state hashes for " << stateHashes.tickCount() << " ticks in "
+                  << stateHashes.bytesWritten() << " bytes\n";
+    }
+    if (!options.archivePath.empty()) {
+        std::cout << "HEADLESS: archived " << timeline.tickCount() << " ticks to " << options.archivePath << " in "
+                  << timeline.bytesWritten() << " bytes ("
+                  << static_cast<double>(timeline.bytesWritten()) / static_cast<double>(std::max<uint64_t>(1, timeline.tickCount()))
+                  << " bytes per tick)\n";
+    }
+    if (!options.savePath.empty()) {
+        const SaveStats saves = autosaver.stats();
+        std::cout << "HEADLESS: saved tick " << simulatedTicks << " to " << options.savePath << " in "
+                  << saves.lastFileBytes << " bytes (" << saves.lastImageBytes << " uncompressed), "
+                  << saves.written << " saves, " << saves.skipped << " skipped, " << saves.failed << " failed\n";
+        std::cout << "HEADLESS: save capture " << saves.lastCaptureMicros << " us (" << saves.worstCaptureMicros
+                  << " us at most), last write " << saves.lastWriteMillis << " ms\n";
+    }
+    std::cout << "HEADLESS: final state hash " << std::hex
+              << hashSimulationState(entities, gameState, consoleInput, rewindBuffer).combined() << std::dec << '\n';
+    // Print enough digits to round-trip a float, so runs can be compared exactly.
+    std::cout << std::setprecision(9)
+              << "HEADLESS: final position " << player.position().x << ", " << player.position().y << '\n';
+    return 0;
+}
@@ -0,0 +1,15 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "GameConfig.h"
+#include "LaunchOptions.h"
+
+// The number of ticks a headless run simulates when neither --ticks nor --replay is given.
+constexpr long long DEFAULT_HEADLESS_TICKS = 36000;
+
+// Runs the game logic without a window, GL context or texture loads,
+// stepping the simulation as fast as possible and printing timing results.
+// Input comes from the replay file when one is given, otherwise from a synthetic pattern.
+int RunHeadless(GameConfig config, const LaunchOptions& options);
+
+#endif // HEADLESS_H
@@ -0,0 +1,37 @@
+#include "Input.h"
+#include "raylib.h"
+
+// Reads the current keyboard state from raylib into an input snapshot.
+InputSnapshot PollInput(TypedCharQueue& typedChars) {
+    InputSnapshot input;
+    
+    // Movement keys are sampled as held state.
+    if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D)) input.setDown(InputAction::MOVE_RIGHT);
+    if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A))  input.setDown(InputAction::MOVE_LEFT);
+    if (IsKeyDown(KEY_DOWN) || IsKeyDown(KEY_S))  input.setDown(InputAction::MOVE_DOWN);
+    if (IsKeyDown(KEY_UP) || IsKeyDown(KEY_W))    input.setDown(InputAction::MOVE_UP);
+    if (IsKeyDown(KEY_R))                         input.setDown(InputAction::REWIND);
+    
+    // Menu and console keys are sampled as presses.
+    if (IsKeyPressed(KEY_SPACE))     input.setPressed(InputAction::START);
+    if (IsKeyPressed(KEY_ESCAPE))    input.setPressed(InputAction::BACK);
+    if (IsKeyPressed(KEY_GRAVE))     input.setPressed(InputAction::TOGGLE_CONSOLE);
+    if (IsKeyPressed(KEY_Q))         input.setPressed(InputAction::QUIT);
+    if (IsKeyPressed(KEY_T))         input.setPressed(InputAction::RETURN_TO_TITLE);
+    if (IsKeyPressed(KEY_BACKSPACE)) input.setPressed(InputAction::BACKSPACE);
+    if (IsKeyPressed(KEY_ENTER))     input.setPressed(InputAction::SUBMIT);
+    if (IsKeyPressed(KEY_TAB))       input.setPressed(InputAction::COMPLETE);
+    if (IsKeyDown(KEY_LEFT_ALT) && IsKeyPressed(KEY_C)) {
+        input.setPressed(InputAction::TOGGLE_CONSOLE_INPUT);
+    }
+    
+    // raylib forgets the characters it has not handed out by the next frame, so all of them are
+    // queued. Only printable ASCII is accepted by the console.
+    for (int key = GetCharPressed(); key != 0; key = GetCharPressed()) {
+        if (key >= 32 && key <= 125) {
+            typedChars.push(key);
+        }
+    }
+    
+    return input;
+}
@@ -0,0 +1,97 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <array>
+#include <cstdint>
+
+// The logical actions the game reacts to, independent of the physical keys bound to them.
+enum class InputAction : uint8_t {
+    MOVE_RIGHT,           // Move the player right (RIGHT / D).
+    MOVE_LEFT,            // Move the player left (LEFT / A).
+    MOVE_DOWN,            // Move the player down (DOWN / S).
+    MOVE_UP,              // Move the player up (UP / W).
+    START,                // Start the game from the title screen (SPACE).
+    BACK,                 // Pause, resume or quit from the title screen (ESCAPE).
+    TOGGLE_CONSOLE,       // Show or hide the console (GRAVE).
+    TOGGLE_CONSOLE_INPUT, // Focus or unfocus the console input box (ALT+C).
+    QUIT,                 // Quit from the pause screen (Q).
+    RETURN_TO_TITLE,      // Return to the title screen from the pause screen (T).
+    BACKSPACE,            // Delete the character before the console cursor.
+    SUBMIT,               // Execute the console command (ENTER).
+    REWIND,               // Scrub the player back in time while held (R).
+    COMPLETE              // Complete the console command or variable name (TAB).
+};
+
+// Constants for typed text.
+constexpr int TYPED_CHAR_QUEUE_SIZE = 64; // The most typed characters that can wait for a tick; more are dropped.
+
+// The InputSnapshot struct holds the state of every input action for a single simulation tick.
+// Game logic reads input only through this struct, so it can run without a window
+// and so a sequence of snapshots can be recorded and replayed exactly.
+struct InputSnapshot {
+    uint16_t down = 0;    // Bitmask of actions that are held down.
+    uint16_t pressed = 0; // Bitmask of actions that were pressed since the previous snapshot.
+    int typedChar = 0;    // The printable character typed since the previous snapshot (0 for none).
+    
+    // Checks if an action is held down.
+    bool isDown(InputAction action) const { return (down & bit(action)) != 0; }
+    // Checks if an action was pressed since the previous snapshot.
+    bool isPressed(InputAction action) const { return (pressed & bit(action)) != 0; }
+    // Marks an action as held down.
+    void setDown(InputAction action) { down |= bit(action); }
+    // Marks an action as pressed.
+    void setPressed(InputAction action) { pressed |= bit(action); }
+    
+    // Folds a newer poll into this snapshot: held state is replaced and presses are kept until a
+    // tick consumes them, so no press is lost when a frame runs zero ticks. Typed text is queued
+    // separately, in a TypedCharQueue.
+    void merge(const InputSnapshot& newer) {
+        down = newer.down;
+        pressed |= newer.pressed;
+    }
+    // Clears the one-shot events after a tick has consumed them, keeping the held state.
+    void clearEvents() { pressed = 0; typedChar = 0; }
+    
+    // Checks if two snapshots hold exactly the same input.
+    bool operator==(const InputSnapshot& other) const {
+        return down == other.down && pressed == other.pressed && typedChar == other.typedChar;
+    }
+    bool operator!=(const InputSnapshot& other) const { return !(*this == other); }
+    
+private:
+    // Returns the bitmask bit for an action.
+    static uint16_t bit(InputAction action) { return static_cast<uint16_t>(1u << static_cast<unsigned>(action)); }
+};
+
+// The TypedCharQueue class holds typed characters until ticks consume them, one per tick, in the
+// order they were typed. Characters typed faster than ticks run, or on frames that run no tick,
+// reach the ticks that follow instead of being lost.
+class TypedCharQueue {
+public:
+    // Adds a character, unless the queue is full.
+    void push(int ch) {
+        if (count == TYPED_CHAR_QUEUE_SIZE) return;
+        chars[(head + count) % TYPED_CHAR_QUEUE_SIZE] = ch;
+        ++count;
+    }
+    // Takes the oldest character, or returns 0 if there is none.
+    int pop() {
+        if (count == 0) return 0;
+        const int ch = chars[head];
+        head = (head + 1) % TYPED_CHAR_QUEUE_SIZE;
+        --count;
+        return ch;
+    }
+    
+private:
+    std::array<int, TYPED_CHAR_QUEUE_SIZE> chars{};
+    int head = 0;
+    int count = 0;
+};
+
+// Reads the current keyboard state from raylib into an input snapshot, and queues every
+// character typed since the last poll. Requires an open window; headless runs build their
+// snapshots directly.
+InputSnapshot PollInput(TypedCharQueue& typedChars);
+
+#endif // INPUT_H
@@ -0,0 +1,252 @@
+#include "InputReplay.h"
+#include "ConsoleCapture.h"
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+namespace {
+    // File identification and format version.
+    constexpr char REPLAY_MAGIC[4] = {'T', 'X', 'R', 'P'};
+    constexpr uint16_t REPLAY_VERSION = 1;
+    
+    // Little-endian helpers, so replay files are portable between platforms.
+    void writeU8(std::ofstream& out, uint8_t value) {
+        out.put(static_cast<char>(value));
+    }
+    
+    void writeU16(std::ofstream& out, uint16_t value) {
+        writeU8(out, static_cast<uint8_t>(value));
+        writeU8(out, static_cast<uint8_t>(value >> 8));
+    }
+    
+    void writeU32(std::ofstream& out, uint32_t value) {
+        writeU16(out, static_cast<uint16_t>(value));
+        writeU16(out, static_cast<uint16_t>(value >> 16));
+    }
+    
+    void writeU64(std::ofstream& out, uint64_t value) {
+        writeU32(out, static_cast<uint32_t>(value));
+        writeU32(out, static_cast<uint32_t>(value >> 32));
+    }
+    
+    // Floats are stored by their bit pattern so they round-trip exactly.
+    void writeF32(std::ofstream& out, float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        writeU32(out, bits);
+    }
+    
+    bool readU8(std::ifstream& in, uint8_t& value) {
+        const int c = in.get();
+        if (c == std::char_traits<char>::eof()) return false;
+        value = static_cast<uint8_t>(c);
+        return true;
+    }
+    
+    bool readU16(std::ifstream& in, uint16_t& value) {
+        uint8_t lo, hi;
+        if (!readU8(in, lo) || !readU8(in, hi)) return false;
+        value = static_cast<uint16_t>(lo | (hi << 8));
+        return true;
+    }
+    
+    bool readU32(std::ifstream& in, uint32_t& value) {
+        uint16_t lo, hi;
+        if (!readU16(in, lo) || !readU16(in, hi)) return false;
+        value = static_cast<uint32_t>(lo) | (static_cast<uint32_t>(hi) << 16);
+        return true;
+    }
+    
+    bool readU64(std::ifstream& in, uint64_t& value) {
+        uint32_t lo, hi;
+        if (!readU32(in, lo) || !readU32(in, hi)) return false;
+        value = static_cast<uint64_t>(lo) | (static_cast<uint64_t>(hi) << 32);
+        return true;
+    }
+    
+    bool readI32(std::ifstream& in, int& value) {
+        uint32_t bits;
+        if (!readU32(in, bits)) return false;
+        value = static_cast<int32_t>(bits);
+        return true;
+    }
+    
+    bool readF32(std::ifstream& in, float& value) {
+        uint32_t bits;
+        if (!readU32(in, bits)) return false;
+        std::memcpy(&value, &bits, sizeof(value));
+        return true;
+    }
+    
+    // Logs a replay error to both stderr and the in-game console.
+    void logReplayError(const std::string& message) {
+        std::cerr << message << '\n';
+        consoleCapture.addLine(message);
+    }
+}
+
+// ReplayHeader implementation
+// Captures the simulation-relevant settings from the config and sprite size.
+ReplayHeader ReplayHeader::fromConfig(const GameConfig& config, int spriteWidth, int spriteHeight) {
+    ReplayHeader header;
+    header.tickRate = config.tickRate;
+    header.screenWidth = config.screenWidth;
+    header.screenHeight = config.screenHeight;
+    header.playerSpeed = config.playerSpeed;
+    header.friction = config.friction;
+    header.maxSpeed = config.maxSpeed;
+    header.playerWidth = spriteWidth;
+    header.playerHeight = spriteHeight;
+    header.consoleEnabled = config.consoleEnabled;
+    return header;
+}
+
+// Writes the recorded settings back into a config.
+void ReplayHeader::applyTo(GameConfig& config) const {
+    config.tickRate = tickRate;
+    config.screenWidth = screenWidth;
+    config.screenHeight = screenHeight;
+    config.playerSpeed = playerSpeed;
+    config.friction = friction;
+    config.maxSpeed = maxSpeed;
+    config.consoleEnabled = consoleEnabled;
+}
+
+// InputRecorder implementation
+InputRecorder::~InputRecorder() {
+    close();
+}
+
+// Opens the file and writes the header.
+bool InputRecorder::open(const std::string& path, const ReplayHeader& header) {
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        logReplayError("REPLAY: Failed to create " + path);
+        return false;
+    }
+    
+    file.write(REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    writeU16(file, REPLAY_VERSION);
+    writeU16(file, static_cast<uint16_t>(header.tickRate));
+    writeU32(file, static_cast<uint32_t>(header.screenWidth));
+    writeU32(file, static_cast<uint32_t>(header.screenHeight));
+    writeF32(file, header.playerSpeed);
+    writeF32(file, header.friction);
+    writeF32(file, header.maxSpeed);
+    writeU32(file, static_cast<uint32_t>(header.playerWidth));
+    writeU32(file, static_cast<uint32_t>(header.playerHeight));
+    writeU64(file, header.startTick);
+    writeU8(file, header.consoleEnabled ? 1 : 0);
+    
+    runLength = 0;
+    ticks = 0;
+    consoleCapture.addLine("REPLAY: Recording to " + path);
+    return true;
+}
+
+// Appends the snapshot for the next tick, extending the pending run when the input is unchanged.
+void InputRecorder::record(const InputSnapshot& input) {
+    if (!file.is_open()) return;
+    
+    if (runLength > 0 && (input != runInput || runLength == std::numeric_limits<uint16_t>::max())) {
+        flushRun();
+    }
+    if (runLength == 0) {
+        runInput = input;
+    }
+    ++runLength;
+    ++ticks;
+}
+
+// Flushes the pending run and closes the file.
+void InputRecorder::close() {
+    if (!file.is_open()) return;
+    flushRun();
+    file.close();
+}
+
+// Writes the pending run as: held mask, pressed mask, typed character, repeat count.
+void InputRecorder::flushRun() {
+    if (runLength == 0) return;
+    writeU16(file, runInput.down);
+    writeU16(file, runInput.pressed);
+    writeU8(file, static_cast<uint8_t>(runInput.typedChar));
+    writeU16(file, runLength);
+    runLength = 0;
+}
+
+// InputReplay implementation
+// Opens the file and reads the header.
+bool InputReplay::open(const std::string& path) {
+    file.open(path, std::ios::binary);
+    if (!file.is_open()) {
+        logReplayError("REPLAY: Failed to open " + path);
+        return false;
+    }
+    
+    char magic[sizeof(REPLAY_MAGIC)] = {};
+    uint16_t version = 0;
+    uint16_t tickRate = 0;
+    uint8_t consoleEnabled = 0;
+    file.read(magic, sizeof(magic));
+    const bool valid = file.good() && std::memcmp(magic, REPLAY_MAGIC, sizeof(magic)) == 0 &&
+                       readU16(file, version) && version == REPLAY_VERSION &&
+                       readU16(file, tickRate) &&
+                       readI32(file, header.screenWidth) && readI32(file, header.screenHeight) &&
+                       readF32(file, header.playerSpeed) && readF32(file, header.friction) &&
+                       readF32(file, header.maxSpeed) &&
+                       readI32(file, header.playerWidth) && readI32(file, header.playerHeight) &&
+                       readU64(file, header.startTick) &&
+                       readU8(file, consoleEnabled);
+    if (!valid) {
+        logReplayError("REPLAY: Invalid replay file " + path);
+        file.close();
+        return false;
+    }
+    
+    header.tickRate = tickRate;
+    header.consoleEnabled = consoleEnabled != 0;
+    runRemaining = 0;
+    finished = false;
+    consoleCapture.addLine("REPLAY: Playing " + path);
+    return true;
+}
+
+// Reads the snapshot for the next tick, decoding a new run when the current one is used up.
+bool InputReplay::next(InputSnapshot& input) {
+    if (!isActive()) return false;
+    
+    if (runRemaining == 0) {
+        uint8_t typedChar = 0;
+        if (!readU16(file, runInput.down) || !readU16(file, runInput.pressed) ||
+            !readU8(file, typedChar) || !readU16(file, runRemaining) || runRemaining == 0) {
+            finished = true;
+            return false;
+        }
+        runInput.typedChar = typedChar;
+    }
+    
+    --runRemaining;
+    input = runInput;
+    return true;
+}
+
+// Skips the input before the given tick by decoding and discarding it.
+bool InputReplay::skipTo(uint64_t tick) {
+    if (!isActive()) return false;
+    if (tick < header.startTick) {
+        logReplayError("REPLAY: The recording starts at tick " + std::to_string(header.startTick) +
+                       ", after tick " + std::to_string(tick));
+        finished = true;
+        return false;
+    }
+    
+    InputSnapshot skipped;
+    for (uint64_t t = header.startTick; t < tick; ++t) {
+        if (!next(skipped)) {
+            logReplayError("REPLAY: The recording ends before tick " + std::to_string(tick));
+            return false;
+        }
+    }
+    return true;
+}
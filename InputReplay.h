@@ -0,0 +1,91 @@
+#ifndef INPUT_REPLAY_H
+#define INPUT_REPLAY_H
+
+#include "Input.h"
+#include "GameConfig.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// The ReplayHeader struct holds the settings a replay was recorded with.
+// Replaying applies them so the simulation produces bit-identical results.
+struct ReplayHeader {
+    int tickRate = 60;          // The simulation tick rate.
+    int screenWidth = 800;      // The screen width used for clamping.
+    int screenHeight = 450;     // The screen height used for clamping.
+    float playerSpeed = 0.0f;   // The player's base speed.
+    float friction = 0.0f;      // The player's friction.
+    float maxSpeed = 0.0f;      // The player's base maximum speed.
+    int playerWidth = 0;        // The player's sprite width.
+    int playerHeight = 0;       // The player's sprite height.
+    bool consoleEnabled = false; // Whether the console could be opened.
+    uint64_t startTick = 0;     // The tick the recording starts at, past zero when it began from a save.
+    
+    // Captures the simulation-relevant settings from the config and sprite size.
+    static ReplayHeader fromConfig(const GameConfig& config, int spriteWidth, int spriteHeight);
+    // Writes the recorded settings back into a config.
+    void applyTo(GameConfig& config) const;
+    
+    // Checks if two headers describe the same simulation. Where in it they start does not count.
+    bool operator==(const ReplayHeader& other) const {
+        return tickRate == other.tickRate && screenWidth == other.screenWidth && screenHeight == other.screenHeight &&
+               playerSpeed == other.playerSpeed && friction == other.friction && maxSpeed == other.maxSpeed &&
+               playerWidth == other.playerWidth && playerHeight == other.playerHeight &&
+               consoleEnabled == other.consoleEnabled;
+    }
+    bool operator!=(const ReplayHeader& other) const { return !(*this == other); }
+};
+
+// The InputRecorder class writes one input snapshot per tick to a compact binary file.
+// Identical consecutive snapshots are run-length encoded, so idle or held input costs a few bytes.
+class InputRecorder {
+public:
+    InputRecorder() = default;
+    ~InputRecorder();
+    
+    // Opens the file and writes the header. Returns false if the file cannot be created.
+    bool open(const std::string& path, const ReplayHeader& header);
+    // Appends the snapshot for the next tick.
+    void record(const InputSnapshot& input);
+    // Flushes the pending run and closes the file.
+    void close();
+    // Checks if a recording is in progress.
+    bool isOpen() const { return file.is_open(); }
+    // Returns the number of ticks recorded so far.
+    uint64_t tickCount() const { return ticks; }
+
+private:
+    // Writes the pending run to the file.
+    void flushRun();
+    
+    std::ofstream file;
+    InputSnapshot runInput;  // The snapshot repeated by the pending run.
+    uint16_t runLength = 0;  // The number of ticks in the pending run.
+    uint64_t ticks = 0;
+};
+
+// The InputReplay class reads back a file written by InputRecorder, one snapshot per tick.
+class InputReplay {
+public:
+    // Opens the file and reads the header. Returns false if the file is missing or invalid.
+    bool open(const std::string& path);
+    // Reads the snapshot for the next tick. Returns false once the replay is exhausted.
+    bool next(InputSnapshot& input);
+    // Skips the input before the given tick, so playback continues from a save made at that tick
+    // of the recording. Call it before the first next(). Returns false, ending the replay, if the
+    // recording starts after that tick or ends before it.
+    bool skipTo(uint64_t tick);
+    // Checks if a replay is loaded and has ticks left.
+    bool isActive() const { return file.is_open() && !finished; }
+    // Returns the settings the replay was recorded with.
+    const ReplayHeader& getHeader() const { return header; }
+
+private:
+    std::ifstream file;
+    ReplayHeader header;
+    InputSnapshot runInput;  // The snapshot repeated by the current run.
+    uint16_t runRemaining = 0; // The ticks left in the current run.
+    bool finished = false;
+};
+
+#endif // INPUT_REPLAY_H
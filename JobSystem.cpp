@@ -0,0 +1,139 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+// JobGraph implementation
+// Adds a job that runs after the given jobs.
+JobGraph::JobId JobGraph::add(std::function<void()> work, std::initializer_list<JobId> dependencies) {
+    const JobId id = jobs.size();
+    jobs.emplace_back();
+    jobs.back().work = std::move(work);
+    for (JobId dependency : dependencies) {
+        addDependency(dependency, id);
+    }
+    return id;
+}
+
+// Adds a dependency between two jobs already in the graph.
+void JobGraph::addDependency(JobId before, JobId after) {
+    jobs[before].successors.push_back(after);
+    ++jobs[after].dependencyCount;
+}
+
+// JobSystem implementation
+// Creates the queues and starts the worker threads.
+JobSystem::JobSystem(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (int i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+// Stops and joins the worker threads.
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// Runs every job in the graph and returns when all have finished.
+void JobSystem::run(JobGraph& jobGraph) {
+    if (jobGraph.jobs.empty()) return;
+    
+    graph = &jobGraph;
+    remainingJobs = jobGraph.jobs.size();
+    for (auto& job : jobGraph.jobs) {
+        job.pendingDependencies = job.dependencyCount;
+    }
+    
+    // Spread the jobs that are ready from the start across all queues.
+    int next = 0;
+    for (auto& job : jobGraph.jobs) {
+        if (job.dependencyCount == 0) {
+            push(next, &job);
+            next = (next + 1) % threadCount();
+        }
+    }
+    
+    // The caller works too, until the last job is done.
+    while (remainingJobs.load() > 0) {
+        if (!tryRunOne(0)) {
+            std::this_thread::yield();
+        }
+    }
+    graph = nullptr;
+}
+
+// The loop run by each worker thread: work while there is work, sleep otherwise.
+void JobSystem::workerLoop(int index) {
+    while (true) {
+        if (tryRunOne(index)) continue;
+        
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeCondition.wait(lock, [this] { return stopping.load() || queuedJobs.load() > 0; });
+        if (stopping) return;
+    }
+}
+
+// Runs one ready job: the newest from the thread's own queue, else the oldest from another queue.
+bool JobSystem::tryRunOne(int index) {
+    JobGraph::Job* job = nullptr;
+    {
+        WorkQueue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = own.jobs.back();
+            own.jobs.pop_back();
+        }
+    }
+    for (int offset = 1; !job && offset < threadCount(); ++offset) {
+        WorkQueue& victim = *queues[(index + offset) % threadCount()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+        }
+    }
+    if (!job) return false;
+    
+    --queuedJobs;
+    execute(job, index);
+    return true;
+}
+
+// Runs a job, then queues every successor whose last dependency this was.
+void JobSystem::execute(JobGraph::Job* job, int index) {
+    job->work();
+    for (JobGraph::JobId successor : job->successors) {
+        JobGraph::Job& next = graph->jobs[successor];
+        if (next.pendingDependencies.fetch_sub(1) == 1) {
+            push(index, &next);
+        }
+    }
+    --remainingJobs;
+}
+
+// Pushes a ready job onto a thread's queue and wakes a sleeping worker.
+void JobSystem::push(int index, JobGraph::Job* job) {
+    // Count the job before it becomes visible, so the counter never drops below the queue contents.
+    ++queuedJobs;
+    {
+        WorkQueue& queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(job);
+    }
+    {
+        // Taking the lock orders this with a worker checking the counter before it sleeps.
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wakeCondition.notify_one();
+}
@@ -0,0 +1,88 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The JobGraph class describes a batch of jobs and the order constraints between them.
+// A job runs only after every job it depends on has finished. Jobs with no path between
+// them may run in any order, on any thread, so they must not write to the same data.
+class JobGraph {
+public:
+    using JobId = size_t;
+    
+    // Adds a job that runs after the given jobs, and returns its id.
+    JobId add(std::function<void()> work, std::initializer_list<JobId> dependencies = {});
+    // Adds a dependency after the fact: 'after' will not start before 'before' finishes.
+    void addDependency(JobId before, JobId after);
+    // Returns the number of jobs in the graph.
+    size_t size() const { return jobs.size(); }
+    // Removes all jobs, so the graph can be rebuilt for the next tick.
+    void clear() { jobs.clear(); }
+
+private:
+    friend class JobSystem;
+    
+    // The Job struct holds one unit of work and its links in the graph.
+    struct Job {
+        std::function<void()> work;
+        std::vector<JobId> successors;      // The jobs waiting on this one.
+        int dependencyCount = 0;            // The number of jobs this one waits on.
+        std::atomic<int> pendingDependencies{0}; // The dependencies still running during a run.
+    };
+    
+    std::deque<Job> jobs; // A deque, so jobs never move while the graph grows.
+};
+
+// The JobSystem class runs job graphs on a fixed pool of threads.
+// Each thread owns a queue: it pushes and pops its own work at the back, and when it runs
+// dry it steals from the front of the other queues. The calling thread takes part in runs.
+class JobSystem {
+public:
+    // Creates a pool with the given total number of threads, including the caller.
+    // A count of 0 uses one thread per hardware core.
+    explicit JobSystem(int threadCount);
+    ~JobSystem();
+    
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    
+    // Runs every job in the graph, respecting dependencies, and returns when all have finished.
+    void run(JobGraph& graph);
+    // Returns the total number of threads, including the caller.
+    int threadCount() const { return static_cast<int>(queues.size()); }
+
+private:
+    // The WorkQueue struct is one thread's queue of ready jobs.
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<JobGraph::Job*> jobs;
+    };
+    
+    // The loop run by each worker thread.
+    void workerLoop(int index);
+    // Runs one ready job from the thread's own queue, or steals one. Returns false if none was found.
+    bool tryRunOne(int index);
+    // Runs a job and schedules the successors it unblocks.
+    void execute(JobGraph::Job* job, int index);
+    // Pushes a ready job onto the given thread's queue and wakes a sleeping worker.
+    void push(int index, JobGraph::Job* job);
+    
+    JobGraph* graph = nullptr;                     // The graph being run.
+    std::vector<std::unique_ptr<WorkQueue>> queues; // One per thread; index 0 is the caller.
+    std::vector<std::thread> workers;
+    std::atomic<size_t> remainingJobs{0};          // The jobs of the current run not yet finished.
+    std::atomic<size_t> queuedJobs{0};             // The jobs sitting in queues, for sleeping workers.
+    std::atomic<bool> stopping{false};
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+};
+
+#endif // JOB_SYSTEM_H
@@ -0,0 +1,148 @@
+#include "LaunchOptions.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string_view>
+
+namespace {
+    // The LaunchOptionSpec struct names an option and the number of values that follow it.
+    struct LaunchOptionSpec {
+        std::string_view name;
+        int values;
+    };
+
+    // Every option the command line accepts.
+    constexpr LaunchOptionSpec LAUNCH_OPTIONS[] = {
+        {"--help", 0}, {"--headless", 0}, {"--ticks", 1}, {"--record", 1}, {"--replay", 1}, {"--exec", 1},
+        {"--timelines", 1}, {"--threads", 1}, {"--entities", 1}, {"--kernel", 1}, {"--sprites", 1},
+        {"--netplay", 1}, {"--net-loss", 1}, {"--net-latency", 1}, {"--net-jitter", 1}, {"--load", 1},
+        {"--save", 1}, {"--archive", 1}, {"--scrub", 2}, {"--hash-out", 1}, {"--compare-hashes", 2}};
+
+    // The largest value an integer option takes.
+    constexpr long long INT_OPTION_MAX = std::numeric_limits<int>::max();
+
+    // The usage text printed for --help and after a bad command line.
+    constexpr const char* LAUNCH_USAGE =
+        "Usage: timeexe [options]\n"
+        "  --headless               Run without a window\n"
+        "  --ticks N                Run N headless ticks\n"
+        "  --record FILE            Record per-tick input to FILE\n"
+        "  --replay FILE            Replay per-tick input from FILE\n"
+        "  --exec FILE              Run a console script from the first tick\n"
+        "  --timelines N            Run a headless soak of N timeline branches\n"
+        "  --threads N              Use N worker threads (0 for one per core)\n"
+        "  --entities N             Run a headless physics benchmark of N entities\n"
+        "  --kernel NAME            Force a physics kernel: scalar, sse2 or avx2\n"
+        "  --sprites N              Run the sprite batch benchmark with N sprites\n"
+        "  --netplay N              Play a headless netplay session as player 0 or 1\n"
+        "  --net-loss PCT           Simulate packet loss\n"
+        "  --net-latency MS         Simulate packet delay\n"
+        "  --net-jitter MS          Simulate extra packet delay of up to MS\n"
+        "  --load FILE              Resume from a save file\n"
+        "  --save FILE              Save a headless run to FILE, and autosave to it\n"
+        "  --archive FILE           Archive every headless tick to FILE\n"
+        "  --scrub FILE SECONDS     Restore a time from a timeline archive\n"
+        "  --hash-out FILE          Write per-tick state hashes to FILE\n"
+        "  --compare-hashes A B     Compare two state hash files\n"
+        "  --help                   Show this help\n";
+
+    // Parses a whole argument as a decimal integer. Returns false if it is not one.
+    bool parseWhole(const char* text, long long& out) {
+        errno = 0;
+        char* end = nullptr;
+        out = std::strtoll(text, &end, 10);
+        return end != text && *end == '\0' && errno == 0;
+    }
+
+    // Parses a whole argument as a finite number. Returns false if it is not one.
+    bool parseReal(const char* text, float& out) {
+        errno = 0;
+        char* end = nullptr;
+        out = std::strtof(text, &end);
+        return end != text && *end == '\0' && errno == 0 && std::isfinite(out);
+    }
+}
+
+// Options are checked against LAUNCH_OPTIONS first, so each branch below can take its values.
+bool parseLaunchOptions(int argc, char* argv[], LaunchOptions& options) {
+    const auto fail = [](const std::string& message) {
+        std::cerr << message << '\n' << LAUNCH_USAGE;
+        return false;
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const auto spec = std::find_if(std::begin(LAUNCH_OPTIONS), std::end(LAUNCH_OPTIONS),
+                                       [arg](const LaunchOptionSpec& option) { return option.name == arg; });
+        if (spec == std::end(LAUNCH_OPTIONS)) {
+            return fail("Unknown option " + std::string(arg));
+        }
+        if (i + spec->values >= argc) {
+            return fail(std::string(arg) + " needs " + (spec->values == 1 ? "a value" : "two values"));
+        }
+
+        // Numeric values are read through these; numeric turns false if a value is not a number.
+        long long whole = 0;
+        float real = 0.0f;
+        bool numeric = true;
+        const auto nextWhole = [&]() { numeric = parseWhole(argv[++i], whole); return numeric; };
+        const auto nextReal = [&]() { numeric = parseReal(argv[++i], real); return numeric; };
+
+        if (arg == "--help") {
+            options.help = true;
+        } else if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--ticks") {
+            if (nextWhole()) options.ticks = std::max(1LL, whole);
+        } else if (arg == "--record") {
+            options.recordPath = argv[++i];
+        } else if (arg == "--replay") {
+            options.replayPath = argv[++i];
+        } else if (arg == "--exec") {
+            options.execPath = argv[++i];
+        } else if (arg == "--timelines") {
+            if (nextWhole()) options.timelines = static_cast<int>(std::clamp(whole, 1LL, INT_OPTION_MAX));
+        } else if (arg == "--threads") {
+            if (nextWhole()) options.threads = static_cast<int>(std::clamp(whole, 0LL, INT_OPTION_MAX));
+        } else if (arg == "--entities") {
+            if (nextWhole()) options.entities = static_cast<int>(std::clamp(whole, 1LL, INT_OPTION_MAX));
+        } else if (arg == "--kernel") {
+            options.kernel = argv[++i];
+        } else if (arg == "--sprites") {
+            if (nextWhole()) options.sprites = static_cast<int>(std::clamp(whole, 1LL, INT_OPTION_MAX));
+        } else if (arg == "--netplay") {
+            if (nextWhole()) options.netPlayer = static_cast<int>(std::clamp(whole, 0LL, 1LL));
+        } else if (arg == "--net-loss") {
+            if (nextReal()) options.netLoss = std::clamp(real, 0.0f, 100.0f);
+        } else if (arg == "--net-latency") {
+            if (nextWhole()) options.netLatency = static_cast<int>(std::clamp(whole, 0LL, INT_OPTION_MAX));
+        } else if (arg == "--net-jitter") {
+            if (nextWhole()) options.netJitter = static_cast<int>(std::clamp(whole, 0LL, INT_OPTION_MAX));
+        } else if (arg == "--load") {
+            options.loadPath = argv[++i];
+        } else if (arg == "--save") {
+            options.savePath = argv[++i];
+        } else if (arg == "--archive") {
+            options.archivePath = argv[++i];
+        } else if (arg == "--scrub") {
+            options.scrubPath = argv[++i];
+            if (nextReal()) options.scrubSeconds = std::max(0.0f, real);
+        } else if (arg == "--hash-out") {
+            options.hashPath = argv[++i];
+        } else if (arg == "--compare-hashes") {
+            options.compareHashPaths[0] = argv[++i];
+            options.compareHashPaths[1] = argv[++i];
+        }
+        if (!numeric) {
+            return fail(std::string(arg) + " expects a number, not '" + argv[i] + "'");
+        }
+    }
+    return true;
+}
+
+const char* launchOptionsUsage() {
+    return LAUNCH_USAGE;
+}
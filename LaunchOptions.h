@@ -0,0 +1,38 @@
+#ifndef LAUNCH_OPTIONS_H
+#define LAUNCH_OPTIONS_H
+
+#include <string>
+
+// The LaunchOptions struct holds the settings passed on the command line.
+struct LaunchOptions {
+    bool help = false;       // Whether to print the usage and exit (--help).
+    bool headless = false;   // Whether to run without a window (--headless).
+    long long ticks = 0;     // The number of headless ticks to run, 0 for the default (--ticks N).
+    std::string recordPath;  // The file to record per-tick input to (--record FILE).
+    std::string replayPath;  // The file to replay per-tick input from (--replay FILE).
+    std::string execPath;    // A console script to run from the first tick (--exec FILE). Replays need the same script.
+    int timelines = 0;       // The number of timeline branches for a headless timeline soak (--timelines N).
+    int threads = -1;        // Overrides worker_threads from the config when set (--threads N).
+    int entities = 0;        // The crowd size for a headless physics benchmark (--entities N).
+    std::string kernel;      // Forces a physics kernel: scalar, sse2 or avx2 (--kernel NAME).
+    int sprites = 0;         // The sprite count for the windowed sprite batch benchmark (--sprites N).
+    int netPlayer = -1;      // The player this process controls in a headless netplay session, 0 or 1 (--netplay N).
+    float netLoss = 0.0f;    // The simulated packet loss in percent (--net-loss PCT).
+    int netLatency = 0;      // The simulated packet delay in milliseconds (--net-latency MS).
+    int netJitter = 0;       // The most simulated extra delay in milliseconds (--net-jitter MS).
+    std::string loadPath;    // A save file to resume from (--load FILE).
+    std::string savePath;    // The file a headless run saves to when it ends, and autosaves to (--save FILE).
+    std::string archivePath; // The file a headless run archives every tick to (--archive FILE).
+    std::string scrubPath;   // A timeline archive to restore a time from instead of running (--scrub FILE SECONDS).
+    float scrubSeconds = 0.0f; // The time to restore, in seconds from the start of the archive.
+    std::string hashPath;    // The file to write per-tick state hashes to (--hash-out FILE).
+    std::string compareHashPaths[2]; // Two state hash files to compare instead of running (--compare-hashes A B).
+};
+
+// Parses the command-line arguments into options. Returns false, after printing the problem and
+// the usage, if an argument is not a known option or an option lacks its values.
+bool parseLaunchOptions(int argc, char* argv[], LaunchOptions& options);
+// Returns the usage text listing every option.
+const char* launchOptionsUsage();
+
+#endif // LAUNCH_OPTIONS_H
@@ -0,0 +1,110 @@
+#include "MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        view = other.view;
+        length = other.length;
+        mapping = other.mapping;
+        buffer = std::move(other.buffer);
+        other.view = nullptr;
+        other.length = 0;
+        other.mapping = nullptr;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path, size_t mapThreshold) {
+    close();
+    bool opened = false;
+#ifdef _WIN32
+    const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(file, &fileSize)) {
+        length = static_cast<size_t>(fileSize.QuadPart);
+        if (length == 0) {
+            opened = true;
+        } else if (length >= mapThreshold) {
+            const HANDLE section = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            mapping = section ? MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            // The view keeps the mapping alive on its own.
+            if (section) CloseHandle(section);
+            view = static_cast<const uint8_t*>(mapping);
+            opened = view != nullptr;
+        } else {
+            buffer.resize(length);
+            size_t total = 0;
+            DWORD bytesRead = 0;
+            while (total < length &&
+                   ReadFile(file, buffer.data() + total, static_cast<DWORD>(length - total), &bytesRead, nullptr) &&
+                   bytesRead > 0) {
+                total += bytesRead;
+            }
+            view = buffer.data();
+            opened = total == length;
+        }
+    }
+    CloseHandle(file);
+#else
+    const int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) return false;
+    struct stat info;
+    if (::fstat(file, &info) == 0) {
+        length = static_cast<size_t>(info.st_size);
+        if (length == 0) {
+            opened = true;
+        } else if (length >= mapThreshold) {
+            void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
+            mapping = mapped == MAP_FAILED ? nullptr : mapped;
+            view = static_cast<const uint8_t*>(mapping);
+            opened = view != nullptr;
+        } else {
+            buffer.resize(length);
+            size_t total = 0;
+            while (total < length) {
+                const ssize_t bytesRead = ::read(file, buffer.data() + total, length - total);
+                if (bytesRead <= 0) break;
+                total += static_cast<size_t>(bytesRead);
+            }
+            view = buffer.data();
+            opened = total == length;
+        }
+    }
+    ::close(file);
+#endif
+    if (!opened) close();
+    return opened;
+}
+
+// The read buffer keeps its capacity for the next open().
+void MappedFile::close() {
+    if (mapping != nullptr) {
+#ifdef _WIN32
+        UnmapViewOfFile(mapping);
+#else
+        ::munmap(mapping, length);
+#endif
+    }
+    mapping = nullptr;
+    view = nullptr;
+    length = 0;
+    buffer.clear();
+}
@@ -0,0 +1,42 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The MappedFile class makes a whole file readable in memory. Files from a size threshold up are
+// mapped (mmap on POSIX systems, a file mapping view on Windows), so only the pages that are read
+// are loaded. Smaller files are read into a buffer instead, since mapping has a fixed cost that
+// only pays off for large files; the buffer keeps its capacity for the next open().
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Makes the file as it is now readable, replacing any file opened before. It is mapped if it
+    // holds at least mapThreshold bytes, and read otherwise. Returns false if it cannot be opened
+    // or read; an empty file opens with no data.
+    bool open(const std::string& path, size_t mapThreshold = 0);
+    // Releases the file. Pointers into its data become invalid.
+    void close();
+
+    const uint8_t* data() const { return view; }
+    size_t size() const { return length; }
+    // Checks if the file is mapped rather than read into the buffer.
+    bool isMapped() const { return mapping != nullptr; }
+
+private:
+    const uint8_t* view = nullptr;
+    size_t length = 0;
+    void* mapping = nullptr;      // The mapped view, if the file is mapped.
+    std::vector<uint8_t> buffer;  // The file's contents, if it was read instead.
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,66 @@
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// The PerfectHash struct maps a fixed set of keys, known at compile time, to their positions in
+// the key list with one hash and one comparison. build() searches for a seed under which no two
+// keys share a slot; declare the table constexpr and static_assert that it is valid.
+template <size_t TableSize>
+struct PerfectHash {
+    static_assert(TableSize > 0 && (TableSize & (TableSize - 1)) == 0, "TableSize must be a power of two");
+
+    uint32_t seed = 0;
+    bool valid = false;                      // Whether a collision-free seed was found.
+    std::array<uint16_t, TableSize> slots{}; // The key index + 1 for each slot, or 0 for an empty slot.
+
+    // Hashes a key with FNV-1a, then mixes the result so the low bits used for the slot depend on
+    // the whole key and seed.
+    static constexpr uint32_t hash(std::string_view key, uint32_t seed) {
+        uint32_t h = 2166136261u ^ seed;
+        for (char ch : key) {
+            h ^= static_cast<unsigned char>(ch);
+            h *= 16777619u;
+        }
+        h ^= h >> 16;
+        h *= 0x85ebca6bu;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35u;
+        h ^= h >> 16;
+        return h;
+    }
+
+    // Returns the index of the only key that can match, or -1 if none can. Any string lands in
+    // some slot, so the caller must still compare against the key at the returned index.
+    constexpr int find(std::string_view key) const {
+        return static_cast<int>(slots[hash(key, seed) & (TableSize - 1)]) - 1;
+    }
+
+    // Builds a table for the keys. The result is invalid if the keys have duplicates or no seed
+    // was found, in which case a larger TableSize is needed.
+    template <size_t KeyCount>
+    static constexpr PerfectHash build(const std::array<std::string_view, KeyCount>& keys) {
+        static_assert(KeyCount < TableSize && KeyCount < 0xffff, "Too many keys for the table");
+        constexpr uint32_t maxAttempts = 4096;
+        for (uint32_t attempt = 0; attempt < maxAttempts; ++attempt) {
+            PerfectHash table;
+            table.seed = attempt * 0x9e3779b9u;
+            table.valid = true;
+            for (size_t i = 0; i < KeyCount && table.valid; ++i) {
+                uint16_t& slot = table.slots[hash(keys[i], table.seed) & (TableSize - 1)];
+                if (slot != 0) {
+                    table.valid = false;
+                } else {
+                    slot = static_cast<uint16_t>(i + 1);
+                }
+            }
+            if (table.valid) return table;
+        }
+        return PerfectHash{};
+    }
+};
+
+#endif // PERFECT_HASH_H
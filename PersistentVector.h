@@ -0,0 +1,142 @@
+#ifndef PERSISTENT_VECTOR_H
+#define PERSISTENT_VECTOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+// The PersistentVector class is a copy-on-write vector built as a 32-way tree of shared nodes.
+// Copying a vector copies one pointer, so it is O(1) regardless of size. Writing a slot copies
+// only the nodes on its path that are still shared with another copy (O(log32 n)), so copies
+// that diverge slightly keep sharing everything they did not change.
+// Values are compared bitwise, so T must be trivially copyable.
+template<typename T>
+class PersistentVector {
+    static_assert(std::is_trivially_copyable_v<T>, "PersistentVector values are compared bitwise");
+    
+public:
+    static constexpr size_t BITS = 5;
+    static constexpr size_t WIDTH = size_t{1} << BITS;
+    static constexpr size_t MASK = WIDTH - 1;
+    
+    // Returns the number of values.
+    size_t size() const { return count; }
+    
+    // Returns the value at the given index.
+    const T& get(size_t index) const {
+        const void* node = root.get();
+        for (size_t level = shift; level > 0; level -= BITS) {
+            node = asBranch(node)->children[(index >> level) & MASK].get();
+        }
+        return asLeaf(node)->values[index & MASK];
+    }
+    
+    // Writes the value at the given index, copying any shared nodes on its path.
+    void set(size_t index, const T& value) {
+        *leafSlot(index) = value;
+    }
+    
+    // Writes the value only if it differs bitwise, so unchanged values keep sharing their nodes.
+    // Returns true if the value was written.
+    bool update(size_t index, const T& value) {
+        if (std::memcmp(&get(index), &value, sizeof(T)) == 0) return false;
+        set(index, value);
+        return true;
+    }
+    
+    // Appends a value, growing the tree by one level when it is full.
+    void push_back(const T& value) {
+        if (!root) {
+            root = std::make_shared<Leaf>();
+        } else if (count == (WIDTH << shift)) {
+            auto newRoot = std::make_shared<Branch>();
+            newRoot->children[0] = std::move(root);
+            root = std::move(newRoot);
+            shift += BITS;
+        }
+        ++count;
+        *leafSlot(count - 1) = value;
+    }
+    
+    // Calls f(index) for every index whose value differs between two versions of a vector.
+    // Subtrees that are still shared are skipped, so the cost is proportional to what changed.
+    // Indices that exist in only one of the two vectors are reported as changed.
+    template<typename F>
+    static void diff(const PersistentVector& a, const PersistentVector& b, F&& f) {
+        const size_t common = a.count < b.count ? a.count : b.count;
+        if (common > 0) {
+            // A grown tree keeps its old root as the first child, so descend to matching heights.
+            const void* nodeA = a.root.get();
+            const void* nodeB = b.root.get();
+            size_t level = a.shift < b.shift ? a.shift : b.shift;
+            for (size_t s = a.shift; s > level; s -= BITS) nodeA = asBranch(nodeA)->children[0].get();
+            for (size_t s = b.shift; s > level; s -= BITS) nodeB = asBranch(nodeB)->children[0].get();
+            diffNodes(nodeA, nodeB, level, 0, common, f);
+        }
+        const size_t larger = a.count > b.count ? a.count : b.count;
+        for (size_t i = common; i < larger; ++i) {
+            f(i);
+        }
+    }
+
+private:
+    // Leaf nodes hold values; branch nodes hold children. Nodes are stored type-erased,
+    // since the depth of a node tells which kind it is.
+    struct Leaf {
+        std::array<T, WIDTH> values{};
+    };
+    struct Branch {
+        std::array<std::shared_ptr<void>, WIDTH> children;
+    };
+    
+    static const Leaf* asLeaf(const void* node) { return static_cast<const Leaf*>(node); }
+    static const Branch* asBranch(const void* node) { return static_cast<const Branch*>(node); }
+    
+    // Makes the node in the slot exclusively owned by this vector, copying it if shared.
+    template<typename Node>
+    static Node* makeUnique(std::shared_ptr<void>& slot) {
+        if (!slot) {
+            slot = std::make_shared<Node>();
+        } else if (slot.use_count() > 1) {
+            slot = std::make_shared<Node>(*static_cast<const Node*>(slot.get()));
+        }
+        return static_cast<Node*>(slot.get());
+    }
+    
+    // Returns a writable pointer to the value slot, copying shared nodes along the path.
+    T* leafSlot(size_t index) {
+        std::shared_ptr<void>* slot = &root;
+        for (size_t level = shift; level > 0; level -= BITS) {
+            slot = &makeUnique<Branch>(*slot)->children[(index >> level) & MASK];
+        }
+        return &makeUnique<Leaf>(*slot)->values[index & MASK];
+    }
+    
+    // Recursively compares two nodes covering indices [first, first + (WIDTH << level)), up to limit.
+    template<typename F>
+    static void diffNodes(const void* a, const void* b, size_t level, size_t first, size_t limit, F& f) {
+        if (a == b) return;
+        if (level == 0) {
+            const size_t end = first + WIDTH < limit ? first + WIDTH : limit;
+            for (size_t i = first; i < end; ++i) {
+                if (std::memcmp(&asLeaf(a)->values[i & MASK], &asLeaf(b)->values[i & MASK], sizeof(T)) != 0) {
+                    f(i);
+                }
+            }
+            return;
+        }
+        const size_t childSpan = WIDTH << (level - BITS);
+        for (size_t c = 0; c < WIDTH && first + c * childSpan < limit; ++c) {
+            diffNodes(asBranch(a)->children[c].get(), asBranch(b)->children[c].get(),
+                      level - BITS, first + c * childSpan, limit, f);
+        }
+    }
+    
+    std::shared_ptr<void> root;  // The root node (a leaf while the vector holds at most WIDTH values).
+    size_t shift = 0;            // The index shift at the root; 0 when the root is a leaf.
+    size_t count = 0;
+};
+
+#endif // PERSISTENT_VECTOR_H
@@ -0,0 +1,184 @@
+#include "PhysicsKernel.h"
+#include "EntityStore.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PHYSICS_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    using KernelFunction = void (*)(const MotionArrays&, size_t, size_t, float, float, float);
+    
+    // Steps entities one at a time with the shared scalar kernel.
+    void integrateScalar(const MotionArrays& a, size_t first, size_t last, float dt, float screenW, float screenH) {
+        for (size_t i = first; i < last; ++i) {
+            a.prevX[i] = a.posX[i];
+            a.prevY[i] = a.posY[i];
+            integrateMotion(a.posX[i], a.posY[i], a.velX[i], a.velY[i], a.friction[i], a.maxSpeed[i],
+                            screenW - a.width[i], screenH - a.height[i], dt);
+        }
+    }
+    
+#ifdef PHYSICS_KERNEL_X86
+    // The vector kernels replicate clampMotion() exactly, including for NaN and lo > hi:
+    // take lo where v < lo, then take hi where hi < that. The min/max instructions order their
+    // operands differently for NaN, so the selects are done with compare masks instead.
+    
+    __attribute__((target("sse2")))
+    inline __m128 clampSSE2(__m128 v, __m128 lo, __m128 hi) {
+        const __m128 belowLo = _mm_cmplt_ps(v, lo);
+        const __m128 r = _mm_or_ps(_mm_and_ps(belowLo, lo), _mm_andnot_ps(belowLo, v));
+        const __m128 aboveHi = _mm_cmplt_ps(hi, r);
+        return _mm_or_ps(_mm_and_ps(aboveHi, hi), _mm_andnot_ps(aboveHi, r));
+    }
+    
+    // Steps four entities per iteration with SSE2, finishing the remainder with the scalar kernel.
+    __attribute__((target("sse2")))
+    void integrateSSE2(const MotionArrays& a, size_t first, size_t last, float dt, float screenW, float screenH) {
+        const __m128 dtv = _mm_set1_ps(dt);
+        const __m128 screenWv = _mm_set1_ps(screenW);
+        const __m128 screenHv = _mm_set1_ps(screenH);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+        
+        size_t i = first;
+        for (; i + 4 <= last; i += 4) {
+            __m128 px = _mm_loadu_ps(a.posX + i);
+            __m128 py = _mm_loadu_ps(a.posY + i);
+            __m128 vx = _mm_loadu_ps(a.velX + i);
+            __m128 vy = _mm_loadu_ps(a.velY + i);
+            _mm_storeu_ps(a.prevX + i, px);
+            _mm_storeu_ps(a.prevY + i, py);
+            
+            // Friction, then the speed clamp.
+            const __m128 frictionDelta = _mm_mul_ps(_mm_loadu_ps(a.friction + i), dtv);
+            vx = _mm_sub_ps(vx, _mm_mul_ps(vx, frictionDelta));
+            vy = _mm_sub_ps(vy, _mm_mul_ps(vy, frictionDelta));
+            const __m128 maxSpeed = _mm_loadu_ps(a.maxSpeed + i);
+            const __m128 minSpeed = _mm_xor_ps(maxSpeed, signBit);
+            vx = clampSSE2(vx, minSpeed, maxSpeed);
+            vy = clampSSE2(vy, minSpeed, maxSpeed);
+            
+            // Integration, then the screen clamp.
+            px = clampSSE2(_mm_add_ps(px, _mm_mul_ps(vx, dtv)), zero, _mm_sub_ps(screenWv, _mm_loadu_ps(a.width + i)));
+            py = clampSSE2(_mm_add_ps(py, _mm_mul_ps(vy, dtv)), zero, _mm_sub_ps(screenHv, _mm_loadu_ps(a.height + i)));
+            
+            _mm_storeu_ps(a.posX + i, px);
+            _mm_storeu_ps(a.posY + i, py);
+            _mm_storeu_ps(a.velX + i, vx);
+            _mm_storeu_ps(a.velY + i, vy);
+        }
+        integrateScalar(a, i, last, dt, screenW, screenH);
+    }
+    
+    __attribute__((target("avx2")))
+    inline __m256 clampAVX2(__m256 v, __m256 lo, __m256 hi) {
+        const __m256 r = _mm256_blendv_ps(v, lo, _mm256_cmp_ps(v, lo, _CMP_LT_OQ));
+        return _mm256_blendv_ps(r, hi, _mm256_cmp_ps(hi, r, _CMP_LT_OQ));
+    }
+    
+    // Steps eight entities per iteration with AVX2, finishing the remainder with the scalar kernel.
+    __attribute__((target("avx2")))
+    void integrateAVX2(const MotionArrays& a, size_t first, size_t last, float dt, float screenW, float screenH) {
+        const __m256 dtv = _mm256_set1_ps(dt);
+        const __m256 screenWv = _mm256_set1_ps(screenW);
+        const __m256 screenHv = _mm256_set1_ps(screenH);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 signBit = _mm256_set1_ps(-0.0f);
+        
+        size_t i = first;
+        for (; i + 8 <= last; i += 8) {
+            __m256 px = _mm256_loadu_ps(a.posX + i);
+            __m256 py = _mm256_loadu_ps(a.posY + i);
+            __m256 vx = _mm256_loadu_ps(a.velX + i);
+            __m256 vy = _mm256_loadu_ps(a.velY + i);
+            _mm256_storeu_ps(a.prevX + i, px);
+            _mm256_storeu_ps(a.prevY + i, py);
+            
+            // Friction, then the speed clamp.
+            const __m256 frictionDelta = _mm256_mul_ps(_mm256_loadu_ps(a.friction + i), dtv);
+            vx = _mm256_sub_ps(vx, _mm256_mul_ps(vx, frictionDelta));
+            vy = _mm256_sub_ps(vy, _mm256_mul_ps(vy, frictionDelta));
+            const __m256 maxSpeed = _mm256_loadu_ps(a.maxSpeed + i);
+            const __m256 minSpeed = _mm256_xor_ps(maxSpeed, signBit);
+            vx = clampAVX2(vx, minSpeed, maxSpeed);
+            vy = clampAVX2(vy, minSpeed, maxSpeed);
+            
+            // Integration, then the screen clamp.
+            px = clampAVX2(_mm256_add_ps(px, _mm256_mul_ps(vx, dtv)), zero, _mm256_sub_ps(screenWv, _mm256_loadu_ps(a.width + i)));
+            py = clampAVX2(_mm256_add_ps(py, _mm256_mul_ps(vy, dtv)), zero, _mm256_sub_ps(screenHv, _mm256_loadu_ps(a.height + i)));
+            
+            _mm256_storeu_ps(a.posX + i, px);
+            _mm256_storeu_ps(a.posY + i, py);
+            _mm256_storeu_ps(a.velX + i, vx);
+            _mm256_storeu_ps(a.velY + i, vy);
+        }
+        integrateScalar(a, i, last, dt, screenW, screenH);
+    }
+#endif // PHYSICS_KERNEL_X86
+    
+    // Checks if the CPU can run the given kernel.
+    bool isSupported(PhysicsKernel kernel) {
+#ifdef PHYSICS_KERNEL_X86
+        // Needed because this also runs from a static initializer, before main().
+        __builtin_cpu_init();
+#endif
+        switch (kernel) {
+            case PhysicsKernel::SCALAR: return true;
+#ifdef PHYSICS_KERNEL_X86
+            case PhysicsKernel::SSE2: return __builtin_cpu_supports("sse2");
+            case PhysicsKernel::AVX2: return __builtin_cpu_supports("avx2");
+#endif
+            default: return false;
+        }
+    }
+    
+    // Returns the implementation of the given kernel.
+    KernelFunction functionFor(PhysicsKernel kernel) {
+        switch (kernel) {
+#ifdef PHYSICS_KERNEL_X86
+            case PhysicsKernel::SSE2: return integrateSSE2;
+            case PhysicsKernel::AVX2: return integrateAVX2;
+#endif
+            default: return integrateScalar;
+        }
+    }
+    
+    // Picks the fastest kernel the CPU supports.
+    PhysicsKernel detectBestKernel() {
+        if (isSupported(PhysicsKernel::AVX2)) return PhysicsKernel::AVX2;
+        if (isSupported(PhysicsKernel::SSE2)) return PhysicsKernel::SSE2;
+        return PhysicsKernel::SCALAR;
+    }
+    
+    PhysicsKernel activeKernel = detectBestKernel();
+    KernelFunction activeFunction = functionFor(activeKernel);
+}
+
+// Steps the motion of the entities in [first, last) with the active kernel.
+void integrateMotionRange(const MotionArrays& arrays, size_t first, size_t last,
+                          float deltaTime, float screenWidth, float screenHeight) {
+    activeFunction(arrays, first, last, deltaTime, screenWidth, screenHeight);
+}
+
+// Returns the kernel currently in use.
+PhysicsKernel activePhysicsKernel() {
+    return activeKernel;
+}
+
+// Switches to the given kernel if the CPU supports it.
+bool selectPhysicsKernel(PhysicsKernel kernel) {
+    if (!isSupported(kernel)) return false;
+    activeKernel = kernel;
+    activeFunction = functionFor(kernel);
+    return true;
+}
+
+// Returns a short name for the kernel.
+const char* physicsKernelName(PhysicsKernel kernel) {
+    switch (kernel) {
+        case PhysicsKernel::SSE2: return "sse2";
+        case PhysicsKernel::AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
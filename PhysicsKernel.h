@@ -0,0 +1,39 @@
+#ifndef PHYSICS_KERNEL_H
+#define PHYSICS_KERNEL_H
+
+#include <cstddef>
+
+// The MotionArrays struct points at the component arrays a motion sweep reads and writes.
+struct MotionArrays {
+    float* posX;
+    float* posY;
+    float* prevX;
+    float* prevY;
+    float* velX;
+    float* velY;
+    const float* friction;
+    const float* maxSpeed;
+    const float* width;
+    const float* height;
+};
+
+// The available implementations of the motion sweep.
+enum class PhysicsKernel {
+    SCALAR, // One entity at a time; always available.
+    SSE2,   // Four entities per instruction (x86).
+    AVX2    // Eight entities per instruction (x86 CPUs with AVX2).
+};
+
+// Steps the motion of the entities in [first, last), like integrateMotion() on each of them.
+// Every kernel produces bit-identical results; the fastest supported one is picked at startup.
+void integrateMotionRange(const MotionArrays& arrays, size_t first, size_t last,
+                          float deltaTime, float screenWidth, float screenHeight);
+
+// Returns the kernel integrateMotionRange() currently uses.
+PhysicsKernel activePhysicsKernel();
+// Switches to the given kernel. Returns false, and keeps the current one, if the CPU lacks support.
+bool selectPhysicsKernel(PhysicsKernel kernel);
+// Returns a short name for the kernel ("scalar", "sse2" or "avx2").
+const char* physicsKernelName(PhysicsKernel kernel);
+
+#endif // PHYSICS_KERNEL_H
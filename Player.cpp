@@ -1,80 +1,87 @@
 #include "Player.h"
-#include <algorithm>
+#include "Profiler.h"
+#ifndef HEADLESS_BUILD
+#include "SpriteBatch.h"
+#endif
 
-// ScreenBounds implementation
-// Updates the screen boundaries used for clamping player position.
-void ScreenBounds::update(int screenWidth, int screenHeight, float textureWidth, float textureHeight) {
-    maxX = static_cast<float>(screenWidth) - textureWidth;
-    maxY = static_cast<float>(screenHeight) - textureHeight;
-    lastWidth = screenWidth;
-    lastHeight = screenHeight;
-}
-
-// Checks if the screen dimensions have changed, requiring an update to the boundaries.
-bool ScreenBounds::needsUpdate(int screenWidth, int screenHeight) const {
-    return lastWidth != screenWidth || lastHeight != screenHeight;
+// Accelerates a velocity according to the movement input.
+void applyMovementInput(float& velX, float& velY, float speed, const InputSnapshot& input, float deltaTime) {
+    const float acceleration = speed * 25.0f;
+    const float accelDelta = acceleration * deltaTime;
+    
+    // Update velocity based on the movement input.
+    if (input.isDown(InputAction::MOVE_RIGHT)) velX += accelDelta;
+    if (input.isDown(InputAction::MOVE_LEFT))  velX -= accelDelta;
+    if (input.isDown(InputAction::MOVE_DOWN))  velY += accelDelta;
+    if (input.isDown(InputAction::MOVE_UP))    velY -= accelDelta;
 }
 
 // Player implementation
-Player::Player(float x, float y, float playerSpeed, float playerFriction, 
+Player::Player(EntityStore& entityStore, float x, float y, float playerSpeed, float playerFriction, 
                float playerMaxSpeed, Texture2D playerTexture) 
-    : position{x, y}, velocity{0.0f, 0.0f}, speed(playerSpeed), baseSpeed(playerSpeed), 
-      friction(playerFriction), maxSpeed(playerMaxSpeed), baseMaxSpeed(playerMaxSpeed), texture(playerTexture) {
+    : store(&entityStore) {
+    EntityDesc desc;
+    desc.x = x;
+    desc.y = y;
+    desc.speed = playerSpeed;
+    desc.friction = playerFriction;
+    desc.maxSpeed = playerMaxSpeed;
+    desc.width = static_cast<float>(playerTexture.width);
+    desc.height = static_cast<float>(playerTexture.height);
+    desc.texture = playerTexture;
+    handle = store->create(desc);
 }
 
 // Handles player input for movement.
-void Player::handleInput(float deltaTime, bool consoleActive) {
+void Player::handleInput(float deltaTime, const InputSnapshot& input, bool consoleActive) {
     // Disable player movement when the console is active.
     if (consoleActive) return;
-    acceleration = speed * 25.0f;
-    const float accelDelta = acceleration * deltaTime;
-    
-    // Update velocity based on keyboard input.
-    if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D)) velocity.x += accelDelta;
-    if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A))  velocity.x -= accelDelta;
-    if (IsKeyDown(KEY_DOWN) || IsKeyDown(KEY_S))  velocity.y += accelDelta;
-    if (IsKeyDown(KEY_UP) || IsKeyDown(KEY_W))    velocity.y -= accelDelta;
+    const size_t i = index();
+    applyMovementInput(store->velX[i], store->velY[i], store->speed[i], input, deltaTime);
 }
 
 // Updates the player's state, including input, physics, and position.
-void Player::update(float deltaTime, int screenWidth, int screenHeight, bool consoleActive) {
-    handleInput(deltaTime, consoleActive);
-    applyPhysics(deltaTime);
-    clampToScreen(screenWidth, screenHeight);
+void Player::update(float deltaTime, int screenWidth, int screenHeight, const InputSnapshot& input, bool consoleActive) {
+    PROFILE_ZONE("Player::update");
+    handleInput(deltaTime, input, consoleActive);
+    const size_t i = index();
+    store->integrateRange(i, i + 1, deltaTime, screenWidth, screenHeight);
 }
 
-// Applies physics to the player, including friction and velocity clamping.
-void Player::applyPhysics(float deltaTime) {
-    const float frictionDelta = friction * deltaTime;
-    
-    // Apply friction to slow down the player.
-    velocity.x -= velocity.x * frictionDelta;
-    velocity.y -= velocity.y * frictionDelta;
-    
-    // Clamp the velocity to the maximum speed.
-    velocity.x = std::clamp(velocity.x, -maxSpeed, maxSpeed);
-    velocity.y = std::clamp(velocity.y, -maxSpeed, maxSpeed);
-    
-    // Update the player's position based on the velocity.
-    position.x += velocity.x * deltaTime;
-    position.y += velocity.y * deltaTime;
+// Replaces the base tuning and scales the current speeds by the same multiplier as before.
+void Player::retune(float newBaseSpeed, float newFriction, float newBaseMaxSpeed) {
+    const size_t i = index();
+    const float multiplier = store->baseSpeed[i] > 0.0f ? store->speed[i] / store->baseSpeed[i] : 1.0f;
+    store->baseSpeed[i] = newBaseSpeed;
+    store->baseMaxSpeed[i] = newBaseMaxSpeed;
+    store->friction[i] = newFriction;
+    store->speed[i] = newBaseSpeed * multiplier;
+    store->maxSpeed[i] = newBaseMaxSpeed * multiplier;
 }
 
-// Clamps the player's position to the screen boundaries.
-void Player::clampToScreen(int screenWidth, int screenHeight) {
-    // Recalculate screen boundaries if the window size has changed.
-    if (bounds.needsUpdate(screenWidth, screenHeight)) {
-        bounds.update(screenWidth, screenHeight, 
-                     static_cast<float>(texture.width), 
-                     static_cast<float>(texture.height));
-    }
-    
-    // Clamp the player's position to stay within the screen.
-    position.x = std::clamp(position.x, 0.0f, bounds.maxX);
-    position.y = std::clamp(position.y, 0.0f, bounds.maxY);
+// Restores a previously captured state.
+// The position before the restore becomes the interpolation start, so rewinding renders smoothly.
+void Player::restoreState(const PlayerState& state) {
+    const size_t i = index();
+    store->prevX[i] = store->posX[i];
+    store->prevY[i] = store->posY[i];
+    store->posX[i] = state.position.x;
+    store->posY[i] = state.position.y;
+    store->velX[i] = state.velocity.x;
+    store->velY[i] = state.velocity.y;
+    store->speed[i] = state.speed;
+    store->maxSpeed[i] = state.maxSpeed;
 }
 
-// Draws the player on the screen.
-void Player::draw() const {
-    DrawTexture(texture, static_cast<int>(position.x), static_cast<int>(position.y), WHITE);
-}
\ No newline at end of file
+#ifndef HEADLESS_BUILD
+// Queues the player's sprite, blending the previous and current tick positions.
+void Player::draw(SpriteBatch& batch, float alpha, Color tint) const {
+    PROFILE_ZONE("Player::draw");
+    const size_t i = index();
+    const float drawX = store->prevX[i] + (store->posX[i] - store->prevX[i]) * alpha;
+    const float drawY = store->prevY[i] + (store->posY[i] - store->prevY[i]) * alpha;
+    // Snap to whole pixels, as DrawTexture did.
+    const Vector2 position = {static_cast<float>(static_cast<int>(drawX)), static_cast<float>(static_cast<int>(drawY))};
+    batch.draw(store->texture[i], position, tint, SPRITE_LAYER_PLAYER);
+}
+#endif // HEADLESS_BUILD
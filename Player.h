@@ -2,53 +2,67 @@
 #define PLAYER_H
 
 #include "raylib.h"
+#include "Input.h"
+#include "EntityStore.h"
 
-// The ScreenBounds struct holds the calculated boundaries of the screen.
-// This is used to prevent the player from moving off-screen.
-struct ScreenBounds {
-    float maxX = 0.0f; // The maximum x-coordinate the player can have.
-    float maxY = 0.0f; // The maximum y-coordinate the player can have.
-    int lastWidth = -1; // The last known screen width, used to detect changes.
-    int lastHeight = -1; // The last known screen height, used to detect changes.
-    
-    // Updates the screen boundaries.
-    void update(int screenWidth, int screenHeight, float textureWidth, float textureHeight);
-    // Checks if the screen dimensions have changed.
-    bool needsUpdate(int screenWidth, int screenHeight) const;
+class SpriteBatch;
+
+// The PlayerState struct holds the part of the player that changes during simulation.
+// It is what the rewind buffer and the timelines store for every tick.
+struct PlayerState {
+    Vector2 position; // The player's position.
+    Vector2 velocity; // The player's velocity.
+    float speed;      // The player's current movement speed.
+    float maxSpeed;   // The player's current maximum speed.
 };
 
-// The Player struct represents the player character in the game.
-// It manages the player's position, movement, and appearance.
+// Accelerates a velocity according to the movement input.
+void applyMovementInput(float& velX, float& velY, float speed, const InputSnapshot& input, float deltaTime);
+
+// The Player struct is a thin view of a player entity in an EntityStore.
+// All of its data lives in the store's component arrays; copying a Player copies the view,
+// not the entity.
 struct Player {
-    Vector2 position;    // The player's current position.
-    Vector2 velocity;    // The player's current velocity.
-    float speed;         // The player's current movement speed.
-    float baseSpeed;     // The player's base movement speed.
-    float friction;      // The friction applied to the player's movement.
-    float maxSpeed;      // The maximum speed the player can reach.
-    float baseMaxSpeed;  // The player's base maximum speed.
-    float acceleration;  // The player's acceleration.
-    Texture2D texture;   // The player's texture.
-    
-    // Cached screen boundaries to avoid recalculating them every frame.
-    mutable ScreenBounds bounds;
+    EntityStore* store;   // The store that holds the player's components.
+    EntityHandle handle;  // The player's entity.
     
-    // Player constructor.
-    Player(float x, float y, float playerSpeed, float playerFriction, 
+    // Player constructor. Creates the player's entity in the store.
+    Player(EntityStore& entityStore, float x, float y, float playerSpeed, float playerFriction, 
            float playerMaxSpeed, Texture2D playerTexture);
     
+    // Accessors for the player's components.
+    Vector2 position() const { const size_t i = index(); return {store->posX[i], store->posY[i]}; }
+    Vector2 previousPosition() const { const size_t i = index(); return {store->prevX[i], store->prevY[i]}; }
+    Vector2 velocity() const { const size_t i = index(); return {store->velX[i], store->velY[i]}; }
+    float speed() const { return store->speed[index()]; }
+    float baseSpeed() const { return store->baseSpeed[index()]; }
+    float maxSpeed() const { return store->maxSpeed[index()]; }
+    float baseMaxSpeed() const { return store->baseMaxSpeed[index()]; }
+    float friction() const { return store->friction[index()]; }
+    // Sets the player's current movement speed and maximum speed.
+    void setSpeed(float newSpeed, float newMaxSpeed) { const size_t i = index(); store->speed[i] = newSpeed; store->maxSpeed[i] = newMaxSpeed; }
+    // Replaces the player's base tuning. A speed multiplier set from the console is kept.
+    void retune(float newBaseSpeed, float newFriction, float newBaseMaxSpeed);
+    // Makes the previous position equal the current one, so a frozen player does not jitter.
+    void holdPosition() { const size_t i = index(); store->prevX[i] = store->posX[i]; store->prevY[i] = store->posY[i]; }
+    
     // Updates the player's state.
-    void update(float deltaTime, int screenWidth, int screenHeight, bool consoleActive);
+    void update(float deltaTime, int screenWidth, int screenHeight, const InputSnapshot& input, bool consoleActive);
     // Handles player input.
-    void handleInput(float deltaTime, bool consoleActive);
-    // Draws the player on the screen.
-    void draw() const;
-    
+    void handleInput(float deltaTime, const InputSnapshot& input, bool consoleActive);
+    // Returns the player's simulated state.
+    PlayerState captureState() const { return {position(), velocity(), speed(), maxSpeed()}; }
+    // Restores a previously captured state, keeping the current position as the interpolation start.
+    void restoreState(const PlayerState& state);
+#ifndef HEADLESS_BUILD
+    // Queues the player's sprite, interpolated between the last two ticks by alpha (0..1).
+    // The tint's alpha fades the sprite, for example for timeline ghosts.
+    void draw(SpriteBatch& batch, float alpha = 1.0f, Color tint = WHITE) const;
+#endif
+
 private:
-    // Applies physics to the player.
-    void applyPhysics(float deltaTime);
-    // Clamps the player's position to the screen boundaries.
-    void clampToScreen(int screenWidth, int screenHeight);
+    // Returns the player's dense index in the store.
+    size_t index() const { return store->indexOf(handle); }
 };
 
 #endif // PLAYER_H
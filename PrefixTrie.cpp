@@ -0,0 +1,122 @@
+#include "PrefixTrie.h"
+
+PrefixTrie::PrefixTrie() {
+    nodes.emplace_back(); // The root, for the empty prefix.
+}
+
+// Maps a character to its child slot. The slots follow ASCII order, so walking them in order
+// visits names alphabetically.
+int PrefixTrie::symbol(char ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch == '_') return 10;
+    if (ch >= 'a' && ch <= 'z') return 11 + (ch - 'a');
+    return -1;
+}
+
+char PrefixTrie::character(int slot) {
+    if (slot < 10) return static_cast<char>('0' + slot);
+    if (slot == 10) return '_';
+    return static_cast<char>('a' + (slot - 11));
+}
+
+// Follows a prefix down from the root.
+uint16_t PrefixTrie::walk(std::string_view prefix, bool& found) const {
+    uint16_t node = 0;
+    for (char ch : prefix) {
+        const int slot = symbol(ch);
+        if (slot < 0 || nodes[node].children[slot] == 0) {
+            found = false;
+            return 0;
+        }
+        node = nodes[node].children[slot];
+    }
+    found = true;
+    return node;
+}
+
+// Adds the nodes a name needs and counts it on every node along its path.
+bool PrefixTrie::insert(std::string_view name, int id) {
+    if (name.empty() || id < 0 || find(name) >= 0) return false;
+
+    size_t newNodes = 0;
+    uint16_t node = 0;
+    bool onExistingPath = true;
+    for (char ch : name) {
+        const int slot = symbol(ch);
+        if (slot < 0) return false;
+        if (onExistingPath && nodes[node].children[slot] != 0) {
+            node = nodes[node].children[slot];
+        } else {
+            onExistingPath = false;
+            ++newNodes;
+        }
+    }
+    if (nodes.size() + newNodes > UINT16_MAX) return false;
+
+    node = 0;
+    ++nodes[0].namesBelow;
+    for (char ch : name) {
+        const int slot = symbol(ch);
+        if (nodes[node].children[slot] == 0) {
+            nodes[node].children[slot] = static_cast<uint16_t>(nodes.size());
+            nodes.emplace_back();
+        }
+        node = nodes[node].children[slot];
+        ++nodes[node].namesBelow;
+    }
+    nodes[node].id = id;
+    ++count;
+    return true;
+}
+
+int PrefixTrie::find(std::string_view name) const {
+    bool found = false;
+    const uint16_t node = walk(name, found);
+    return found ? nodes[node].id : -1;
+}
+
+// Follows the single path below the prefix until a name ends or the names branch.
+std::string PrefixTrie::commonPrefix(std::string_view prefix) const {
+    std::string result(prefix);
+    bool found = false;
+    uint16_t node = walk(prefix, found);
+    if (!found) return result;
+
+    while (nodes[node].id < 0) {
+        int onlySlot = -1;
+        for (int slot = 0; slot < ALPHABET_SIZE; ++slot) {
+            if (nodes[node].children[slot] == 0) continue;
+            if (onlySlot >= 0) return result;
+            onlySlot = slot;
+        }
+        if (onlySlot < 0) break;
+        result += character(onlySlot);
+        node = nodes[node].children[onlySlot];
+    }
+    return result;
+}
+
+// Walks the subtree under the prefix depth first, visiting each node before its children and the
+// children in slot order, which lists the names alphabetically.
+size_t PrefixTrie::collect(std::string_view prefix, std::vector<int>& ids, size_t maxResults) const {
+    bool found = false;
+    const uint16_t start = walk(prefix, found);
+    if (!found) return 0;
+
+    std::vector<uint16_t> stack;
+    stack.push_back(start);
+    size_t appended = 0;
+    while (!stack.empty() && appended < maxResults) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+        if (node.id >= 0) {
+            ids.push_back(node.id);
+            ++appended;
+        }
+        // Pushed in reverse so the lowest slot is visited first.
+        for (int slot = ALPHABET_SIZE - 1; slot >= 0; --slot) {
+            if (node.children[slot] != 0) stack.push_back(node.children[slot]);
+        }
+    }
+    return nodes[start].namesBelow;
+}
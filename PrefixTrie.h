@@ -0,0 +1,52 @@
+#ifndef PREFIX_TRIE_H
+#define PREFIX_TRIE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The PrefixTrie class maps names to ids. Lookups and prefix searches take time proportional to
+// the name's length, however many names are stored. Names may contain lowercase letters, digits
+// and '_'; each node has a child slot for every one of those characters.
+class PrefixTrie {
+public:
+    PrefixTrie();
+
+    // Adds a name. Returns false if it contains other characters, is empty or is already present.
+    bool insert(std::string_view name, int id);
+    // Returns the id of a name, or -1 if it is not present.
+    int find(std::string_view name) const;
+    // Appends the ids of up to maxResults names starting with prefix, in alphabetical order.
+    // Returns the total number of matching names, which may be more than were appended.
+    size_t collect(std::string_view prefix, std::vector<int>& ids, size_t maxResults) const;
+    // Returns the longest prefix shared by every name that starts with prefix, or prefix itself
+    // if no name does.
+    std::string commonPrefix(std::string_view prefix) const;
+    // Returns the number of names stored.
+    size_t size() const { return count; }
+
+private:
+    static constexpr int ALPHABET_SIZE = 37; // '0'-'9', '_', 'a'-'z', in ASCII order.
+
+    // The Node struct is one character position. Child slots hold node indices, 0 for none.
+    struct Node {
+        std::array<uint16_t, ALPHABET_SIZE> children{};
+        int32_t id = -1;           // The id of the name ending here, or -1.
+        uint32_t namesBelow = 0;   // The number of names ending here or in the subtree.
+    };
+
+    // Returns a character's child slot, or -1 if names cannot contain it.
+    static int symbol(char ch);
+    // Returns the character for a child slot.
+    static char character(int slot);
+    // Returns the node a prefix leads to, or 0 (the root) with found set to false.
+    uint16_t walk(std::string_view prefix, bool& found) const;
+
+    std::vector<Node> nodes;
+    size_t count = 0;
+};
+
+#endif // PREFIX_TRIE_H
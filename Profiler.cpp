@@ -0,0 +1,121 @@
+#include "Profiler.h"
+#include "ConsoleCapture.h"
+#include <algorithm>
+#include <cstdio>
+
+// Global profiler instance initialization.
+Profiler profiler;
+
+// Profiler constructor. Allocates the whole frame history up front.
+Profiler::Profiler()
+    : epoch(std::chrono::steady_clock::now()), frames(FRAME_HISTORY) {
+    zoneNames.reserve(MAX_ZONES);
+    scratch.reserve(FRAME_HISTORY);
+    frames[0].zoneTotals.fill(0);
+}
+
+// Starts recording a new frame in the next ring slot.
+void Profiler::beginFrame() {
+    FrameRecord& frame = frames[currentFrame];
+    frame.start = now();
+    frame.end = frame.start;
+    frame.eventCount = 0;
+    frame.zoneTotals.fill(0);
+}
+
+// Finishes the current frame and advances the ring.
+void Profiler::endFrame() {
+    frames[currentFrame].end = now();
+    currentFrame = (currentFrame + 1) % FRAME_HISTORY;
+    ++completedFrames;
+    
+    if (completedFrames % STATS_INTERVAL == 0) {
+        refreshStats();
+    }
+}
+
+// Returns the id of a zone name, registering it on first use.
+uint16_t Profiler::zoneId(const char* name) {
+    for (size_t i = 0; i < zoneNames.size(); ++i) {
+        if (zoneNames[i] == name) return static_cast<uint16_t>(i);
+    }
+    if (zoneNames.size() == MAX_ZONES) {
+        consoleCapture.addLine("PROF: Too many zones, ignoring " + std::string(name));
+        return MAX_ZONES;
+    }
+    zoneNames.push_back(name);
+    return static_cast<uint16_t>(zoneNames.size() - 1);
+}
+
+// Records one run of a zone into the current frame.
+void Profiler::record(uint16_t zone, uint64_t start, uint64_t end) {
+    if (zone >= MAX_ZONES) return;
+    FrameRecord& frame = frames[currentFrame];
+    frame.zoneTotals[zone] += end - start;
+    if (frame.eventCount < MAX_EVENTS_PER_FRAME) {
+        frame.events[frame.eventCount++] = {start, end, zone};
+    }
+}
+
+// Returns the current time in nanoseconds since the profiler started.
+uint64_t Profiler::now() const {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count());
+}
+
+// Returns the duration of the frame n frames ago, in milliseconds.
+float Profiler::frameTime(size_t n) const {
+    if (n >= frameCount()) return 0.0f;
+    const FrameRecord& frame = frames[(currentFrame + FRAME_HISTORY - 1 - n) % FRAME_HISTORY];
+    return static_cast<float>(frame.end - frame.start) / 1e6f;
+}
+
+// Recomputes each zone's p50 and p99 from its per-frame totals.
+void Profiler::refreshStats() {
+    const size_t count = frameCount();
+    for (size_t zone = 0; zone < zoneNames.size(); ++zone) {
+        scratch.clear();
+        for (size_t n = 0; n < count; ++n) {
+            scratch.push_back(frames[(currentFrame + FRAME_HISTORY - 1 - n) % FRAME_HISTORY].zoneTotals[zone]);
+        }
+        const auto percentile = [this](double fraction) {
+            const size_t index = static_cast<size_t>(fraction * static_cast<double>(scratch.size() - 1));
+            std::nth_element(scratch.begin(), scratch.begin() + index, scratch.end());
+            return static_cast<float>(scratch[index]) / 1e6f;
+        };
+        stats[zone].p50 = percentile(0.50);
+        stats[zone].p99 = percentile(0.99);
+    }
+}
+
+// Writes the last frames as a Chrome trace_event JSON file (load it in chrome://tracing or Perfetto).
+bool Profiler::writeChromeTrace(const std::string& path, size_t frameLimit) const {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+    
+    const size_t count = std::min(frameLimit, frameCount());
+    std::fprintf(file, "{\"traceEvents\":[\n");
+    bool first = true;
+    // Oldest first, so the trace reads left to right.
+    for (size_t n = count; n-- > 0;) {
+        const FrameRecord& frame = frames[(currentFrame + FRAME_HISTORY - 1 - n) % FRAME_HISTORY];
+        std::fprintf(file, "%s{\"name\":\"Frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                     first ? "" : ",\n", frame.start / 1e3, (frame.end - frame.start) / 1e3);
+        first = false;
+        for (size_t e = 0; e < frame.eventCount; ++e) {
+            const ZoneEvent& event = frame.events[e];
+            std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                         zoneNames[event.zone], event.start / 1e3, (event.end - event.start) / 1e3);
+        }
+    }
+    std::fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    return std::fclose(file) == 0;
+}
+
+// ProfileZone implementation
+ProfileZone::ProfileZone(uint16_t zoneId) : zone(zoneId), start(profiler.now()) {
+}
+
+ProfileZone::~ProfileZone() {
+    profiler.record(zone, start, profiler.now());
+}
@@ -0,0 +1,107 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The Profiler class collects timings of named zones for the last few hundred frames.
+// All storage is allocated up front; recording a zone is a clock read and an array write.
+// Zones are meant to be recorded from the main thread only.
+class Profiler {
+public:
+    static constexpr size_t FRAME_HISTORY = 300;       // The number of frames kept.
+    static constexpr size_t MAX_ZONES = 32;            // The number of distinct zone names.
+    static constexpr size_t MAX_EVENTS_PER_FRAME = 128; // Zone events kept per frame for traces.
+    static constexpr size_t STATS_INTERVAL = 30;       // Frames between percentile refreshes.
+    
+    // The ZoneStats struct holds the percentiles of a zone's per-frame time, in milliseconds.
+    struct ZoneStats {
+        float p50 = 0.0f;
+        float p99 = 0.0f;
+    };
+    
+    Profiler();
+    
+    // Marks the start and end of a frame.
+    void beginFrame();
+    void endFrame();
+    
+    // Returns the id of a zone name, registering it on first use. Names must be string literals.
+    uint16_t zoneId(const char* name);
+    // Records one run of a zone, with start and end times from now().
+    void record(uint16_t zone, uint64_t start, uint64_t end);
+    // Returns the current time in nanoseconds since the profiler started.
+    uint64_t now() const;
+    
+    // Returns the number of registered zones.
+    size_t zoneCount() const { return zoneNames.size(); }
+    // Returns the name of a zone.
+    const char* zoneName(size_t zone) const { return zoneNames[zone]; }
+    // Returns the cached percentiles of a zone.
+    const ZoneStats& zoneStats(size_t zone) const { return stats[zone]; }
+    // Returns the duration of the frame n frames ago (0 is the newest complete frame), in milliseconds.
+    float frameTime(size_t n) const;
+    // Returns the number of complete frames recorded, up to FRAME_HISTORY.
+    size_t frameCount() const { return completedFrames < FRAME_HISTORY ? completedFrames : FRAME_HISTORY; }
+    
+    // Writes the last frames as a Chrome trace_event JSON file. Returns false if the file cannot be written.
+    bool writeChromeTrace(const std::string& path, size_t frames) const;
+    
+    bool overlayVisible = false; // Whether the on-screen overlay is drawn.
+
+private:
+    // The ZoneEvent struct is one run of a zone inside a frame.
+    struct ZoneEvent {
+        uint64_t start;
+        uint64_t end;
+        uint16_t zone;
+    };
+    // The FrameRecord struct holds everything recorded during one frame.
+    struct FrameRecord {
+        uint64_t start = 0;
+        uint64_t end = 0;
+        size_t eventCount = 0;
+        std::array<ZoneEvent, MAX_EVENTS_PER_FRAME> events;
+        std::array<uint64_t, MAX_ZONES> zoneTotals; // Total time per zone in this frame, in ns.
+    };
+    
+    // Recomputes the cached percentiles from the frame history.
+    void refreshStats();
+    
+    std::chrono::steady_clock::time_point epoch;
+    std::vector<FrameRecord> frames;       // A ring of FRAME_HISTORY records.
+    size_t currentFrame = 0;               // The ring slot being recorded.
+    size_t completedFrames = 0;
+    std::vector<const char*> zoneNames;
+    std::array<ZoneStats, MAX_ZONES> stats{};
+    std::vector<uint64_t> scratch;         // Reused when computing percentiles.
+};
+
+// The ProfileZone class records the time between its construction and destruction.
+class ProfileZone {
+public:
+    explicit ProfileZone(uint16_t zoneId);
+    ~ProfileZone();
+    
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    uint16_t zone;
+    uint64_t start;
+};
+
+// A global instance of the Profiler class that can be accessed from anywhere in the application.
+extern Profiler profiler;
+
+// Times the rest of the enclosing scope as the named zone. The name is registered once per call site.
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) \
+    static const uint16_t PROFILE_CONCAT(profileZoneId, __LINE__) = profiler.zoneId(name); \
+    ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(PROFILE_CONCAT(profileZoneId, __LINE__))
+
+#endif // PROFILER_H
@@ -0,0 +1,246 @@
+#include "RewindBuffer.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace {
+    // The number of 32-bit fields in a PlayerState.
+    constexpr size_t FIELD_COUNT = 6;
+    // Record kinds, stored in the first byte of every record.
+    constexpr uint8_t RECORD_KEYFRAME = 0;
+    constexpr uint8_t RECORD_DELTA = 1;
+    // Delta records: kind byte, three bytes of per-field lengths, then the XOR bytes.
+    constexpr size_t DELTA_HEADER_SIZE = 4;
+    
+    // Flattens a state into its raw field bits, so deltas are exact.
+    void toBits(const PlayerState& state, uint32_t bits[FIELD_COUNT]) {
+        const float fields[FIELD_COUNT] = {
+            state.position.x, state.position.y, state.velocity.x, state.velocity.y, state.speed, state.maxSpeed
+        };
+        std::memcpy(bits, fields, sizeof(fields));
+    }
+    
+    // Rebuilds a state from its raw field bits.
+    PlayerState fromBits(const uint32_t bits[FIELD_COUNT]) {
+        float fields[FIELD_COUNT];
+        std::memcpy(fields, bits, sizeof(fields));
+        return {{fields[0], fields[1]}, {fields[2], fields[3]}, fields[4], fields[5]};
+    }
+    
+    // The SavedRing struct is the fixed part of a saved history. It is followed by the index
+    // entries of the held ticks and then their records, both oldest first.
+    struct SavedRing {
+        uint64_t count;
+        uint64_t usedBytes;
+        uint64_t ticksSinceKeyframe;
+        uint32_t keyframeBits[FIELD_COUNT];
+        uint32_t reserved[2];
+    };
+    
+    // Returns how many low bytes are needed to hold the value (0 when it is zero).
+    uint8_t significantBytes(uint32_t value) {
+        uint8_t n = 0;
+        while (value != 0) {
+            ++n;
+            value >>= 8;
+        }
+        return n;
+    }
+}
+
+// RewindBuffer constructor.
+// A quarter of the budget goes to the per-tick index, the rest to the encoded records.
+RewindBuffer::RewindBuffer(size_t memoryBytes, int interval) {
+    const size_t budget = std::max<size_t>(memoryBytes, 4096);
+    indexCapacity = (budget / 4) / sizeof(IndexEntry);
+    bytes.resize(budget - indexCapacity * sizeof(IndexEntry));
+    index.resize(indexCapacity);
+    
+    // Keep several keyframe groups in the history, so eviction never empties it.
+    keyframeInterval = std::clamp(interval, 1, static_cast<int>(std::min<size_t>(indexCapacity / 4, 0xFFFF)));
+}
+
+// Appends the state for the current tick.
+void RewindBuffer::record(const PlayerState& state) {
+    const bool keyframe = count == 0 || ticksSinceKeyframe + 1 >= static_cast<size_t>(keyframeInterval);
+    const size_t size = encode(state, keyframe);
+    
+    // Make room, both in the index and in the byte ring.
+    while (count > 0 && (count == indexCapacity || usedBytes + size > bytes.size())) {
+        evictOldest();
+    }
+    
+    // Copy the record into the ring, wrapping around the end if needed.
+    const size_t firstPart = std::min(size, bytes.size() - writeOffset);
+    std::memcpy(&bytes[writeOffset], scratch, firstPart);
+    std::memcpy(&bytes[0], scratch + firstPart, size - firstPart);
+    
+    index[head] = {static_cast<uint32_t>(writeOffset), static_cast<uint16_t>(size),
+                   static_cast<uint16_t>(keyframe ? 0 : ticksSinceKeyframe + 1)};
+    writeOffset = (writeOffset + size) % bytes.size();
+    usedBytes += size;
+    head = (head + 1) % indexCapacity;
+    ++count;
+    ticksSinceKeyframe = keyframe ? 0 : ticksSinceKeyframe + 1;
+}
+
+// Drops the newest tick and returns the state before it.
+bool RewindBuffer::rewind(PlayerState& state) {
+    if (count < 2) return false;
+    
+    // Pop the newest record; the ring is LIFO at the head, so its bytes are simply released.
+    head = slotFromNewest(0);
+    usedBytes -= index[head].size;
+    writeOffset = index[head].offset;
+    --count;
+    
+    // The new newest tick becomes the reference for future deltas.
+    const IndexEntry& newest = index[slotFromNewest(0)];
+    ticksSinceKeyframe = newest.keyframeBack;
+    toBits(decode(slotFromNewest(newest.keyframeBack)), keyframeBits);
+    state = decode(slotFromNewest(0));
+    return true;
+}
+
+// Forgets the whole history.
+void RewindBuffer::clear() {
+    head = 0;
+    count = 0;
+    writeOffset = 0;
+    usedBytes = 0;
+    ticksSinceKeyframe = 0;
+}
+
+// Encodes a state into scratch: either all fields, or the XOR against the keyframe
+// trimmed to its significant bytes. Nearby floats share their high bytes, so deltas stay small.
+size_t RewindBuffer::encode(const PlayerState& state, bool keyframe) {
+    uint32_t bits[FIELD_COUNT];
+    toBits(state, bits);
+    
+    if (keyframe) {
+        scratch[0] = RECORD_KEYFRAME;
+        std::memcpy(scratch + 1, bits, sizeof(bits));
+        std::memcpy(keyframeBits, bits, sizeof(bits));
+        return 1 + sizeof(bits);
+    }
+    
+    scratch[0] = RECORD_DELTA;
+    scratch[1] = scratch[2] = scratch[3] = 0;
+    size_t size = DELTA_HEADER_SIZE;
+    for (size_t i = 0; i < FIELD_COUNT; ++i) {
+        uint32_t delta = bits[i] ^ keyframeBits[i];
+        const uint8_t length = significantBytes(delta);
+        scratch[1 + i / 2] |= static_cast<uint8_t>(length << ((i % 2) * 4));
+        for (uint8_t b = 0; b < length; ++b) {
+            scratch[size++] = static_cast<uint8_t>(delta);
+            delta >>= 8;
+        }
+    }
+    return size;
+}
+
+// Decodes the record at the given index slot, resolving deltas against their keyframe.
+PlayerState RewindBuffer::decode(size_t slot) const {
+    const IndexEntry& entry = index[slot];
+    
+    // Gather the record out of the ring.
+    uint8_t record[sizeof(scratch)];
+    const size_t firstPart = std::min<size_t>(entry.size, bytes.size() - entry.offset);
+    std::memcpy(record, &bytes[entry.offset], firstPart);
+    std::memcpy(record + firstPart, &bytes[0], entry.size - firstPart);
+    
+    uint32_t bits[FIELD_COUNT];
+    if (record[0] == RECORD_KEYFRAME) {
+        std::memcpy(bits, record + 1, sizeof(bits));
+        return fromBits(bits);
+    }
+    
+    // Deltas are always relative to a keyframe, so this recursion is at most one level deep.
+    const size_t keyframeSlot = (slot + indexCapacity - entry.keyframeBack) % indexCapacity;
+    toBits(decode(keyframeSlot), bits);
+    size_t pos = DELTA_HEADER_SIZE;
+    for (size_t i = 0; i < FIELD_COUNT; ++i) {
+        const uint8_t length = (record[1 + i / 2] >> ((i % 2) * 4)) & 0x0F;
+        uint32_t delta = 0;
+        for (uint8_t b = 0; b < length; ++b) {
+            delta |= static_cast<uint32_t>(record[pos++]) << (8 * b);
+        }
+        bits[i] ^= delta;
+    }
+    return fromBits(bits);
+}
+
+// Removes the oldest tick. Deltas are useless without their keyframe,
+// so eviction continues until the oldest remaining tick is a keyframe.
+void RewindBuffer::evictOldest() {
+    do {
+        const size_t tail = slotFromNewest(count - 1);
+        usedBytes -= index[tail].size;
+        --count;
+    } while (count > 0 && index[slotFromNewest(count - 1)].keyframeBack != 0);
+}
+
+// Returns the size of the held ticks as written by saveTo.
+size_t RewindBuffer::savedSize() const {
+    return sizeof(SavedRing) + count * sizeof(IndexEntry) + usedBytes;
+}
+
+// The held records are contiguous in the byte ring, starting at the oldest one, so they are
+// copied out in at most two pieces with their offsets made relative to it.
+void RewindBuffer::saveTo(uint8_t* out) const {
+    SavedRing ring{count, usedBytes, ticksSinceKeyframe, {}, {}};
+    std::memcpy(ring.keyframeBits, keyframeBits, sizeof(keyframeBits));
+    std::memcpy(out, &ring, sizeof(ring));
+    out += sizeof(ring);
+    if (count == 0) return;
+    
+    const size_t oldest = slotFromNewest(count - 1);
+    const uint32_t oldestOffset = index[oldest].offset;
+    const uint32_t ringSize = static_cast<uint32_t>(bytes.size());
+    const size_t firstEntries = std::min(count, indexCapacity - oldest);
+    std::memcpy(out, &index[oldest], firstEntries * sizeof(IndexEntry));
+    std::memcpy(out + firstEntries * sizeof(IndexEntry), &index[0], (count - firstEntries) * sizeof(IndexEntry));
+    for (size_t k = 0; k < count; ++k) {
+        uint8_t* field = out + k * sizeof(IndexEntry) + offsetof(IndexEntry, offset);
+        uint32_t offset;
+        std::memcpy(&offset, field, sizeof(offset));
+        offset = offset >= oldestOffset ? offset - oldestOffset : offset + ringSize - oldestOffset;
+        std::memcpy(field, &offset, sizeof(offset));
+    }
+    out += count * sizeof(IndexEntry);
+    const size_t firstPart = std::min(usedBytes, bytes.size() - oldestOffset);
+    std::memcpy(out, &bytes[oldestOffset], firstPart);
+    std::memcpy(out + firstPart, &bytes[0], usedBytes - firstPart);
+}
+
+// The ticks are laid out from the start of both rings. Every one is checked before anything is
+// replaced, so a bad history cannot make a later rewind read outside the rings.
+bool RewindBuffer::loadFrom(const uint8_t* data, size_t size) {
+    SavedRing ring;
+    if (size < sizeof(ring)) return false;
+    std::memcpy(&ring, data, sizeof(ring));
+    if (ring.count > indexCapacity || ring.usedBytes > bytes.size() || (ring.count == 0 && ring.usedBytes != 0) ||
+        size != sizeof(ring) + ring.count * sizeof(IndexEntry) + ring.usedBytes) {
+        return false;
+    }
+    
+    const uint8_t* entries = data + sizeof(ring);
+    for (size_t k = 0; k < ring.count; ++k) {
+        IndexEntry entry;
+        std::memcpy(&entry, entries + k * sizeof(IndexEntry), sizeof(entry));
+        if (entry.size == 0 || entry.size > sizeof(scratch) || entry.offset + entry.size > ring.usedBytes ||
+            entry.keyframeBack > k) {
+            return false;
+        }
+    }
+    
+    std::memcpy(index.data(), entries, ring.count * sizeof(IndexEntry));
+    std::memcpy(bytes.data(), entries + ring.count * sizeof(IndexEntry), ring.usedBytes);
+    count = ring.count;
+    head = count % indexCapacity;
+    usedBytes = ring.usedBytes;
+    writeOffset = usedBytes % bytes.size();
+    ticksSinceKeyframe = ring.ticksSinceKeyframe;
+    std::memcpy(keyframeBits, ring.keyframeBits, sizeof(keyframeBits));
+    return true;
+}
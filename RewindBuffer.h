@@ -0,0 +1,68 @@
+#ifndef REWIND_BUFFER_H
+#define REWIND_BUFFER_H
+
+#include "Player.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The RewindBuffer class keeps a bounded history of player states, one per tick.
+// States are stored as full keyframes every few ticks and as XOR deltas against the
+// latest keyframe in between, packed into a fixed-size byte ring. Recording and
+// rewinding are O(1) per tick and all memory is allocated up front, within the cap.
+class RewindBuffer {
+public:
+    // Allocates the history within memoryBytes, with a keyframe every keyframeInterval ticks.
+    RewindBuffer(size_t memoryBytes, int keyframeInterval);
+    
+    // Appends the state for the current tick, evicting the oldest ticks when the memory is full.
+    void record(const PlayerState& state);
+    // Drops the newest tick and returns the state before it. Returns false if no older state is left.
+    bool rewind(PlayerState& state);
+    // Forgets the whole history.
+    void clear();
+    
+    // Returns the number of ticks currently held.
+    size_t tickCount() const { return count; }
+    // Returns the number of bytes used by the encoded history.
+    size_t bytesUsed() const { return usedBytes; }
+    
+    // Returns the size of the history as written by saveTo.
+    size_t savedSize() const;
+    // Writes the held ticks to out (savedSize() bytes), so saving costs what the history holds.
+    void saveTo(uint8_t* out) const;
+    // Replaces the history with one written by saveTo. Returns false, leaving the history
+    // unchanged, if it does not fit in this buffer's memory or is malformed.
+    bool loadFrom(const uint8_t* data, size_t size);
+
+private:
+    // The IndexEntry struct locates one encoded tick in the byte ring.
+    struct IndexEntry {
+        uint32_t offset;       // The byte offset of the record in the ring.
+        uint16_t size;         // The size of the record in bytes.
+        uint16_t keyframeBack; // How many ticks back its keyframe is (0 for a keyframe).
+    };
+    
+    // Encodes a state into scratch and returns the record size.
+    size_t encode(const PlayerState& state, bool keyframe);
+    // Decodes the record at the given index slot.
+    PlayerState decode(size_t slot) const;
+    // Removes the oldest tick, along with any deltas that depended on it.
+    void evictOldest();
+    // Returns the index slot of the tick that is n ticks older than the newest.
+    size_t slotFromNewest(size_t n) const { return (head + indexCapacity - 1 - n) % indexCapacity; }
+    
+    std::vector<uint8_t> bytes;      // The encoded records, used as a ring.
+    std::vector<IndexEntry> index;   // One entry per tick, used as a ring.
+    size_t indexCapacity;
+    int keyframeInterval;
+    size_t head = 0;                 // The index slot for the next tick.
+    size_t count = 0;                // The number of ticks held.
+    size_t writeOffset = 0;          // The byte offset for the next record.
+    size_t usedBytes = 0;            // The bytes held by live records.
+    size_t ticksSinceKeyframe = 0;   // The number of deltas since the newest keyframe.
+    uint32_t keyframeBits[6] = {};   // The newest keyframe's fields, as raw bits.
+    uint8_t scratch[32] = {};        // The record being encoded.
+};
+
+#endif // REWIND_BUFFER_H
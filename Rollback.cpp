@@ -0,0 +1,284 @@
+#include "Rollback.h"
+#include "ConsoleCapture.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <thread>
+
+namespace {
+    // Packet identification, and the size of the fixed part before the inputs.
+    constexpr uint32_t NET_MAGIC = 0x504e5854; // "TXNP" in little-endian order.
+    constexpr size_t NET_HEADER_SIZE = 33;
+    constexpr size_t NET_INPUT_SIZE = 4;
+    static_assert(NET_HEADER_SIZE + NET_INPUTS_PER_PACKET * NET_INPUT_SIZE <= NET_MAX_PACKET,
+                  "A full packet must fit in one datagram");
+
+    // Little-endian helpers, so peers agree on the packet layout whatever the platform.
+    void putU16(uint8_t*& out, uint16_t value) {
+        out[0] = static_cast<uint8_t>(value);
+        out[1] = static_cast<uint8_t>(value >> 8);
+        out += 2;
+    }
+
+    void putU32(uint8_t*& out, uint32_t value) {
+        putU16(out, static_cast<uint16_t>(value));
+        putU16(out, static_cast<uint16_t>(value >> 16));
+    }
+
+    void putU64(uint8_t*& out, uint64_t value) {
+        putU32(out, static_cast<uint32_t>(value));
+        putU32(out, static_cast<uint32_t>(value >> 32));
+    }
+
+    uint16_t getU16(const uint8_t*& in) {
+        const uint16_t value = static_cast<uint16_t>(in[0] | (in[1] << 8));
+        in += 2;
+        return value;
+    }
+
+    uint32_t getU32(const uint8_t*& in) {
+        const uint32_t lo = getU16(in);
+        return lo | (static_cast<uint32_t>(getU16(in)) << 16);
+    }
+
+    uint64_t getU64(const uint8_t*& in) {
+        const uint64_t lo = getU32(in);
+        return lo | (static_cast<uint64_t>(getU32(in)) << 32);
+    }
+
+    // Hashes the players' states bitwise (FNV-1a), so peers can compare them exactly.
+    uint64_t hashPlayers(const std::array<PlayerState, NET_PLAYERS>& players) {
+        uint64_t hash = 14695981039346656037ull;
+        for (const PlayerState& state : players) {
+            const auto* bytes = reinterpret_cast<const unsigned char*>(&state);
+            for (size_t b = 0; b < sizeof(PlayerState); ++b) {
+                hash = (hash ^ bytes[b]) * 1099511628211ull;
+            }
+        }
+        return hash;
+    }
+
+    // Returns the part of an input that is sent to the peer. Typed text stays local.
+    InputSnapshot networkedInput(const InputSnapshot& input) {
+        InputSnapshot sent;
+        sent.down = input.down;
+        sent.pressed = input.pressed;
+        return sent;
+    }
+
+    // Predicts a missing remote input: held actions stay held, and presses are not repeated.
+    InputSnapshot predictInput(const InputSnapshot& last) {
+        InputSnapshot predicted;
+        predicted.down = last.down;
+        return predicted;
+    }
+}
+
+// RollbackSession implementation
+// The ticks before the first delayed input have no input from either player, so they count as
+// confirmed from the start.
+RollbackSession::RollbackSession(const std::array<Player, NET_PLAYERS>& sessionPlayers, int local,
+                                 const GameConfig& config, float delta, UdpTransport& netTransport)
+    : players(sessionPlayers), localPlayer(local), tickDelta(delta), screenWidth(config.screenWidth),
+      screenHeight(config.screenHeight), inputDelay(std::clamp(config.netInputDelay, 0, NET_MAX_INPUT_DELAY)),
+      rollbackWindow(std::clamp(config.netRollbackTicks, 1, ROLLBACK_MAX_WINDOW)), transport(netTransport),
+      localQueued(inputDelay), remoteConfirmed(inputDelay - 1), remoteAck(inputDelay),
+      rollbackFrom(std::numeric_limits<long long>::max()), started(std::chrono::steady_clock::now()) {
+}
+
+bool RollbackSession::connect(double timeoutSeconds) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeoutSeconds);
+    while (std::chrono::steady_clock::now() < deadline) {
+        sendInputs();
+        transport.flush();
+        if (receivePackets() > 0) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+// Stalls when predicting the next tick would go past the rollback window, or when the peer has
+// fallen so far behind on our input that unacknowledged inputs would leave the ring.
+bool RollbackSession::advance(const InputSnapshot& localInput) {
+    synchronize();
+    if (tick - remoteConfirmed > rollbackWindow || localQueued - remoteAck >= ROLLBACK_HISTORY) {
+        ++counters.stalls;
+        sendInputs();
+        return false;
+    }
+
+    inputs[localPlayer][slot(localQueued)] = networkedInput(localInput);
+    ++localQueued;
+    sendInputs();
+    if (tick > remoteConfirmed) ++counters.predictedTicks;
+    simulateTick();
+    finalizeStates();
+    return true;
+}
+
+void RollbackSession::poll() {
+    synchronize();
+    sendInputs();
+}
+
+uint64_t RollbackSession::checksum() const {
+    std::array<PlayerState, NET_PLAYERS> states;
+    for (int p = 0; p < NET_PLAYERS; ++p) states[p] = players[p].captureState();
+    return hashPlayers(states);
+}
+
+uint64_t RollbackSession::checksumAt(long long atTick) const {
+    const SavedTick& state = saved[slot(atTick)];
+    return atTick <= finalTick && state.tick == atTick ? state.checksum : 0;
+}
+
+void RollbackSession::synchronize() {
+    transport.flush();
+    receivePackets();
+    if (rollbackFrom < tick) {
+        rollback(rollbackFrom);
+    }
+    rollbackFrom = std::numeric_limits<long long>::max();
+    finalizeStates();
+    checkRemoteChecksum();
+}
+
+// A tick with no remote input yet is simulated with the prediction, which is kept in the input
+// ring so the real input can be compared with it when it arrives.
+void RollbackSession::simulateTick() {
+    SavedTick& state = saved[slot(tick)];
+    state.tick = tick;
+    for (int p = 0; p < NET_PLAYERS; ++p) state.players[p] = players[p].captureState();
+
+    if (tick > remoteConfirmed) {
+        const InputSnapshot last = remoteConfirmed >= 0 ? inputs[remotePlayer()][slot(remoteConfirmed)] : InputSnapshot();
+        inputs[remotePlayer()][slot(tick)] = predictInput(last);
+    }
+    for (int p = 0; p < NET_PLAYERS; ++p) {
+        players[p].update(tickDelta, screenWidth, screenHeight, inputs[p][slot(tick)], false);
+    }
+    ++tick;
+}
+
+void RollbackSession::rollback(long long fromTick) {
+    PROFILE_ZONE("RollbackSession::rollback");
+    const auto start = std::chrono::steady_clock::now();
+    const long long target = tick;
+    const SavedTick& state = saved[slot(fromTick)];
+    for (int p = 0; p < NET_PLAYERS; ++p) players[p].restoreState(state.players[p]);
+    tick = fromTick;
+    while (tick < target) simulateTick();
+
+    const double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    ++counters.rollbacks;
+    counters.resimulatedTicks += static_cast<uint64_t>(target - fromTick);
+    counters.longestRollback = std::max(counters.longestRollback, target - fromTick);
+    counters.resimulationMicros += micros;
+    counters.worstResimulationMicros = std::max(counters.worstResimulationMicros, micros);
+}
+
+// The state before a tick is final once every input before it is confirmed. It is checksummed
+// then, since no rollback can change it any more.
+void RollbackSession::finalizeStates() {
+    const long long last = std::min(remoteConfirmed + 1, tick - 1);
+    while (finalTick < last) {
+        ++finalTick;
+        SavedTick& state = saved[slot(finalTick)];
+        state.checksum = hashPlayers(state.players);
+    }
+}
+
+int RollbackSession::receivePackets() {
+    std::array<uint8_t, NET_MAX_PACKET> packet;
+    int count = 0;
+    while (const size_t size = transport.receive(packet.data(), packet.size())) {
+        handlePacket(packet.data(), size);
+        ++count;
+    }
+    return count;
+}
+
+// Inputs are taken in tick order only. A packet always starts at the first input we were missing
+// when the peer sent it, so reordered or duplicate packets just repeat inputs already known.
+void RollbackSession::handlePacket(const uint8_t* data, size_t size) {
+    if (size < NET_HEADER_SIZE) return;
+    const uint8_t* in = data;
+    if (getU32(in) != NET_MAGIC) return;
+    const long long ack = static_cast<int32_t>(getU32(in));
+    const uint32_t sendMs = getU32(in);
+    const uint32_t echoMs = getU32(in);
+    const long long checksumTick = static_cast<int32_t>(getU32(in));
+    const uint64_t peerChecksum = getU64(in);
+    const long long firstTick = static_cast<int32_t>(getU32(in));
+    const size_t count = *in++;
+    if (size < NET_HEADER_SIZE + count * NET_INPUT_SIZE) return;
+
+    remoteAck = std::max(remoteAck, ack);
+    if (static_cast<int32_t>(sendMs - lastRemoteSendMs) > 0) lastRemoteSendMs = sendMs;
+    if (echoMs != 0) counters.roundTripMs = static_cast<double>(static_cast<int32_t>(elapsedMs() - echoMs));
+    if (checksumTick > remoteChecksumTick && checksumTick > checkedTick) {
+        remoteChecksumTick = checksumTick;
+        remoteChecksum = peerChecksum;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const long long inputTick = firstTick + static_cast<long long>(i);
+        InputSnapshot input;
+        input.down = getU16(in);
+        input.pressed = getU16(in);
+        if (inputTick <= remoteConfirmed) continue;
+        if (inputTick != remoteConfirmed + 1) break;
+
+        InputSnapshot& stored = inputs[remotePlayer()][slot(inputTick)];
+        if (inputTick < tick) {
+            ++counters.lateInputs;
+            counters.lateTicks += static_cast<uint64_t>(tick - inputTick);
+            if (stored != input) rollbackFrom = std::min(rollbackFrom, inputTick);
+        }
+        stored = input;
+        remoteConfirmed = inputTick;
+    }
+}
+
+void RollbackSession::sendInputs() {
+    std::array<uint8_t, NET_MAX_PACKET> packet;
+    uint8_t* out = packet.data();
+    const long long count = std::min<long long>(localQueued - remoteAck, NET_INPUTS_PER_PACKET);
+    putU32(out, NET_MAGIC);
+    putU32(out, static_cast<uint32_t>(remoteConfirmed + 1));
+    putU32(out, elapsedMs());
+    putU32(out, lastRemoteSendMs);
+    putU32(out, static_cast<uint32_t>(finalTick));
+    putU64(out, checksumAt(finalTick));
+    putU32(out, static_cast<uint32_t>(remoteAck));
+    *out++ = static_cast<uint8_t>(std::max(0LL, count));
+    for (long long i = 0; i < count; ++i) {
+        const InputSnapshot& input = inputs[localPlayer][slot(remoteAck + i)];
+        putU16(out, input.down);
+        putU16(out, input.pressed);
+    }
+    transport.send(packet.data(), static_cast<size_t>(out - packet.data()));
+}
+
+// A peer's checksum can only be compared once we have confirmed the same tick, and while that
+// tick is still in the ring.
+void RollbackSession::checkRemoteChecksum() {
+    if (remoteChecksumTick < 0 || remoteChecksumTick > finalTick) return;
+    const SavedTick& state = saved[slot(remoteChecksumTick)];
+    if (state.tick == remoteChecksumTick && state.checksum != remoteChecksum) {
+        if (counters.desyncs++ == 0) {
+            counters.firstDesyncTick = remoteChecksumTick;
+            consoleCapture.addLine("NET: Desync at tick " + std::to_string(remoteChecksumTick) +
+                                   ", the peers' states differ");
+        }
+    }
+    checkedTick = remoteChecksumTick;
+    remoteChecksumTick = -1;
+}
+
+// Offset by one, so a zero echo can mean that no packet has arrived yet.
+uint32_t RollbackSession::elapsedMs() const {
+    const auto elapsed = std::chrono::steady_clock::now() - started;
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()) + 1;
+}
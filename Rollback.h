@@ -0,0 +1,138 @@
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+
+#include "Player.h"
+#include "GameConfig.h"
+#include "UdpTransport.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+// Constants for rollback sessions.
+constexpr int NET_PLAYERS = 2;                 // The number of players in a session.
+constexpr int ROLLBACK_HISTORY = 64;           // The ticks of saved states and inputs kept. Must be a power of two.
+constexpr int ROLLBACK_MAX_WINDOW = 16;        // The most ticks net_rollback_ticks may allow the remote input to be predicted.
+constexpr int NET_MAX_INPUT_DELAY = 8;         // The most ticks net_input_delay may hold back local input.
+constexpr int NET_INPUTS_PER_PACKET = 32;      // The most inputs one packet carries.
+static_assert((ROLLBACK_HISTORY & (ROLLBACK_HISTORY - 1)) == 0, "ROLLBACK_HISTORY must be a power of two");
+static_assert(2 * (ROLLBACK_MAX_WINDOW + NET_MAX_INPUT_DELAY) <= ROLLBACK_HISTORY,
+              "The history must hold every tick that can still be rolled back to or received early");
+
+// The RollbackStats struct counts what a session did, for reporting.
+struct RollbackStats {
+    uint64_t rollbacks = 0;          // The number of times a wrong prediction was rolled back.
+    uint64_t resimulatedTicks = 0;   // The ticks simulated again after rollbacks.
+    long long longestRollback = 0;   // The most ticks a single rollback went back.
+    double resimulationMicros = 0.0; // The time spent rolling back and resimulating.
+    double worstResimulationMicros = 0.0; // The longest single rollback.
+    uint64_t predictedTicks = 0;     // The ticks first simulated with a predicted remote input.
+    uint64_t lateInputs = 0;         // The remote inputs that arrived after their tick was simulated.
+    uint64_t lateTicks = 0;          // The ticks by which those inputs were late, summed.
+    uint64_t stalls = 0;             // The ticks skipped because the remote player fell too far behind.
+    uint64_t desyncs = 0;            // The confirmed ticks whose state differed from the peer's.
+    long long firstDesyncTick = -1;  // The first of those ticks, or -1.
+    double roundTripMs = 0.0;        // The last measured round trip time.
+};
+
+// The RollbackSession class runs a two-player simulation in step with a peer, without waiting for
+// the peer's input. Each tick, the local input is sent for a tick a few ticks ahead (the input
+// delay), and the remote player's missing input is predicted to be the last one received, held.
+// The state before every tick is saved in a ring. When a remote input arrives that differs from
+// its prediction, the session restores the state before that tick and simulates forward again to
+// the present, all within the same frame. If the remote input falls more ticks behind than the
+// rollback window, the session stalls instead of predicting further.
+//
+// Both peers must run the same build with the same config, so a tick with the same inputs gives
+// bit-identical results. Every packet also carries a checksum of the latest state both inputs are
+// known for, which the peer compares with its own to detect a desync.
+//
+// Only the players' movement is networked. The title screen, console and rewind stay local.
+class RollbackSession {
+public:
+    // Creates a session for the players, which must be in their starting state. localPlayer is
+    // this peer's index into them. The input delay and rollback window come from the config.
+    RollbackSession(const std::array<Player, NET_PLAYERS>& players, int localPlayer, const GameConfig& config,
+                    float tickDelta, UdpTransport& transport);
+
+    // Sends until a packet from the peer arrives or the timeout runs out. Returns whether it did.
+    bool connect(double timeoutSeconds);
+    // Reads packets and rolls back if needed, then queues the local input for the tick input
+    // delay ticks ahead and simulates the next tick. Returns false, without using the input, if
+    // the session stalled because the remote input is too far behind.
+    bool advance(const InputSnapshot& localInput);
+    // Reads packets, rolls back if needed and resends unacknowledged input, without simulating.
+    void poll();
+
+    // Returns the next tick to simulate.
+    long long currentTick() const { return tick; }
+    // Returns the tick the next local input is queued for.
+    long long inputTick() const { return localQueued; }
+    // Returns the last tick whose remote input is known.
+    long long remoteConfirmedTick() const { return remoteConfirmed; }
+    // Returns the last tick of local input the peer has acknowledged.
+    long long localAcknowledgedTick() const { return remoteAck - 1; }
+    // Returns the checksum of the players' current state.
+    uint64_t checksum() const;
+    // Returns the checksum of the state before a tick, or 0 if that state is not final or no
+    // longer in the ring.
+    uint64_t checksumAt(long long atTick) const;
+    // Returns the session's counters.
+    const RollbackStats& stats() const { return counters; }
+
+private:
+    // The SavedTick struct is the state of every player before a tick.
+    struct SavedTick {
+        long long tick = -1;
+        std::array<PlayerState, NET_PLAYERS> players{};
+        uint64_t checksum = 0;
+    };
+
+    // Returns the ring slot for a tick.
+    static size_t slot(long long atTick) { return static_cast<size_t>(atTick) & (ROLLBACK_HISTORY - 1); }
+    // Returns the remote player's index.
+    int remotePlayer() const { return 1 - localPlayer; }
+
+    // Reads packets, rolls back if a prediction was wrong and checks the peer's checksum.
+    void synchronize();
+    // Saves the state before the current tick, picks the remote input and simulates the tick.
+    void simulateTick();
+    // Restores the state before a tick and simulates forward to the current tick again.
+    void rollback(long long fromTick);
+    // Checksums the saved states that can no longer change.
+    void finalizeStates();
+    // Reads every waiting packet. Returns the number read.
+    int receivePackets();
+    // Applies one packet from the peer.
+    void handlePacket(const uint8_t* data, size_t size);
+    // Sends the local inputs the peer has not acknowledged, with the latest checksum.
+    void sendInputs();
+    // Compares the peer's checksum with ours once we have reached its tick.
+    void checkRemoteChecksum();
+    // Returns the milliseconds since the session started, wrapped to 32 bits.
+    uint32_t elapsedMs() const;
+
+    std::array<Player, NET_PLAYERS> players;
+    int localPlayer;
+    float tickDelta;
+    int screenWidth, screenHeight;
+    int inputDelay;
+    int rollbackWindow;
+    UdpTransport& transport;
+
+    std::array<SavedTick, ROLLBACK_HISTORY> saved;
+    std::array<std::array<InputSnapshot, ROLLBACK_HISTORY>, NET_PLAYERS> inputs; // Inputs by player and tick.
+    long long tick = 0;             // The next tick to simulate.
+    long long localQueued;          // The next tick to queue a local input for.
+    long long remoteConfirmed;      // The last tick whose remote input is known.
+    long long remoteAck = 0;        // The first tick of local input the peer is missing.
+    long long rollbackFrom;         // The earliest tick that was simulated with a wrong prediction.
+    long long finalTick = -1;       // The last tick whose saved state can no longer change.
+    long long remoteChecksumTick = -1; // The tick of the peer's newest checksum not yet compared.
+    uint64_t remoteChecksum = 0;
+    long long checkedTick = -1;     // The last tick whose checksum was compared.
+    uint32_t lastRemoteSendMs = 0;  // The peer's clock on the newest packet, echoed back for the round trip.
+    std::chrono::steady_clock::time_point started;
+    RollbackStats counters;
+};
+
+#endif // ROLLBACK_H
@@ -0,0 +1,548 @@
+#include "SaveState.h"
+#include "ConsoleCapture.h"
+#include "MappedFile.h"
+#include "StateHash.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <cstdio>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // File identification. The byte order mark is written as a native integer, so a file from a
+    // machine of the other endianness, whose columns cannot be read in place, is recognized.
+    constexpr char SAVE_MAGIC[4] = {'T', 'X', 'S', 'V'};
+    constexpr uint32_t SAVE_BYTE_ORDER = 0x01020304;
+
+    // Section encodings.
+    constexpr uint32_t SECTION_RAW = 0;
+    constexpr uint32_t SECTION_LZ = 1;  // Compressed with compressBlock.
+
+    // Block compression: a sequence is a token byte holding the literal count and the match
+    // length less MIN_MATCH in its high and low four bits (15 means more length bytes follow,
+    // each added until one is below 255), the literals, then a two-byte distance back to the
+    // match. The last sequence has literals only.
+    constexpr size_t MIN_MATCH = 4;
+    constexpr size_t MAX_DISTANCE = 0xFFFF;
+    constexpr int MATCH_HASH_BITS = 14;
+
+    // The largest section a save may hold, to reject corrupt sizes before allocating.
+    constexpr uint64_t MAX_SECTION_BYTES = 1ull << 32;
+
+    // The SaveHeader struct starts every save file.
+    struct SaveHeader {
+        char magic[4];
+        uint32_t byteOrder;
+        uint16_t version;
+        uint16_t sectionCount;
+        uint32_t tickRate;      // The tick rate the state was simulated at.
+        uint64_t tick;          // The number of ticks simulated before the state was captured.
+        uint64_t fileSize;
+        uint32_t checksum;      // hashBytes of everything after the header.
+        uint32_t reserved;
+    };
+
+    // The SaveSection struct locates one named section in the file. Sections are found by name,
+    // so a build can skip sections it does not know and fill in ones an older save lacks.
+    struct SaveSection {
+        char name[24];          // Zero-padded.
+        uint32_t encoding;
+        uint32_t reserved;
+        uint64_t offset;        // From the start of the file, a multiple of SAVE_SECTION_ALIGN.
+        uint64_t storedSize;    // The bytes in the file.
+        uint64_t size;          // The bytes once decoded.
+    };
+    static_assert(sizeof(SaveHeader) == 40 && sizeof(SaveSection) == 56, "The save layout must not depend on padding");
+    static_assert(std::is_trivially_copyable_v<SaveHeader> && std::is_trivially_copyable_v<SaveSection>);
+
+    // The SavedGameState struct is the "game" section.
+    struct SavedGameState {
+        uint32_t currentState;
+        uint32_t consoleVisible;
+        uint32_t rewinding;
+        uint32_t reserved;
+    };
+
+    // The EntityColumn struct maps an entity component to its section. A save from before a
+    // component existed fills it from the fallback section instead.
+    struct EntityColumn {
+        const char* name;
+        std::vector<float> EntityStore::* member;
+        const char* fallback;
+    };
+
+    constexpr EntityColumn ENTITY_COLUMNS[] = {
+        {"entity.pos_x", &EntityStore::posX, nullptr},
+        {"entity.pos_y", &EntityStore::posY, nullptr},
+        {"entity.prev_x", &EntityStore::prevX, "entity.pos_x"},
+        {"entity.prev_y", &EntityStore::prevY, "entity.pos_y"},
+        {"entity.vel_x", &EntityStore::velX, nullptr},
+        {"entity.vel_y", &EntityStore::velY, nullptr},
+        {"entity.speed", &EntityStore::speed, nullptr},
+        {"entity.base_speed", &EntityStore::baseSpeed, "entity.speed"},
+        {"entity.max_speed", &EntityStore::maxSpeed, nullptr},
+        {"entity.base_max_speed", &EntityStore::baseMaxSpeed, "entity.max_speed"},
+        {"entity.friction", &EntityStore::friction, nullptr},
+        {"entity.width", &EntityStore::width, nullptr},
+        {"entity.height", &EntityStore::height, nullptr},
+    };
+    constexpr size_t ENTITY_COLUMN_COUNT = std::size(ENTITY_COLUMNS);
+    // The entity columns, then the game state, the console input box and the rewind history.
+    constexpr size_t SAVE_SECTION_COUNT = ENTITY_COLUMN_COUNT + 3;
+
+    // The LoadedSection struct is a section of a loaded file, decoded if it was compressed.
+    struct LoadedSection {
+        std::string_view name;
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    // Logs a save error to both stderr and the in-game console.
+    void logSaveError(const std::string& message) {
+        std::cerr << message << '\n';
+        consoleCapture.addLine(message);
+    }
+
+    size_t alignSection(size_t offset) {
+        return (offset + SAVE_SECTION_ALIGN - 1) & ~(SAVE_SECTION_ALIGN - 1);
+    }
+
+    uint32_t read32(const uint8_t* data) {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    // Appends a length that did not fit in its four token bits.
+    void putLength(std::vector<uint8_t>& out, size_t length) {
+        for (; length >= 255; length -= 255) out.push_back(255);
+        out.push_back(static_cast<uint8_t>(length));
+    }
+
+    // Appends one sequence: literals, then a match unless distance is 0.
+    void putSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount, size_t distance,
+                     size_t matchLength) {
+        const size_t matchCode = distance > 0 ? matchLength - MIN_MATCH : 0;
+        out.push_back(static_cast<uint8_t>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(matchCode, 15)));
+        if (literalCount >= 15) putLength(out, literalCount - 15);
+        out.insert(out.end(), literals, literals + literalCount);
+        if (distance == 0) return;
+        out.push_back(static_cast<uint8_t>(distance));
+        out.push_back(static_cast<uint8_t>(distance >> 8));
+        if (matchCode >= 15) putLength(out, matchCode - 15);
+    }
+
+    // Appends data compressed as LZ77 sequences, finding matches through a table of the last
+    // position each four-byte hash was seen at. Returns false, appending nothing, if that would
+    // not be smaller than the data itself.
+    bool compressBlock(const uint8_t* data, size_t size, std::vector<uint32_t>& table, std::vector<uint8_t>& out) {
+        const size_t start = out.size();
+        table.assign(size_t{1} << MATCH_HASH_BITS, 0);
+        size_t anchor = 0;
+        for (size_t i = 0; i + MIN_MATCH <= size;) {
+            const uint32_t word = read32(data + i);
+            uint32_t& slot = table[(word * 2654435761u) >> (32 - MATCH_HASH_BITS)];
+            const size_t candidate = slot;
+            slot = static_cast<uint32_t>(i);
+            if (candidate >= i || i - candidate > MAX_DISTANCE || read32(data + candidate) != word) {
+                ++i;
+                continue;
+            }
+            size_t length = MIN_MATCH;
+            while (i + length < size && data[candidate + length] == data[i + length]) ++length;
+            putSequence(out, data + anchor, i - anchor, i - candidate, length);
+            i += length;
+            anchor = i;
+            if (out.size() - start >= size) break;
+        }
+        putSequence(out, data + anchor, size - anchor, 0, 0);
+        if (out.size() - start >= size) {
+            out.resize(start);
+            return false;
+        }
+        return true;
+    }
+
+    // Reads a length continued past its four token bits. Returns false if the data ends first.
+    bool getLength(const uint8_t* data, size_t size, size_t& in, size_t& length) {
+        uint8_t more;
+        do {
+            if (in >= size) return false;
+            more = data[in++];
+            length += more;
+        } while (more == 255);
+        return true;
+    }
+
+    // Decompresses a block into exactly outSize bytes. Returns false if it does not decode to that.
+    bool decompressBlock(const uint8_t* data, size_t size, uint8_t* out, size_t outSize) {
+        size_t in = 0, written = 0;
+        while (in < size) {
+            const uint8_t token = data[in++];
+            size_t literalCount = token >> 4;
+            if (literalCount == 15 && !getLength(data, size, in, literalCount)) return false;
+            if (literalCount > size - in || literalCount > outSize - written) return false;
+            std::memcpy(out + written, data + in, literalCount);
+            in += literalCount;
+            written += literalCount;
+            if (in == size) break;
+
+            if (size - in < 2) return false;
+            const size_t distance = data[in] | (data[in + 1] << 8);
+            in += 2;
+            size_t matchLength = token & 0x0F;
+            if (matchLength == 15 && !getLength(data, size, in, matchLength)) return false;
+            matchLength += MIN_MATCH;
+            if (distance == 0 || distance > written || matchLength > outSize - written) return false;
+            // Byte by byte, since a match may overlap the bytes it produces.
+            for (size_t b = 0; b < matchLength; ++b, ++written) out[written] = out[written - distance];
+        }
+        return written == outSize;
+    }
+
+    // Compresses each section of an image that shrinks, and fills in the size and checksum.
+    void encodeSave(const std::vector<uint8_t>& image, std::vector<uint32_t>& table, std::vector<uint8_t>& out) {
+        SaveHeader header;
+        std::memcpy(&header, image.data(), sizeof(header));
+        const size_t tableSize = header.sectionCount * sizeof(SaveSection);
+        out.assign(image.begin(), image.begin() + static_cast<std::ptrdiff_t>(sizeof(header) + tableSize));
+
+        for (size_t i = 0; i < header.sectionCount; ++i) {
+            SaveSection section;
+            uint8_t* entry = out.data() + sizeof(header) + i * sizeof(SaveSection);
+            std::memcpy(&section, entry, sizeof(section));
+            out.resize(alignSection(out.size()), 0);
+            const uint8_t* data = image.data() + section.offset;
+            section.offset = out.size();
+            if (compressBlock(data, section.size, table, out)) {
+                section.encoding = SECTION_LZ;
+            } else {
+                section.encoding = SECTION_RAW;
+                out.insert(out.end(), data, data + section.size);
+            }
+            section.storedSize = out.size() - section.offset;
+            std::memcpy(out.data() + sizeof(header) + i * sizeof(SaveSection), &section, sizeof(section));
+        }
+
+        header.fileSize = out.size();
+        header.checksum = hashBytes(out.data() + sizeof(header), out.size() - sizeof(header));
+        std::memcpy(out.data(), &header, sizeof(header));
+    }
+
+    // Writes a file next to path, flushes it to the disk and renames it over path, so path always
+    // holds either the old or the new contents in full.
+    bool writeFileDurably(const std::string& path, const std::vector<uint8_t>& data) {
+        const std::string temporary = path + ".tmp";
+#ifdef _WIN32
+        FILE* file = std::fopen(temporary.c_str(), "wb");
+        if (file == nullptr) return false;
+        bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+        written = std::fflush(file) == 0 && written;
+        written = _commit(_fileno(file)) == 0 && written;
+        written = std::fclose(file) == 0 && written;
+#else
+        const int file = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (file < 0) return false;
+        bool written = true;
+        for (size_t done = 0; written && done < data.size();) {
+            const ssize_t count = ::write(file, data.data() + done, data.size() - done);
+            written = count > 0;
+            done += written ? static_cast<size_t>(count) : 0;
+        }
+        written = ::fsync(file) == 0 && written;
+        written = ::close(file) == 0 && written;
+#endif
+        std::error_code error;
+        if (!written) {
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+        std::filesystem::rename(temporary, path, error);
+        if (error) return false;
+#ifndef _WIN32
+        // Flush the directory too, so the rename itself survives a power loss.
+        std::string directory = std::filesystem::path(path).parent_path().string();
+        if (directory.empty()) directory = ".";
+        const int handle = ::open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+        if (handle >= 0) {
+            ::fsync(handle);
+            ::close(handle);
+        }
+#endif
+        return true;
+    }
+
+    // Finds a section by name, or returns nullptr.
+    const LoadedSection* findSection(const std::vector<LoadedSection>& sections, std::string_view name) {
+        for (const LoadedSection& section : sections) {
+            if (section.name == name) return &section;
+        }
+        return nullptr;
+    }
+
+    // Finds the section for an entity column, or the one it is migrated from.
+    const LoadedSection* findColumn(const std::vector<LoadedSection>& sections, const EntityColumn& column) {
+        const LoadedSection* section = findSection(sections, column.name);
+        if (section == nullptr && column.fallback != nullptr) section = findSection(sections, column.fallback);
+        return section;
+    }
+}
+
+// Lays out the header, the section table and the sections, then copies the state in. Only the
+// padding between sections is cleared, since everything else is overwritten.
+void captureSave(SaveImage& image, const EntityStore& entities, const GameState& gameState,
+                 const ConsoleInput& consoleInput, const RewindBuffer& rewindBuffer, uint64_t tick, int tickRate) {
+    SaveSection sections[SAVE_SECTION_COUNT] = {};
+    const auto setName = [](SaveSection& section, std::string_view name) {
+        std::memcpy(section.name, name.data(), std::min(name.size(), sizeof(section.name) - 1));
+    };
+    for (size_t i = 0; i < ENTITY_COLUMN_COUNT; ++i) {
+        setName(sections[i], ENTITY_COLUMNS[i].name);
+        sections[i].size = entities.size() * sizeof(float);
+    }
+    setName(sections[ENTITY_COLUMN_COUNT], "game");
+    sections[ENTITY_COLUMN_COUNT].size = sizeof(SavedGameState);
+    setName(sections[ENTITY_COLUMN_COUNT + 1], "console");
+    sections[ENTITY_COLUMN_COUNT + 1].size = 2 * sizeof(uint32_t) + consoleInput.text.size();
+    setName(sections[ENTITY_COLUMN_COUNT + 2], "rewind");
+    sections[ENTITY_COLUMN_COUNT + 2].size = rewindBuffer.savedSize();
+
+    size_t offset = sizeof(SaveHeader) + sizeof(sections);
+    for (SaveSection& section : sections) {
+        section.encoding = SECTION_RAW;
+        section.offset = alignSection(offset);
+        section.storedSize = section.size;
+        offset = section.offset + section.size;
+    }
+    image.bytes.resize(offset);
+    image.capturedTick = tick;
+    uint8_t* out = image.bytes.data();
+
+    SaveHeader header{};
+    std::memcpy(header.magic, SAVE_MAGIC, sizeof(SAVE_MAGIC));
+    header.byteOrder = SAVE_BYTE_ORDER;
+    header.version = SAVE_VERSION;
+    header.sectionCount = static_cast<uint16_t>(SAVE_SECTION_COUNT);
+    header.tickRate = static_cast<uint32_t>(tickRate);
+    header.tick = tick;
+    header.fileSize = offset;
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(out + sizeof(header), sections, sizeof(sections));
+    size_t end = sizeof(header) + sizeof(sections);
+    for (const SaveSection& section : sections) {
+        std::memset(out + end, 0, section.offset - end);
+        end = section.offset + section.size;
+    }
+
+    for (size_t i = 0; i < ENTITY_COLUMN_COUNT; ++i) {
+        std::memcpy(out + sections[i].offset, (entities.*ENTITY_COLUMNS[i].member).data(), sections[i].size);
+    }
+    const SavedGameState game{static_cast<uint32_t>(gameState.currentState), gameState.consoleVisible,
+                              gameState.rewinding, 0};
+    std::memcpy(out + sections[ENTITY_COLUMN_COUNT].offset, &game, sizeof(game));
+    const uint32_t console[] = {static_cast<uint32_t>(consoleInput.cursorPosition), consoleInput.active};
+    uint8_t* consoleOut = out + sections[ENTITY_COLUMN_COUNT + 1].offset;
+    std::memcpy(consoleOut, console, sizeof(console));
+    std::memcpy(consoleOut + sizeof(console), consoleInput.text.data(), consoleInput.text.size());
+    rewindBuffer.saveTo(out + sections[ENTITY_COLUMN_COUNT + 2].offset);
+}
+
+// Everything is checked before the simulation is touched. Saves from older versions are migrated
+// section by section: entity components they lack are filled from their fallbacks, and sections
+// this build does not know are skipped.
+bool loadSave(const std::string& path, EntityStore& entities, GameState& gameState, ConsoleInput& consoleInput,
+              RewindBuffer& rewindBuffer, uint64_t& tick) {
+    MappedFile file;
+    if (!file.open(path)) {
+        logSaveError("SAVE: Failed to open " + path);
+        return false;
+    }
+    const auto invalid = [&path](const std::string& reason) {
+        logSaveError("SAVE: " + path + " " + reason);
+        return false;
+    };
+
+    SaveHeader header;
+    if (file.size() < sizeof(header)) return invalid("is not a save file");
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, SAVE_MAGIC, sizeof(SAVE_MAGIC)) != 0) return invalid("is not a save file");
+    if (header.byteOrder != SAVE_BYTE_ORDER) return invalid("was saved on a machine with a different byte order");
+    if (header.version == 0 || header.version > SAVE_VERSION) {
+        return invalid("has format version " + std::to_string(header.version) + ", this build reads up to " +
+                       std::to_string(SAVE_VERSION));
+    }
+    const size_t tableEnd = sizeof(header) + header.sectionCount * sizeof(SaveSection);
+    if (header.fileSize != file.size() || tableEnd > file.size() ||
+        hashBytes(file.data() + sizeof(header), file.size() - sizeof(header)) != header.checksum) {
+        return invalid("is truncated or corrupt");
+    }
+
+    // Point each section into the mapping, or decode it into one shared buffer.
+    std::vector<SaveSection> table(header.sectionCount);
+    std::memcpy(table.data(), file.data() + sizeof(header), table.size() * sizeof(SaveSection));
+    size_t decodedBytes = 0;
+    for (SaveSection& section : table) {
+        section.name[sizeof(section.name) - 1] = '\0';
+        const bool known = section.encoding == SECTION_RAW || section.encoding == SECTION_LZ;
+        if (!known || section.offset > file.size() || section.storedSize > file.size() - section.offset ||
+            section.size > MAX_SECTION_BYTES || (section.encoding == SECTION_RAW && section.storedSize != section.size)) {
+            return invalid("has a bad section table");
+        }
+        if (section.encoding == SECTION_LZ) decodedBytes += static_cast<size_t>(section.size);
+    }
+    std::vector<uint8_t> decoded(decodedBytes);
+    std::vector<LoadedSection> sections;
+    size_t decodedOffset = 0;
+    for (const SaveSection& section : table) {
+        LoadedSection loaded;
+        loaded.name = section.name;
+        loaded.size = static_cast<size_t>(section.size);
+        loaded.data = file.data() + section.offset;
+        if (section.encoding == SECTION_LZ) {
+            if (!decompressBlock(loaded.data, static_cast<size_t>(section.storedSize), decoded.data() + decodedOffset,
+                            loaded.size)) {
+                return invalid("has a corrupt section " + std::string(loaded.name));
+            }
+            loaded.data = decoded.data() + decodedOffset;
+            decodedOffset += loaded.size;
+        }
+        sections.push_back(loaded);
+    }
+
+    // Check every section the state needs.
+    const LoadedSection* positions = findSection(sections, ENTITY_COLUMNS[0].name);
+    if (positions == nullptr || positions->size == 0 || positions->size % sizeof(float) != 0) {
+        return invalid("holds no entities");
+    }
+    const size_t entityCount = positions->size / sizeof(float);
+    for (const EntityColumn& column : ENTITY_COLUMNS) {
+        const LoadedSection* section = findColumn(sections, column);
+        if (section == nullptr || section->size != positions->size) {
+            return invalid("is missing " + std::string(column.name));
+        }
+    }
+    const LoadedSection* game = findSection(sections, "game");
+    SavedGameState savedGame{};
+    if (game == nullptr || game->size != sizeof(savedGame)) return invalid("is missing the game state");
+    std::memcpy(&savedGame, game->data, sizeof(savedGame));
+    if (savedGame.currentState > static_cast<uint32_t>(GameStateType::PAUSED)) return invalid("has an unknown game state");
+    const LoadedSection* console = findSection(sections, "console");
+    uint32_t savedConsole[2] = {};
+    if (console == nullptr || console->size < sizeof(savedConsole)) return invalid("is missing the console input");
+    std::memcpy(savedConsole, console->data, sizeof(savedConsole));
+
+    // Apply it. New entities reuse the first entity's texture, since textures are not saved.
+    entities.resize(entityCount);
+    for (const EntityColumn& column : ENTITY_COLUMNS) {
+        std::memcpy((entities.*column.member).data(), findColumn(sections, column)->data, positions->size);
+    }
+
+    gameState.currentState = static_cast<GameStateType>(savedGame.currentState);
+    gameState.consoleVisible = savedGame.consoleVisible != 0;
+    gameState.rewinding = savedGame.rewinding != 0;
+    consoleInput.text.assign(reinterpret_cast<const char*>(console->data) + sizeof(savedConsole),
+                             console->size - sizeof(savedConsole));
+    consoleInput.cursorPosition = std::min(static_cast<int>(savedConsole[0]), static_cast<int>(consoleInput.text.size()));
+    consoleInput.active = savedConsole[1] != 0;
+
+    const LoadedSection* rewind = findSection(sections, "rewind");
+    if (rewind == nullptr || !rewindBuffer.loadFrom(rewind->data, rewind->size)) {
+        rewindBuffer.clear();
+        consoleCapture.addLine("SAVE: The saved rewind history does not fit in rewind_memory_kb and is dropped");
+    }
+    tick = header.tick;
+    consoleCapture.addLine("SAVE: Loaded tick " + std::to_string(header.tick) + " from " + path + " (" +
+                           std::to_string(header.tickRate) + " ticks per second)");
+    return true;
+}
+
+// AutoSaver implementation
+AutoSaver::~AutoSaver() {
+    stop();
+}
+
+bool AutoSaver::save(const std::string& path, const EntityStore& entities, const GameState& gameState,
+                     const ConsoleInput& consoleInput, const RewindBuffer& rewindBuffer, uint64_t tick, int tickRate) {
+    if (busy) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++counters.skipped;
+        return false;
+    }
+    if (!writer.joinable()) {
+        stopping = false;
+        writer = std::thread(&AutoSaver::writeLoop, this);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    captureSave(queued, entities, gameState, consoleInput, rewindBuffer, tick, tickRate);
+    const double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queuedPath = path;
+        counters.lastCaptureMicros = micros;
+        counters.worstCaptureMicros = std::max(counters.worstCaptureMicros, micros);
+        busy = true;
+    }
+    wake.notify_one();
+    return true;
+}
+
+void AutoSaver::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return !busy; });
+}
+
+// The writer finishes a queued save before it sees the stop.
+void AutoSaver::stop() {
+    if (!writer.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+}
+
+SaveStats AutoSaver::stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+// The lock is only held to pick up a save and to report it, never during the write.
+void AutoSaver::writeLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this] { return busy || stopping; });
+        if (!busy) return;
+        const std::string path = queuedPath;
+        lock.unlock();
+
+        const auto start = std::chrono::steady_clock::now();
+        encodeSave(queued.data(), matchTable, encoded);
+        const bool written = writeFileDurably(path, encoded);
+        const double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (!written) logSaveError("SAVE: Failed to write " + path);
+
+        lock.lock();
+        if (written) {
+            ++counters.written;
+            counters.lastWriteMillis = millis;
+            counters.lastFileBytes = encoded.size();
+            counters.lastImageBytes = queued.data().size();
+        } else {
+            ++counters.failed;
+        }
+        busy = false;
+        idle.notify_all();
+    }
+}
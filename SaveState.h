@@ -0,0 +1,114 @@
+#ifndef SAVE_STATE_H
+#define SAVE_STATE_H
+
+#include "EntityStore.h"
+#include "GameState.h"
+#include "RewindBuffer.h"
+#include "UIRenderer.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Constants for save states.
+constexpr uint16_t SAVE_VERSION = 1;       // The save format written by this build. Older ones are migrated on load.
+constexpr size_t SAVE_SECTION_ALIGN = 64;  // The alignment of every section in the file, so columns can be read in place.
+
+// The SaveImage class is a captured simulation state, laid out exactly like an uncompressed save
+// file: a header, a table of named sections and the sections themselves. Capturing reuses the
+// buffer, so once it has grown to fit, a capture allocates nothing.
+class SaveImage {
+public:
+    // Returns the captured bytes.
+    const std::vector<uint8_t>& data() const { return bytes; }
+    // Returns the tick the state was captured at.
+    uint64_t tick() const { return capturedTick; }
+
+private:
+    friend void captureSave(SaveImage& image, const EntityStore& entities, const GameState& gameState,
+                            const ConsoleInput& consoleInput, const RewindBuffer& rewindBuffer, uint64_t tick,
+                            int tickRate);
+
+    std::vector<uint8_t> bytes;
+    uint64_t capturedTick = 0;
+};
+
+// Captures everything updateGame reads and writes into an image: the entity components except the
+// textures, the game state, the console input box and the rewind history. Only copies, so it can
+// run between two ticks without a hitch.
+void captureSave(SaveImage& image, const EntityStore& entities, const GameState& gameState,
+                 const ConsoleInput& consoleInput, const RewindBuffer& rewindBuffer, uint64_t tick, int tickRate);
+
+// Loads a save file into the simulation. The file is mapped rather than read, checked against its
+// checksum, and its sections are copied straight into place; only compressed sections are
+// decoded. The store gains or loses entities to match the save, and new entities take the first
+// entity's texture, so the first entity (the player) keeps its handle.
+// A rewind history too large for the current rewind memory is dropped. Returns false, leaving the
+// simulation unchanged, if the file is missing, corrupt or from a newer build.
+bool loadSave(const std::string& path, EntityStore& entities, GameState& gameState, ConsoleInput& consoleInput,
+              RewindBuffer& rewindBuffer, uint64_t& tick);
+
+// The SaveStats struct describes the saves an AutoSaver has made.
+struct SaveStats {
+    uint64_t written = 0;          // The saves written to disk.
+    uint64_t skipped = 0;          // The saves skipped because the previous one was still being written.
+    uint64_t failed = 0;           // The saves that could not be written.
+    double lastCaptureMicros = 0.0; // The time the last capture took on the calling thread.
+    double worstCaptureMicros = 0.0; // The longest capture.
+    double lastWriteMillis = 0.0;  // The time the writer thread spent on the last save.
+    uint64_t lastFileBytes = 0;    // The size of the last save file.
+    uint64_t lastImageBytes = 0;   // The size of the last save before compression.
+};
+
+// The AutoSaver class writes save files without stalling the caller. save() captures the state
+// into an image and hands it to a writer thread, which compresses the sections that shrink,
+// writes a temporary file, flushes it to disk and renames it over the old save, so a crash mid-write
+// leaves the previous save intact. While a save is being written, further saves are skipped rather
+// than queued, so the caller never waits for the disk.
+class AutoSaver {
+public:
+    AutoSaver() = default;
+    ~AutoSaver();
+
+    AutoSaver(const AutoSaver&) = delete;
+    AutoSaver& operator=(const AutoSaver&) = delete;
+
+    // Captures the state and queues it to be written to path. Starts the writer thread on first
+    // use. Returns false, without capturing, if the previous save is still being written.
+    bool save(const std::string& path, const EntityStore& entities, const GameState& gameState,
+              const ConsoleInput& consoleInput, const RewindBuffer& rewindBuffer, uint64_t tick, int tickRate);
+    // Waits until the save in progress, if any, is on disk.
+    void wait();
+    // Finishes the save in progress and stops the writer thread.
+    void stop();
+    // Checks if a save is being written.
+    bool isBusy() const { return busy; }
+    // Returns the counters so far.
+    SaveStats stats();
+
+private:
+    // Runs on the writer thread until stop().
+    void writeLoop();
+
+    std::thread writer;
+    std::atomic<bool> busy{false};  // Whether queued holds a save the writer has not finished.
+    // The caller fills queued only while the writer is idle, and the writer reads it only while busy.
+    SaveImage queued;
+
+    // Shared with the writer thread, guarded by mutex.
+    std::mutex mutex;
+    std::condition_variable wake;   // Wakes the writer for a new save or stop().
+    std::condition_variable idle;   // Wakes wait() when a save is done.
+    bool stopping = false;
+    std::string queuedPath;
+    SaveStats counters;
+
+    // Only the writer thread touches these.
+    std::vector<uint8_t> encoded;   // The compressed file.
+    std::vector<uint32_t> matchTable; // The compressor's hash table.
+};
+
+#endif // SAVE_STATE_H
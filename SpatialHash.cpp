@@ -0,0 +1,284 @@
+#include "SpatialHash.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Mixes cell coordinates into a table position.
+    uint32_t hashCell(int32_t x, int32_t y) {
+        uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        return static_cast<uint32_t>(key);
+    }
+
+    // Checks if two boxes overlap. Boxes that only touch do not.
+    template <typename BoxA, typename BoxB>
+    bool overlaps(const BoxA& a, const BoxB& b) {
+        return a.minX < b.maxX && b.minX < a.maxX && a.minY < b.maxY && b.minY < a.maxY;
+    }
+}
+
+// SpatialHash implementation
+SpatialHash::SpatialHash(float cellSize)
+    : cellSize(cellSize), inverseCellSize(1.0f / cellSize) {
+    rehash(64);
+}
+
+SpatialHash::Entry SpatialHash::boxOf(const EntityStore& store, size_t index) {
+    return {store.posX[index], store.posY[index], store.posX[index] + store.width[index],
+            store.posY[index] + store.height[index], static_cast<uint32_t>(index)};
+}
+
+int32_t SpatialHash::cellCoordinate(float position) const {
+    return static_cast<int32_t>(std::floor(position * inverseCellSize));
+}
+
+uint32_t SpatialHash::findCell(int32_t x, int32_t y) const {
+    const uint32_t mask = static_cast<uint32_t>(table.size() - 1);
+    for (uint32_t slot = hashCell(x, y) & mask;; slot = (slot + 1) & mask) {
+        const Slot& stored = table[slot];
+        if (stored.cell == 0) return UINT32_MAX;
+        if (stored.x == x && stored.y == y) return stored.cell - 1;
+    }
+}
+
+// New cells start with only their spare entries, at the end of the entry array.
+uint32_t SpatialHash::findOrAddCell(int32_t x, int32_t y) {
+    const uint32_t found = findCell(x, y);
+    if (found != UINT32_MAX) return found;
+
+    if ((cells.size() + 1) * 2 > table.size()) {
+        rehash(cells.size() + 1);
+    }
+    const uint32_t index = static_cast<uint32_t>(cells.size());
+    cells.push_back({x, y, static_cast<uint32_t>(entries.size()), 0, SPATIAL_CELL_SLACK, 0.0f, 0.0f, 0.0f, 0.0f});
+    entries.resize(entries.size() + SPATIAL_CELL_SLACK);
+
+    const uint32_t mask = static_cast<uint32_t>(table.size() - 1);
+    uint32_t slot = hashCell(x, y) & mask;
+    while (table[slot].cell != 0) slot = (slot + 1) & mask;
+    table[slot] = {x, y, index + 1};
+    return index;
+}
+
+// Keeps the table at most half full, so probe runs stay short.
+void SpatialHash::rehash(size_t minimumCells) {
+    size_t capacity = 64;
+    while (capacity < minimumCells * 2) capacity *= 2;
+    table.assign(capacity, Slot{0, 0, 0});
+    const uint32_t mask = static_cast<uint32_t>(capacity - 1);
+    for (uint32_t i = 0; i < cells.size(); ++i) {
+        uint32_t slot = hashCell(cells[i].x, cells[i].y) & mask;
+        while (table[slot].cell != 0) slot = (slot + 1) & mask;
+        table[slot] = {cells[i].x, cells[i].y, i + 1};
+    }
+}
+
+void SpatialHash::setReach(float width, float height) {
+    maxWidth = width;
+    maxHeight = height;
+    reachX = std::max(1, static_cast<int32_t>(std::ceil(maxWidth * inverseCellSize)));
+    reachY = std::max(1, static_cast<int32_t>(std::ceil(maxHeight * inverseCellSize)));
+}
+
+// Counts the entities per cell, then gives each cell its entries plus spare ones, row by row so
+// cells that are neighbours on screen are mostly neighbours in memory.
+void SpatialHash::rebuild(const EntityStore& store) {
+    const size_t count = store.size();
+    cells.clear();
+    entries.clear();
+    rehash(std::max<size_t>(64, count / 2));
+    cellOf.resize(count);
+    entryOf.resize(count);
+
+    float widest = 0.0f, tallest = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        const Entry box = boxOf(store, i);
+        widest = std::max(widest, box.maxX - box.minX);
+        tallest = std::max(tallest, box.maxY - box.minY);
+        const uint32_t cell = findOrAddCell(cellCoordinate((box.minX + box.maxX) * 0.5f),
+                                            cellCoordinate((box.minY + box.maxY) * 0.5f));
+        cellOf[i] = cell;
+        ++cells[cell].count;
+    }
+    setReach(widest, tallest);
+
+    // The cells are renumbered in row order, which is also the order of their entries, so walking
+    // the cells walks memory forwards and a cell's right-hand neighbour is usually the next one.
+    order.resize(cells.size());
+    for (uint32_t i = 0; i < cells.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return cells[a].y != cells[b].y ? cells[a].y < cells[b].y : cells[a].x < cells[b].x;
+    });
+    sortedCells.resize(cells.size());
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        Cell& cell = sortedCells[i];
+        cell = cells[order[i]];
+        cell.start = next;
+        cell.capacity = cell.count + SPATIAL_CELL_SLACK;
+        cell.count = 0;
+        next += cell.capacity;
+        cells[order[i]].start = i;   // The old cell now only records its new index.
+    }
+    for (size_t i = 0; i < count; ++i) cellOf[i] = cells[cellOf[i]].start;
+    cells.swap(sortedCells);
+    rehash(cells.size());
+    entries.resize(next);
+    for (size_t i = 0; i < count; ++i) {
+        Cell& cell = cells[cellOf[i]];
+        entryOf[i] = cell.start + cell.count++;
+        entries[entryOf[i]] = boxOf(store, i);
+    }
+    updateBounds();
+    wastedEntries = 0;
+    ++rebuilds;
+}
+
+// Refreshes every entity's box, moving the ones that crossed into another cell.
+void SpatialHash::update(const EntityStore& store) {
+    const size_t count = store.size();
+    // A changed entity count means dense indices moved. Too many dead cells or wasted entries
+    // make queries slower than a fresh layout would be.
+    if (count != cellOf.size() || wastedEntries > count + 64 || cells.size() > count * 2 + 64) {
+        rebuild(store);
+        return;
+    }
+
+    float widest = 0.0f, tallest = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        const Entry box = boxOf(store, i);
+        widest = std::max(widest, box.maxX - box.minX);
+        tallest = std::max(tallest, box.maxY - box.minY);
+        const int32_t x = cellCoordinate((box.minX + box.maxX) * 0.5f);
+        const int32_t y = cellCoordinate((box.minY + box.maxY) * 0.5f);
+        const Cell& cell = cells[cellOf[i]];
+        if (cell.x == x && cell.y == y) {
+            entries[entryOf[i]] = box;
+        } else {
+            moveEntity(static_cast<uint32_t>(i), findOrAddCell(x, y), box);
+        }
+    }
+    setReach(widest, tallest);
+    updateBounds();
+}
+
+// Reads the entries in memory order, so it costs little next to the per-entity work.
+void SpatialHash::updateBounds() {
+    for (Cell& cell : cells) {
+        cell.minX = cell.minY = INFINITY;
+        cell.maxX = cell.maxY = -INFINITY;
+        for (uint32_t i = cell.start; i < cell.start + cell.count; ++i) {
+            cell.minX = std::min(cell.minX, entries[i].minX);
+            cell.minY = std::min(cell.minY, entries[i].minY);
+            cell.maxX = std::max(cell.maxX, entries[i].maxX);
+            cell.maxY = std::max(cell.maxY, entries[i].maxY);
+        }
+    }
+}
+
+// Fills the entity's old entry with the last entry of its cell, then appends it to the new cell.
+void SpatialHash::moveEntity(uint32_t entity, uint32_t toCell, const Entry& box) {
+    Cell& from = cells[cellOf[entity]];
+    const uint32_t hole = entryOf[entity];
+    const uint32_t last = from.start + --from.count;
+    if (hole != last) {
+        entries[hole] = entries[last];
+        entryOf[entries[hole].entity] = hole;
+    }
+
+    if (cells[toCell].count == cells[toCell].capacity) {
+        growCell(toCell);
+    }
+    Cell& to = cells[toCell];
+    const uint32_t slot = to.start + to.count++;
+    entries[slot] = box;
+    cellOf[entity] = toCell;
+    entryOf[entity] = slot;
+}
+
+void SpatialHash::growCell(uint32_t index) {
+    Cell& cell = cells[index];
+    const uint32_t start = static_cast<uint32_t>(entries.size());
+    entries.resize(entries.size() + cell.capacity * 2);
+    for (uint32_t i = 0; i < cell.count; ++i) {
+        entries[start + i] = entries[cell.start + i];
+        entryOf[entries[start + i].entity] = start + i;
+    }
+    wastedEntries += cell.capacity;
+    cell.start = start;
+    cell.capacity *= 2;
+}
+
+// Looks through the cells whose entities could reach into the region.
+size_t SpatialHash::queryRegion(const Rectangle& region, std::vector<uint32_t>& found) const {
+    const Entry query = {region.x, region.y, region.x + region.width, region.y + region.height, 0};
+    const size_t before = found.size();
+    const auto scanCell = [&](const Cell& cell) {
+        if (!overlaps(cell, query)) return;
+        for (uint32_t i = cell.start; i < cell.start + cell.count; ++i) {
+            if (overlaps(entries[i], query)) found.push_back(entries[i].entity);
+        }
+    };
+
+    const int32_t firstX = cellCoordinate(query.minX - maxWidth * 0.5f);
+    const int32_t lastX = cellCoordinate(query.maxX + maxWidth * 0.5f);
+    const int32_t firstY = cellCoordinate(query.minY - maxHeight * 0.5f);
+    const int32_t lastY = cellCoordinate(query.maxY + maxHeight * 0.5f);
+    const double spanned = (static_cast<double>(lastX) - firstX + 1) * (static_cast<double>(lastY) - firstY + 1);
+    if (spanned > static_cast<double>(cells.size())) {
+        // A region larger than the occupied area is cheaper to answer cell by cell.
+        for (const Cell& cell : cells) {
+            if (cell.x >= firstX && cell.x <= lastX && cell.y >= firstY && cell.y <= lastY) scanCell(cell);
+        }
+    } else {
+        for (int32_t y = firstY; y <= lastY; ++y) {
+            for (int32_t x = firstX; x <= lastX; ++x) {
+                const uint32_t cell = findCell(x, y);
+                if (cell != UINT32_MAX) scanCell(cells[cell]);
+            }
+        }
+    }
+    return found.size() - before;
+}
+
+// Entries of the first cell that miss the second cell's bounds are skipped with one test.
+void SpatialHash::pairCells(const Cell& a, const Cell& b, std::vector<EntityPair>& pairs) const {
+    for (uint32_t i = a.start; i < a.start + a.count; ++i) {
+        const Entry& first = entries[i];
+        if (!overlaps(first, b)) continue;
+        for (uint32_t j = b.start; j < b.start + b.count; ++j) {
+            if (overlaps(first, entries[j])) {
+                pairs.push_back({std::min(first.entity, entries[j].entity), std::max(first.entity, entries[j].entity)});
+            }
+        }
+    }
+}
+
+// Tests each cell against itself and against the neighbours after it in row order, so every
+// pair of cells within reach is visited once.
+size_t SpatialHash::findPairs(std::vector<EntityPair>& pairs) const {
+    const size_t before = pairs.size();
+    for (const Cell& cell : cells) {
+        if (cell.count == 0) continue;
+
+        for (uint32_t i = cell.start; i < cell.start + cell.count; ++i) {
+            for (uint32_t j = i + 1; j < cell.start + cell.count; ++j) {
+                if (overlaps(entries[i], entries[j])) {
+                    pairs.push_back({std::min(entries[i].entity, entries[j].entity),
+                                     std::max(entries[i].entity, entries[j].entity)});
+                }
+            }
+        }
+        for (int32_t dy = 0; dy <= reachY; ++dy) {
+            for (int32_t dx = dy == 0 ? 1 : -reachX; dx <= reachX; ++dx) {
+                const uint32_t neighbour = findCell(cell.x + dx, cell.y + dy);
+                if (neighbour != UINT32_MAX && cells[neighbour].count > 0 && overlaps(cell, cells[neighbour])) {
+                    pairCells(cell, cells[neighbour], pairs);
+                }
+            }
+        }
+    }
+    return pairs.size() - before;
+}
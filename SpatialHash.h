@@ -0,0 +1,110 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include "raylib.h"
+#include "EntityStore.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Constants for the spatial hash.
+constexpr float SPATIAL_CELL_SIZE = 64.0f;  // The default cell size, about twice the size of a sprite.
+constexpr uint32_t SPATIAL_CELL_SLACK = 4;  // The spare entries given to each cell, so entities can move in without a rebuild.
+
+// The EntityPair struct is two entities whose boxes overlap, by dense index with first < second.
+struct EntityPair {
+    uint32_t first;
+    uint32_t second;
+};
+
+// The SpatialHash class is a broadphase for the entities of an EntityStore. Each entity's box is
+// its position and sprite size, and it is filed under the grid cell that holds the box's center;
+// only cells that hold entities exist, found through a hash of their coordinates. A cell's
+// entries, with their boxes, lie next to each other in one array, so a query reads memory in
+// order. Queries look as many cells around a box as the largest entity can reach, and skip cells
+// whose bounds miss the box.
+//
+// update() runs once per tick. Entities that stay in their cell are updated in place and
+// entities that cross into another cell are moved into its spare entries. A cell that runs out
+// of room is moved to the end of the array with twice the space, and the whole grid is rebuilt
+// when too much space is wasted or the number of entities changed.
+class SpatialHash {
+public:
+    explicit SpatialHash(float cellSize = SPATIAL_CELL_SIZE);
+
+    // Brings the grid up to date with the store's positions and sizes.
+    void update(const EntityStore& store);
+    // Files every entity again from scratch, laying the cells out row by row.
+    void rebuild(const EntityStore& store);
+
+    // Appends the entities whose boxes overlap the region, e.g. a hazard or a piece of the world.
+    // Returns the number appended.
+    size_t queryRegion(const Rectangle& region, std::vector<uint32_t>& entities) const;
+    // Appends every pair of entities whose boxes overlap, each pair once. Returns the number appended.
+    size_t findPairs(std::vector<EntityPair>& pairs) const;
+
+    // Returns the number of entities in the grid.
+    size_t size() const { return cellOf.size(); }
+    // Returns the number of cells that exist, including ones that have emptied.
+    size_t cellCount() const { return cells.size(); }
+    // Returns the number of full rebuilds so far.
+    uint64_t rebuildCount() const { return rebuilds; }
+
+private:
+    // The Entry struct is an entity's box, stored in its cell's run of entries.
+    struct Entry {
+        float minX, minY, maxX, maxY;
+        uint32_t entity;
+    };
+    // The Cell struct is one occupied grid cell and its run of entries.
+    struct Cell {
+        int32_t x, y;        // The cell's grid coordinates.
+        uint32_t start;      // The index of the cell's first entry.
+        uint32_t count;      // The number of entries in use.
+        uint32_t capacity;   // The number of entries reserved.
+        float minX, minY, maxX, maxY; // The bounds of the entries' boxes, empty if there are none.
+    };
+    // The Slot struct is one entry of the hash table. It repeats the cell's coordinates, so a
+    // lookup does not have to read the cell to compare them.
+    struct Slot {
+        int32_t x, y;
+        uint32_t cell;       // The cell's index + 1, or 0 if the slot is empty.
+    };
+
+    // Returns an entity's box.
+    static Entry boxOf(const EntityStore& store, size_t index);
+    // Returns the grid coordinate of a position.
+    int32_t cellCoordinate(float position) const;
+    // Returns the index of the cell at the given coordinates, or UINT32_MAX if it does not exist.
+    uint32_t findCell(int32_t x, int32_t y) const;
+    // Returns the index of the cell at the given coordinates, creating it if needed.
+    uint32_t findOrAddCell(int32_t x, int32_t y);
+    // Rebuilds the hash table with room for at least the given number of cells.
+    void rehash(size_t minimumCells);
+    // Moves an entity's entry from its cell into another one.
+    void moveEntity(uint32_t entity, uint32_t toCell, const Entry& box);
+    // Moves a full cell to the end of the entry array with twice its room.
+    void growCell(uint32_t cell);
+    // Appends the overlapping pairs between two cells' entries.
+    void pairCells(const Cell& a, const Cell& b, std::vector<EntityPair>& pairs) const;
+    // Recomputes each cell's bounds from its entries.
+    void updateBounds();
+    // Records the largest entity size, which sets how far queries look.
+    void setReach(float maxWidth, float maxHeight);
+
+    float cellSize;
+    float inverseCellSize;
+    std::vector<Cell> cells;
+    std::vector<Slot> table;          // Open addressing from cell coordinates to cells.
+    std::vector<Entry> entries;       // The cells' runs of entries, including unused ones.
+    std::vector<uint32_t> cellOf;     // Dense entity index -> its cell.
+    std::vector<uint32_t> entryOf;    // Dense entity index -> its entry.
+    std::vector<uint32_t> order;      // Reused when laying out cells in a rebuild.
+    std::vector<Cell> sortedCells;    // Reused when laying out cells in a rebuild.
+    size_t wastedEntries = 0;         // Entries left behind by cells that moved.
+    float maxWidth = 0.0f, maxHeight = 0.0f; // The largest entity size when last updated.
+    int32_t reachX = 0, reachY = 0;   // The cells a box can reach into from its own cell.
+    uint64_t rebuilds = 0;
+};
+
+#endif // SPATIAL_HASH_H
@@ -0,0 +1,181 @@
+#include "SpriteBatch.h"
+#include "ConsoleCapture.h"
+#include "Profiler.h"
+#include "rlgl.h"
+#include <algorithm>
+#include <cstring>
+
+// TextureAtlas implementation
+TextureAtlas::TextureAtlas(int atlasSize) : size(atlasSize) {
+}
+
+// Copies a texture's pixels into the next free spot on the current shelf, starting a new shelf
+// when the row is full.
+bool TextureAtlas::add(Texture2D texture) {
+    if (texture.id == 0 || regions.count(texture.id)) return texture.id != 0;
+
+    const int width = texture.width + ATLAS_PADDING * 2;
+    const int height = texture.height + ATLAS_PADDING * 2;
+    if (shelfX + width > size) {
+        shelfX = 0;
+        shelfY += shelfHeight;
+        shelfHeight = 0;
+    }
+    if (width > size || shelfY + height > size) {
+        consoleCapture.addLine("ATLAS: No room for a " + std::to_string(texture.width) + "x" +
+                               std::to_string(texture.height) + " texture");
+        return false;
+    }
+
+    // The atlas image is created on first use, so an unused atlas costs nothing.
+    if (image.data == nullptr) {
+        image = GenImageColor(size, size, BLANK);
+    }
+
+    Image pixels = LoadImageFromTexture(texture);
+    ImageFormat(&pixels, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    const int x = shelfX + ATLAS_PADDING;
+    const int y = shelfY + ATLAS_PADDING;
+    constexpr int bytesPerPixel = 4;
+    unsigned char* const atlasPixels = static_cast<unsigned char*>(image.data);
+    const auto pixel = [atlasPixels, this](int px, int py) { return atlasPixels + (py * size + px) * bytesPerPixel; };
+    for (int row = 0; row < texture.height; ++row) {
+        std::memcpy(pixel(x, y + row), static_cast<const unsigned char*>(pixels.data) + row * texture.width * bytesPerPixel,
+                    static_cast<size_t>(texture.width) * bytesPerPixel);
+    }
+    UnloadImage(pixels);
+
+    // Fill the padding with copies of the edge texels, so filtering at an edge blends the
+    // texture with itself rather than with transparent black.
+    const int right = x + texture.width - 1;
+    const int bottom = y + texture.height - 1;
+    for (int row = y; row <= bottom; ++row) {
+        for (int pad = 1; pad <= ATLAS_PADDING; ++pad) {
+            std::memcpy(pixel(x - pad, row), pixel(x, row), bytesPerPixel);
+            std::memcpy(pixel(right + pad, row), pixel(right, row), bytesPerPixel);
+        }
+    }
+    for (int pad = 1; pad <= ATLAS_PADDING; ++pad) {
+        std::memcpy(pixel(shelfX, y - pad), pixel(shelfX, y), static_cast<size_t>(width) * bytesPerPixel);
+        std::memcpy(pixel(shelfX, bottom + pad), pixel(shelfX, bottom), static_cast<size_t>(width) * bytesPerPixel);
+    }
+
+    regions[texture.id] = {static_cast<float>(x), static_cast<float>(y),
+                           static_cast<float>(texture.width), static_cast<float>(texture.height)};
+    shelfX += width;
+    shelfHeight = std::max(shelfHeight, height);
+    dirty = true;
+    return true;
+}
+
+// Looks up where a texture was packed.
+bool TextureAtlas::find(unsigned int textureId, Rectangle& region) const {
+    const auto it = regions.find(textureId);
+    if (it == regions.end()) return false;
+    region = it->second;
+    return true;
+}
+
+// Returns the atlas texture, uploading the image if textures were added since the last upload.
+Texture2D TextureAtlas::texture() {
+    if (dirty) {
+        if (gpuTexture.id == 0) {
+            gpuTexture = LoadTextureFromImage(image);
+        } else {
+            UpdateTexture(gpuTexture, image.data);
+        }
+        dirty = false;
+    }
+    return gpuTexture;
+}
+
+// Releases the atlas image and texture.
+void TextureAtlas::unload() {
+    if (gpuTexture.id != 0) UnloadTexture(gpuTexture);
+    if (image.data != nullptr) UnloadImage(image);
+    gpuTexture = Texture2D{};
+    image = Image{};
+    regions.clear();
+    shelfX = shelfY = shelfHeight = 0;
+    dirty = false;
+}
+
+// SpriteBatch implementation
+// Clears the queue.
+void SpriteBatch::begin() {
+    sprites.clear();
+    order.clear();
+}
+
+// Queues a whole texture at a position.
+void SpriteBatch::draw(Texture2D texture, Vector2 position, Color tint, int layer) {
+    const Rectangle source = {0.0f, 0.0f, static_cast<float>(texture.width), static_cast<float>(texture.height)};
+    const Rectangle dest = {position.x, position.y, source.width, source.height};
+    draw(texture, source, dest, tint, layer);
+}
+
+// Queues part of a texture, remapping it into the atlas if it was packed there.
+void SpriteBatch::draw(Texture2D texture, Rectangle source, Rectangle dest, Color tint, int layer) {
+    // The atlas is uploaded here rather than in begin(), so a texture added mid-frame is already
+    // in the atlas texture its sprites are remapped to.
+    Rectangle region;
+    if (textureAtlas.find(texture.id, region)) {
+        source.x += region.x;
+        source.y += region.y;
+        texture = textureAtlas.texture();
+    }
+
+    // Layers are offset so negative layers sort before positive ones.
+    const uint64_t layerKey = static_cast<uint64_t>(static_cast<uint32_t>(layer) ^ 0x80000000u);
+    order.push_back({(layerKey << 32) | texture.id, static_cast<uint32_t>(sprites.size())});
+    sprites.push_back({texture, source, dest, tint});
+}
+
+// Sorts the queue and submits it through rlgl, one quad per sprite. Consecutive quads with the
+// same texture go into the same draw call.
+void SpriteBatch::end() {
+    PROFILE_ZONE("SpriteBatch::end");
+    std::sort(order.begin(), order.end(), [](const SortEntry& a, const SortEntry& b) {
+        return a.key != b.key ? a.key < b.key : a.index < b.index;
+    });
+
+    submittedDrawCalls = 0;
+    unsigned int currentTexture = 0;
+    for (const SortEntry& entry : order) {
+        const QueuedSprite& sprite = sprites[entry.index];
+        if (sprite.texture.id != currentTexture) {
+            currentTexture = sprite.texture.id;
+            ++submittedDrawCalls;
+        }
+        // Flushes raylib's vertex buffer when it is full.
+        if (rlCheckRenderBatchLimit(4)) {
+            ++submittedDrawCalls;
+        }
+
+        const float width = static_cast<float>(sprite.texture.width);
+        const float height = static_cast<float>(sprite.texture.height);
+        const float u0 = sprite.source.x / width;
+        const float v0 = sprite.source.y / height;
+        const float u1 = (sprite.source.x + sprite.source.width) / width;
+        const float v1 = (sprite.source.y + sprite.source.height) / height;
+        const float x0 = sprite.dest.x;
+        const float y0 = sprite.dest.y;
+        const float x1 = sprite.dest.x + sprite.dest.width;
+        const float y1 = sprite.dest.y + sprite.dest.height;
+
+        rlSetTexture(sprite.texture.id);
+        rlBegin(RL_QUADS);
+        rlColor4ub(sprite.tint.r, sprite.tint.g, sprite.tint.b, sprite.tint.a);
+        rlNormal3f(0.0f, 0.0f, 1.0f);
+        rlTexCoord2f(u0, v0); rlVertex2f(x0, y0);
+        rlTexCoord2f(u0, v1); rlVertex2f(x0, y1);
+        rlTexCoord2f(u1, v1); rlVertex2f(x1, y1);
+        rlTexCoord2f(u1, v0); rlVertex2f(x1, y0);
+        rlEnd();
+    }
+    rlSetTexture(0);
+
+    submittedSprites = sprites.size();
+    sprites.clear();
+    order.clear();
+}
@@ -0,0 +1,87 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include "raylib.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Constants for sprite batching.
+constexpr int ATLAS_SIZE = 2048;        // The width and height of the sprite atlas, in pixels.
+constexpr int ATLAS_PADDING = 1;        // The pixels around each packed texture, repeating its edges so filtering cannot bleed.
+constexpr int SPRITE_LAYER_GHOSTS = 0;  // The layer for timeline ghosts, drawn under the player.
+constexpr int SPRITE_LAYER_PLAYER = 10; // The layer for the player.
+
+// The TextureAtlas class packs small textures into one large texture, so sprites that use
+// any of them can share a draw call. Textures are packed on shelves, left to right.
+class TextureAtlas {
+public:
+    explicit TextureAtlas(int atlasSize = ATLAS_SIZE);
+
+    // Copies a texture into the atlas. Returns false if it does not fit, in which case sprites
+    // using it keep drawing from the texture itself.
+    bool add(Texture2D texture);
+    // Looks up where a texture was packed. Returns false if it was never added.
+    bool find(unsigned int textureId, Rectangle& region) const;
+    // Returns the atlas texture, uploading any textures added since the last call. Uploading
+    // keeps the texture id, so sprites already queued from the atlas stay valid.
+    Texture2D texture();
+    // Releases the atlas. Call before closing the window.
+    void unload();
+
+private:
+    int size;
+    Image image{};            // The atlas pixels, kept on the CPU so textures can be added later.
+    Texture2D gpuTexture{};
+    bool dirty = false;       // Whether the image has changed since it was uploaded.
+    int shelfX = 0, shelfY = 0, shelfHeight = 0;
+    std::unordered_map<unsigned int, Rectangle> regions; // Packed regions by source texture id.
+};
+
+// The SpriteBatch class collects the sprites drawn in a frame, sorts them by layer and texture,
+// and submits them as a few large batches. Textures that were added to the batch's atlas are
+// drawn from it, so they all share one batch.
+// Lower layers are drawn first. Within a layer, sprites with the same texture keep the order
+// they were drawn in, but sprites with different textures may be reordered.
+class SpriteBatch {
+public:
+    // Starts collecting sprites for a frame.
+    void begin();
+    // Queues a whole texture at a position.
+    void draw(Texture2D texture, Vector2 position, Color tint = WHITE, int layer = 0);
+    // Queues part of a texture, stretched to a destination rectangle.
+    void draw(Texture2D texture, Rectangle source, Rectangle dest, Color tint = WHITE, int layer = 0);
+    // Sorts and submits the queued sprites.
+    void end();
+
+    // Returns the atlas the batch draws packed textures from.
+    TextureAtlas& atlas() { return textureAtlas; }
+    // Returns the number of sprites submitted by the last end().
+    size_t spriteCount() const { return submittedSprites; }
+    // Returns the number of draw calls the last end() needed: one per texture change, plus one
+    // each time raylib's vertex buffer filled up.
+    int drawCalls() const { return submittedDrawCalls; }
+
+private:
+    // The QueuedSprite struct is a sprite waiting to be submitted.
+    struct QueuedSprite {
+        Texture2D texture;
+        Rectangle source;
+        Rectangle dest;
+        Color tint;
+    };
+    // The SortEntry struct orders a queued sprite by layer, then texture, then draw order.
+    struct SortEntry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    TextureAtlas textureAtlas;
+    std::vector<QueuedSprite> sprites;
+    std::vector<SortEntry> order;
+    size_t submittedSprites = 0;
+    int submittedDrawCalls = 0;
+};
+
+#endif // SPRITE_BATCH_H
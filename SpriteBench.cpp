@@ -0,0 +1,126 @@
+#include "SpriteBench.h"
+#include "SpriteBatch.h"
+#include "TextureLoader.h"
+#include "Profiler.h"
+#include "UIRenderer.h"
+#include "Version.h"
+#include "raylib.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+namespace {
+    // The size of the second, generated sprite texture.
+    constexpr int MARKER_TEXTURE_SIZE = 8;
+    
+    // The BenchSprite struct is one moving sprite in the benchmark scene.
+    struct BenchSprite {
+        Vector2 position;
+        Vector2 velocity;
+        Color tint;
+        bool marker; // Whether it uses the generated texture instead of the player sprite.
+    };
+    
+    // A small linear congruential generator, so every run draws the same scene.
+    uint32_t nextRandom(uint32_t& state) {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+    
+    // Builds the scene: sprites spread over the screen with random velocities, tints and alpha.
+    // A quarter use the generated texture, to show that atlas-packed textures share a batch.
+    std::vector<BenchSprite> makeScene(int count, int screenWidth, int screenHeight) {
+        std::vector<BenchSprite> sprites(static_cast<size_t>(count));
+        uint32_t seed = 12345;
+        for (auto& sprite : sprites) {
+            sprite.position = {static_cast<float>(nextRandom(seed) % screenWidth),
+                               static_cast<float>(nextRandom(seed) % screenHeight)};
+            sprite.velocity = {static_cast<float>(nextRandom(seed) % 200) - 100.0f,
+                               static_cast<float>(nextRandom(seed) % 200) - 100.0f};
+            sprite.tint = {static_cast<unsigned char>(128 + nextRandom(seed) % 128),
+                           static_cast<unsigned char>(128 + nextRandom(seed) % 128),
+                           static_cast<unsigned char>(128 + nextRandom(seed) % 128),
+                           static_cast<unsigned char>(64 + nextRandom(seed) % 192)};
+            sprite.marker = nextRandom(seed) % 4 == 0;
+        }
+        return sprites;
+    }
+}
+
+// Runs the sprite batch benchmark scene.
+int RunSpriteBench(const GameConfig& config, const LaunchOptions& options) {
+    InitWindow(config.screenWidth, config.screenHeight, WINDOW_TITLE);
+    // Uncapped, so the frame time shows the cost of drawing.
+    SetTargetFPS(0);
+    
+    const Texture2D playerTexture = LoadPlayerTexture(config.spritePath);
+    Image markerImage = GenImageColor(MARKER_TEXTURE_SIZE, MARKER_TEXTURE_SIZE, WHITE);
+    const Texture2D markerTexture = LoadTextureFromImage(markerImage);
+    UnloadImage(markerImage);
+    
+    SpriteBatch batch;
+    batch.atlas().add(playerTexture);
+    batch.atlas().add(markerTexture);
+    
+    std::vector<BenchSprite> sprites = makeScene(options.sprites, config.screenWidth, config.screenHeight);
+    const float maxX = static_cast<float>(config.screenWidth - playerTexture.width);
+    const float maxY = static_cast<float>(config.screenHeight - playerTexture.height);
+    
+    double frameTimeSum = 0.0;    // Over the current averaging window.
+    double averageFrameMs = 0.0;  // Over the last complete window.
+    double totalFrameMs = 0.0;
+    long long drawCallSum = 0;
+    long long frames = 0;
+    char stats[128];
+    
+    while (!WindowShouldClose() && (options.ticks == 0 || frames < options.ticks)) {
+        profiler.beginFrame();
+        const float dt = GetFrameTime();
+        
+        // Bounce the sprites off the screen edges.
+        for (auto& sprite : sprites) {
+            sprite.position.x += sprite.velocity.x * dt;
+            sprite.position.y += sprite.velocity.y * dt;
+            if (sprite.position.x < 0.0f || sprite.position.x > maxX) sprite.velocity.x = -sprite.velocity.x;
+            if (sprite.position.y < 0.0f || sprite.position.y > maxY) sprite.velocity.y = -sprite.velocity.y;
+        }
+        
+        BeginDrawing();
+        ClearBackground(GRAY);
+        batch.begin();
+        for (const auto& sprite : sprites) {
+            batch.draw(sprite.marker ? markerTexture : playerTexture, sprite.position, sprite.tint, SPRITE_LAYER_GHOSTS);
+        }
+        batch.end();
+        
+        std::snprintf(stats, sizeof(stats), "%zu sprites, %d draw calls, %.2f ms/frame",
+                      batch.spriteCount(), batch.drawCalls(), averageFrameMs);
+        DrawRectangle(5, 5, MeasureText(stats, 20) + 10, 50, Fade(BLACK, CONSOLE_BACKGROUND_ALPHA));
+        DrawText(stats, 10, 10, 20, WHITE);
+        DrawFPS(10, 32);
+        EndDrawing();
+        profiler.endFrame();
+        
+        drawCallSum += batch.drawCalls();
+        ++frames;
+        frameTimeSum += profiler.frameTime(0);
+        totalFrameMs += profiler.frameTime(0);
+        if (frames % SPRITE_BENCH_WINDOW == 0) {
+            averageFrameMs = frameTimeSum / SPRITE_BENCH_WINDOW;
+            frameTimeSum = 0.0;
+        }
+    }
+    
+    const double frameCount = static_cast<double>(std::max(1LL, frames));
+    std::cout << "SPRITES: " << sprites.size() << " sprites, " << frames << " frames, "
+              << static_cast<double>(drawCallSum) / frameCount << " draw calls/frame, "
+              << totalFrameMs / frameCount << " ms/frame\n";
+    
+    batch.atlas().unload();
+    UnloadTexture(markerTexture);
+    UnloadTexture(playerTexture);
+    CloseWindow();
+    return 0;
+}
@@ -0,0 +1,15 @@
+#ifndef SPRITE_BENCH_H
+#define SPRITE_BENCH_H
+
+#include "GameConfig.h"
+#include "LaunchOptions.h"
+
+// The number of frames the sprite benchmark averages its frame time over.
+constexpr int SPRITE_BENCH_WINDOW = 120;
+
+// Opens a window and draws options.sprites bouncing, tinted and faded sprites through a
+// SpriteBatch, showing the draw calls and frame time on screen. Runs until the window is closed,
+// or for options.ticks frames when given, then prints the averages.
+int RunSpriteBench(const GameConfig& config, const LaunchOptions& options);
+
+#endif // SPRITE_BENCH_H
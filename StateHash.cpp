@@ -0,0 +1,269 @@
+#include "StateHash.h"
+#include "ConsoleCapture.h"
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // File identification and format version.
+    constexpr char STATE_HASH_MAGIC[4] = {'T', 'X', 'S', 'H'};
+    constexpr uint16_t STATE_HASH_VERSION = 1;
+    static_assert(STATE_HASH_FIELDS <= 16, "Each tick's change mask is 16 bits");
+    // The size records are gathered to before being written out.
+    constexpr size_t STATE_HASH_FLUSH_BYTES = 4096;
+    // The number of parts that are entity components; the rest follow them.
+    constexpr uint32_t ENTITY_HASH_FIELDS = 13;
+
+    // The number of lanes hashBytes mixes words into at once.
+    constexpr size_t HASH_LANES = 8;
+
+    // The multipliers of xxHash32, which spread every input bit over the whole word.
+    constexpr uint32_t PRIME1 = 2654435761u;
+    constexpr uint32_t PRIME2 = 2246822519u;
+    constexpr uint32_t PRIME3 = 3266489917u;
+    constexpr uint32_t PRIME4 = 668265263u;
+    constexpr uint32_t PRIME5 = 374761393u;
+
+    uint32_t rotateLeft(uint32_t value, int bits) {
+        return (value << bits) | (value >> (32 - bits));
+    }
+
+    // Logs a sidecar error to both stderr and the in-game console.
+    void logStateHashError(const std::string& message) {
+        std::cerr << message << '\n';
+        consoleCapture.addLine(message);
+    }
+
+    // Hashes one entity component column.
+    uint32_t hashColumn(const std::vector<float>& column, uint32_t seed) {
+        return hashBytes(column.data(), column.size() * sizeof(float), seed);
+    }
+}
+
+uint32_t hashBytes(const void* data, size_t size, uint32_t seed) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    const size_t words = size / sizeof(uint32_t);
+    const size_t laneWords = words - words % HASH_LANES;
+
+    // Inputs shorter than one row of lanes, such as a single entity's column, skip the lanes.
+    uint32_t hash = seed + PRIME5 + static_cast<uint32_t>(size);
+    if (laneWords > 0) {
+        uint32_t lanes[HASH_LANES];
+        for (size_t lane = 0; lane < HASH_LANES; ++lane) {
+            lanes[lane] = seed + PRIME1 * static_cast<uint32_t>(lane + 1);
+        }
+        for (size_t word = 0; word < laneWords; word += HASH_LANES) {
+            for (size_t lane = 0; lane < HASH_LANES; ++lane) {
+                uint32_t value;
+                std::memcpy(&value, bytes + (word + lane) * sizeof(uint32_t), sizeof(value));
+                lanes[lane] = rotateLeft(lanes[lane] + value * PRIME2, 13) * PRIME1;
+            }
+        }
+        for (uint32_t lane : lanes) {
+            hash = rotateLeft(hash + lane * PRIME3, 17) * PRIME4;
+        }
+    }
+    for (size_t word = laneWords; word < words; ++word) {
+        uint32_t value;
+        std::memcpy(&value, bytes + word * sizeof(uint32_t), sizeof(value));
+        hash = rotateLeft(hash + value * PRIME3, 17) * PRIME4;
+    }
+    for (size_t i = words * sizeof(uint32_t); i < size; ++i) {
+        hash = rotateLeft(hash + bytes[i] * PRIME5, 11) * PRIME1;
+    }
+
+    hash ^= hash >> 15;
+    hash *= PRIME2;
+    hash ^= hash >> 13;
+    hash *= PRIME3;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+// StateHashes implementation
+uint64_t StateHashes::combined() const {
+    return (static_cast<uint64_t>(hashBytes(fields.data(), sizeof(fields), 0)) << 32) |
+           hashBytes(fields.data(), sizeof(fields), 1);
+}
+
+// Each part is hashed with its index as the seed, so two parts holding the same values still differ.
+StateHashes hashEntityState(const EntityStore& entities) {
+    StateHashes hashes;
+    const std::vector<float>* columns[] = {
+        &entities.posX, &entities.posY, &entities.prevX, &entities.prevY, &entities.velX, &entities.velY,
+        &entities.speed, &entities.baseSpeed, &entities.maxSpeed, &entities.baseMaxSpeed,
+        &entities.friction, &entities.width, &entities.height};
+    uint32_t field = 0;
+    static_assert(sizeof(columns) / sizeof(columns[0]) == ENTITY_HASH_FIELDS, "Every entity component is hashed");
+    for (const std::vector<float>* column : columns) {
+        hashes.fields[field] = hashColumn(*column, field);
+        ++field;
+    }
+    return hashes;
+}
+
+StateHashes hashSimulationState(const EntityStore& entities, const GameState& gameState,
+                                const ConsoleInput& consoleInput, const RewindBuffer& rewindBuffer) {
+    StateHashes hashes = hashEntityState(entities);
+    uint32_t field = ENTITY_HASH_FIELDS;
+
+    const uint32_t game[] = {static_cast<uint32_t>(gameState.currentState), gameState.consoleVisible,
+                             gameState.shouldQuit, gameState.rewinding};
+    hashes.fields[field] = hashBytes(game, sizeof(game), field);
+    ++field;
+
+    const uint32_t console[] = {hashBytes(consoleInput.text.data(), consoleInput.text.size()),
+                                static_cast<uint32_t>(consoleInput.cursorPosition), consoleInput.active};
+    hashes.fields[field] = hashBytes(console, sizeof(console), field);
+    ++field;
+
+    const uint64_t rewind[] = {rewindBuffer.tickCount(), rewindBuffer.bytesUsed()};
+    hashes.fields[field] = hashBytes(rewind, sizeof(rewind), field);
+    return hashes;
+}
+
+// StateHashWriter implementation
+StateHashWriter::~StateHashWriter() {
+    close();
+}
+
+// The header is the magic, the version and the part names, each prefixed by its length.
+bool StateHashWriter::open(const std::string& path) {
+    close();
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        logStateHashError("STATE HASH: Failed to create " + path);
+        return false;
+    }
+
+    file.write(STATE_HASH_MAGIC, sizeof(STATE_HASH_MAGIC));
+    const unsigned char header[] = {static_cast<unsigned char>(STATE_HASH_VERSION),
+                                    static_cast<unsigned char>(STATE_HASH_VERSION >> 8),
+                                    static_cast<unsigned char>(STATE_HASH_FIELDS)};
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    bytes = sizeof(STATE_HASH_MAGIC) + sizeof(header);
+    for (std::string_view name : STATE_HASH_FIELD_NAMES) {
+        file.put(static_cast<char>(name.size()));
+        file.write(name.data(), static_cast<std::streamsize>(name.size()));
+        bytes += 1 + name.size();
+    }
+    previous = StateHashes();
+    pending.clear();
+    pending.reserve(STATE_HASH_FLUSH_BYTES + 2 + STATE_HASH_FIELDS * sizeof(uint32_t));
+    ticks = 0;
+    return true;
+}
+
+// Writes the change mask, then the changed hashes in part order, all little-endian. Records are
+// gathered and written in blocks, since a stream write per tick would cost more than the hashing.
+void StateHashWriter::record(const StateHashes& hashes) {
+    if (!file.is_open()) return;
+
+    unsigned char record[2 + STATE_HASH_FIELDS * sizeof(uint32_t)];
+    size_t size = 2;
+    uint16_t mask = 0;
+    for (size_t i = 0; i < STATE_HASH_FIELDS; ++i) {
+        if (hashes.fields[i] == previous.fields[i]) continue;
+        mask = static_cast<uint16_t>(mask | (1u << i));
+        for (int shift = 0; shift < 32; shift += 8) {
+            record[size++] = static_cast<unsigned char>(hashes.fields[i] >> shift);
+        }
+    }
+    record[0] = static_cast<unsigned char>(mask);
+    record[1] = static_cast<unsigned char>(mask >> 8);
+    pending.insert(pending.end(), record, record + size);
+
+    previous = hashes;
+    bytes += size;
+    ++ticks;
+    if (pending.size() >= STATE_HASH_FLUSH_BYTES) flush();
+}
+
+void StateHashWriter::close() {
+    if (!file.is_open()) return;
+    flush();
+    file.close();
+}
+
+void StateHashWriter::flush() {
+    file.write(reinterpret_cast<const char*>(pending.data()), static_cast<std::streamsize>(pending.size()));
+    pending.clear();
+}
+
+// StateHashReader implementation
+bool StateHashReader::open(const std::string& path) {
+    file.open(path, std::ios::binary);
+    if (!file.is_open()) {
+        logStateHashError("STATE HASH: Failed to open " + path);
+        return false;
+    }
+
+    char magic[sizeof(STATE_HASH_MAGIC)] = {};
+    unsigned char header[3] = {};
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    bool valid = file.good() && std::memcmp(magic, STATE_HASH_MAGIC, sizeof(magic)) == 0 &&
+                 (header[0] | (header[1] << 8)) == STATE_HASH_VERSION && header[2] == STATE_HASH_FIELDS;
+    for (size_t i = 0; valid && i < STATE_HASH_FIELDS; ++i) {
+        const int length = file.get();
+        names[i].resize(length > 0 ? static_cast<size_t>(length) : 0);
+        file.read(names[i].data(), static_cast<std::streamsize>(names[i].size()));
+        valid = length != std::char_traits<char>::eof() && file.good();
+    }
+    if (!valid) {
+        logStateHashError("STATE HASH: Invalid state hash file " + path);
+        file.close();
+        return false;
+    }
+    current = StateHashes();
+    return true;
+}
+
+bool StateHashReader::next(StateHashes& hashes) {
+    if (!file.is_open()) return false;
+    unsigned char maskBytes[2];
+    if (!file.read(reinterpret_cast<char*>(maskBytes), sizeof(maskBytes))) return false;
+
+    const uint16_t mask = static_cast<uint16_t>(maskBytes[0] | (maskBytes[1] << 8));
+    for (size_t i = 0; i < STATE_HASH_FIELDS; ++i) {
+        if ((mask & (1u << i)) == 0) continue;
+        unsigned char value[4];
+        if (!file.read(reinterpret_cast<char*>(value), sizeof(value))) return false;
+        current.fields[i] = static_cast<uint32_t>(value[0]) | (static_cast<uint32_t>(value[1]) << 8) |
+                            (static_cast<uint32_t>(value[2]) << 16) | (static_cast<uint32_t>(value[3]) << 24);
+    }
+    hashes = current;
+    return true;
+}
+
+// Ticks are counted from 0, the first tick simulated.
+int compareStateHashes(const std::string& pathA, const std::string& pathB) {
+    StateHashReader a, b;
+    if (!a.open(pathA) || !b.open(pathB)) return 2;
+    if (a.fieldNames() != b.fieldNames()) {
+        std::cout << "DETERMINISM: " << pathA << " and " << pathB << " hash different parts of the state\n";
+        return 1;
+    }
+
+    StateHashes hashesA, hashesB;
+    uint64_t tick = 0;
+    for (;; ++tick) {
+        const bool moreA = a.next(hashesA);
+        const bool moreB = b.next(hashesB);
+        if (!moreA || !moreB) {
+            if (moreA == moreB) break;
+            std::cout << "DETERMINISM: " << (moreA ? pathB : pathA) << " ends after " << tick
+                      << " ticks, the other one goes on\n";
+            return 1;
+        }
+        if (hashesA == hashesB) continue;
+
+        std::cout << "DETERMINISM: diverged at tick " << tick << " in";
+        for (size_t i = 0; i < STATE_HASH_FIELDS; ++i) {
+            if (hashesA.fields[i] != hashesB.fields[i]) std::cout << ' ' << a.fieldNames()[i];
+        }
+        std::cout << '\n';
+        return 1;
+    }
+    std::cout << "DETERMINISM: " << tick << " ticks match\n";
+    return 0;
+}
@@ -0,0 +1,101 @@
+#ifndef STATE_HASH_H
+#define STATE_HASH_H
+
+#include "EntityStore.h"
+#include "GameState.h"
+#include "RewindBuffer.h"
+#include "UIRenderer.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Constants for state hashing.
+constexpr size_t STATE_HASH_FIELDS = 16; // The number of separately hashed parts of the simulation state.
+
+// The names of the hashed parts, in the order of StateHashes::fields. Sidecar files store them,
+// so a comparison can say which part diverged.
+constexpr std::array<std::string_view, STATE_HASH_FIELDS> STATE_HASH_FIELD_NAMES = {
+    "pos_x", "pos_y", "prev_x", "prev_y", "vel_x", "vel_y", "speed", "base_speed",
+    "max_speed", "base_max_speed", "friction", "width", "height",
+    "game_state", "console_input", "rewind_history"};
+
+// Hashes a block of memory bitwise. Whole 32-bit words are mixed into eight independent lanes,
+// so the compiler can keep all of them in one vector register; the lanes are folded together
+// at the end. Not meant to resist attacks, only to change whenever a bit does.
+uint32_t hashBytes(const void* data, size_t size, uint32_t seed = 0);
+
+// The StateHashes struct is the hash of each part of the simulation state after one tick.
+struct StateHashes {
+    std::array<uint32_t, STATE_HASH_FIELDS> fields{};
+
+    // Folds the part hashes into one value for the whole state.
+    uint64_t combined() const;
+    bool operator==(const StateHashes& other) const { return fields == other.fields; }
+    bool operator!=(const StateHashes& other) const { return !(*this == other); }
+};
+
+// Hashes each entity component except the textures, leaving the other parts zero.
+StateHashes hashEntityState(const EntityStore& entities);
+
+// Hashes everything updateGame reads and writes: each entity component except the textures,
+// the game state, the console input box and the size of the rewind history.
+StateHashes hashSimulationState(const EntityStore& entities, const GameState& gameState,
+                                const ConsoleInput& consoleInput, const RewindBuffer& rewindBuffer);
+
+// The StateHashWriter class writes the state hashes of every tick to a sidecar file, next to a
+// replay or on its own. Each tick stores a mask of the parts whose hash changed since the previous
+// tick and only those hashes, so parts that sit still, such as sprite sizes, cost nothing.
+class StateHashWriter {
+public:
+    StateHashWriter() = default;
+    ~StateHashWriter();
+
+    // Opens the file and writes the header with the part names. Returns false if the file cannot be created.
+    bool open(const std::string& path);
+    // Appends the hashes for the next tick.
+    void record(const StateHashes& hashes);
+    // Writes out the buffered ticks and closes the file.
+    void close();
+    // Checks if a sidecar is being written.
+    bool isOpen() const { return file.is_open(); }
+    // Returns the number of ticks written so far.
+    uint64_t tickCount() const { return ticks; }
+    // Returns the number of bytes written so far.
+    uint64_t bytesWritten() const { return bytes; }
+
+private:
+    // Writes the buffered ticks to the file.
+    void flush();
+
+    std::ofstream file;
+    std::vector<unsigned char> pending; // Encoded ticks not yet written.
+    StateHashes previous;
+    uint64_t ticks = 0;
+    uint64_t bytes = 0;
+};
+
+// The StateHashReader class reads back a file written by StateHashWriter, one tick at a time.
+class StateHashReader {
+public:
+    // Opens the file and reads the header. Returns false if the file is missing or invalid.
+    bool open(const std::string& path);
+    // Reads the hashes for the next tick. Returns false once the file is exhausted.
+    bool next(StateHashes& hashes);
+    // Returns the part names stored in the file.
+    const std::array<std::string, STATE_HASH_FIELDS>& fieldNames() const { return names; }
+
+private:
+    std::ifstream file;
+    std::array<std::string, STATE_HASH_FIELDS> names;
+    StateHashes current;
+};
+
+// Compares two sidecar files tick by tick and prints the first tick and the parts of the state
+// that differ there, or that the runs match. Returns 0 if they match.
+int compareStateHashes(const std::string& pathA, const std::string& pathB);
+
+#endif // STATE_HASH_H
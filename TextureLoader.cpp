@@ -1,6 +1,14 @@
 #include "TextureLoader.h"
 #include "ConsoleCapture.h"
 
+// Creates the fallback texture, a simple red square.
+Texture2D LoadFallbackTexture() {
+    Image img = GenImageColor(FALLBACK_TEXTURE_SIZE, FALLBACK_TEXTURE_SIZE, RED);
+    const Texture2D texture = LoadTextureFromImage(img);
+    UnloadImage(img);
+    return texture;
+}
+
 // Loads the player texture from the given path.
 // If the texture fails to load, it creates a fallback texture.
 Texture2D LoadPlayerTexture(const std::string& path) {
@@ -9,9 +17,7 @@ Texture2D LoadPlayerTexture(const std::string& path) {
     // Check if the texture was loaded successfully.
     if (texture.id == 0) {
         // If loading fails, create a fallback texture (a simple red square).
-        Image img = GenImageColor(FALLBACK_TEXTURE_SIZE, FALLBACK_TEXTURE_SIZE, RED);
-        texture = LoadTextureFromImage(img);
-        UnloadImage(img);
+        texture = LoadFallbackTexture();
         // Log a message to the console indicating that the fallback texture is being used.
         consoleCapture.addLine("RAYLIB: Failed to load player texture, using fallback");
     } else {
@@ -7,6 +7,9 @@
 // The size of the fallback texture to be generated if the player texture fails to load.
 const int FALLBACK_TEXTURE_SIZE = 32;
 
+// Creates the fallback texture: a red square of FALLBACK_TEXTURE_SIZE.
+Texture2D LoadFallbackTexture();
+
 // Declares the function to load the player texture.
 // This function includes a fallback mechanism in case the texture file cannot be found or loaded.
 Texture2D LoadPlayerTexture(const std::string& path);
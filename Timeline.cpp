@@ -0,0 +1,98 @@
+#include "Timeline.h"
+#include <algorithm>
+#include <cstring>
+
+// TimelineManager constructor.
+TimelineManager::TimelineManager(const WorldState& rootWorld) {
+    Timeline root;
+    root.id = 0;
+    root.world = rootWorld;
+    root.base = rootWorld;
+    timelines.push_back(std::move(root));
+}
+
+// Forks the given timeline into branches. Each branch copies only the world's root pointer.
+std::vector<int> TimelineManager::fork(int id, int branches) {
+    std::vector<int> ids;
+    const Timeline* parent = find(id);
+    if (!parent || branches <= 0) return ids;
+    
+    // Copy what we need before growing the vector, which may invalidate the parent pointer.
+    const WorldState world = parent->world;
+    const uint64_t tick = parent->tick;
+    
+    ids.reserve(branches);
+    for (int i = 0; i < branches; ++i) {
+        Timeline branch;
+        branch.id = static_cast<int>(timelines.size());
+        branch.parentId = id;
+        branch.forkTick = tick;
+        branch.tick = tick;
+        branch.world = world;
+        branch.base = world;
+        ids.push_back(branch.id);
+        timelines.push_back(std::move(branch));
+    }
+    return ids;
+}
+
+// Merges the source timeline into the target.
+// Only entities the source changed since its fork are visited, so the cost is O(changed).
+MergeResult TimelineManager::merge(int sourceId, int targetId, MergePolicy policy) {
+    MergeResult result;
+    Timeline* source = find(sourceId);
+    Timeline* target = find(targetId);
+    if (!source || !target || source == target) return result;
+    
+    const bool sourceWins = policy == MergePolicy::TAKE_SOURCE ||
+                            (policy == MergePolicy::PREFER_NEWER && source->tick > target->tick);
+    
+    WorldState::diff(source->base, source->world, [&](size_t index) {
+        if (index >= source->world.size()) return; // Removed in the source; nothing to bring over.
+        const PlayerState& incoming = source->world.get(index);
+        
+        if (index >= target->world.size()) {
+            // Entities the source created are appended to the target.
+            target->world.push_back(incoming);
+            ++result.changed;
+            return;
+        }
+        
+        // A conflict is an entity the target also changed since the fork.
+        const bool targetChanged = index >= source->base.size() ||
+            std::memcmp(&target->world.get(index), &source->base.get(index), sizeof(PlayerState)) != 0;
+        if (targetChanged) {
+            ++result.conflicts;
+            if (!sourceWins) return;
+        }
+        if (target->world.update(index, incoming)) {
+            ++result.changed;
+        }
+    });
+    
+    target->tick = std::max(target->tick, source->tick);
+    discard(sourceId);
+    return result;
+}
+
+// Retires a timeline, releasing the state it does not share with others.
+void TimelineManager::discard(int id) {
+    Timeline* timeline = find(id);
+    if (!timeline || id == rootId()) return;
+    timeline->alive = false;
+    timeline->world = WorldState();
+    timeline->base = WorldState();
+}
+
+// Returns the timeline with the given id, or nullptr if it does not exist or is retired.
+Timeline* TimelineManager::find(int id) {
+    if (id < 0 || id >= static_cast<int>(timelines.size())) return nullptr;
+    Timeline& timeline = timelines[id];
+    return timeline.alive ? &timeline : nullptr;
+}
+
+// Returns the number of live timelines.
+size_t TimelineManager::liveCount() const {
+    return static_cast<size_t>(std::count_if(timelines.begin(), timelines.end(),
+                                             [](const Timeline& t) { return t.alive; }));
+}
@@ -0,0 +1,105 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include "Player.h"
+#include "PersistentVector.h"
+#include "JobSystem.h"
+#include <cstdint>
+#include <vector>
+
+// The world state of one timeline: the simulated state of every entity in it.
+using WorldState = PersistentVector<PlayerState>;
+
+// Decides which state wins when an entity changed in both timelines being merged.
+enum class MergePolicy {
+    KEEP_TARGET,  // The timeline being merged into keeps its state.
+    TAKE_SOURCE,  // The timeline being merged in overwrites the state.
+    PREFER_NEWER  // The timeline that has simulated more ticks wins; ties keep the target.
+};
+
+// The Timeline struct is one branch of the world.
+struct Timeline {
+    int id = -1;              // The timeline's id.
+    int parentId = -1;        // The timeline it was forked from (-1 for the root).
+    uint64_t forkTick = 0;    // The tick at which it was forked.
+    uint64_t tick = 0;        // The tick it has been simulated up to.
+    WorldState world;         // The current state of every entity.
+    WorldState base;          // The state at the fork, used to tell what changed when merging.
+    bool alive = true;        // Whether it is still live (not merged or discarded).
+    
+    // Applies fn(PlayerState&) to every entity, writing back only the ones that changed,
+    // so entities at rest keep sharing memory with the other timelines.
+    template<typename F>
+    void simulate(F&& fn) {
+        for (size_t i = 0; i < world.size(); ++i) {
+            PlayerState state = world.get(i);
+            fn(state);
+            world.update(i, state);
+        }
+        ++tick;
+    }
+    
+    // Adds jobs to the graph that step every entity, batchSize entities per job, and returns
+    // the id of the final job that writes the results back. step(index, state) runs on worker
+    // threads and must only touch its own state; the world is written by that single final job,
+    // so the result is the same for any thread count. scratch must outlive the graph's run.
+    template<typename F>
+    JobGraph::JobId scheduleSimulation(JobGraph& graph, std::vector<PlayerState>& scratch, size_t batchSize, F step) {
+        scratch.resize(world.size());
+        const JobGraph::JobId writeBack = graph.add([this, &scratch] {
+            for (size_t i = 0; i < world.size(); ++i) {
+                world.update(i, scratch[i]);
+            }
+            ++tick;
+        });
+        
+        batchSize = batchSize > 0 ? batchSize : world.size();
+        for (size_t first = 0; first < world.size(); first += batchSize) {
+            const size_t end = first + batchSize < world.size() ? first + batchSize : world.size();
+            const JobGraph::JobId batch = graph.add([this, &scratch, first, end, step]() mutable {
+                for (size_t i = first; i < end; ++i) {
+                    PlayerState state = world.get(i);
+                    step(i, state);
+                    scratch[i] = state;
+                }
+            });
+            graph.addDependency(batch, writeBack);
+        }
+        return writeBack;
+    }
+};
+
+// The MergeResult struct reports what a merge did.
+struct MergeResult {
+    size_t changed = 0;   // The number of entities written into the target.
+    size_t conflicts = 0; // The number of entities that changed on both sides.
+};
+
+// The TimelineManager class owns every timeline and implements forking and merging.
+// Forking is O(1) per branch: a branch shares all state with its parent until it writes to it.
+class TimelineManager {
+public:
+    // Creates the manager with a single root timeline holding the given world.
+    explicit TimelineManager(const WorldState& rootWorld);
+    
+    // Forks the given timeline into the requested number of branches and returns their ids.
+    std::vector<int> fork(int id, int branches);
+    // Merges the source timeline into the target using the given conflict policy.
+    // Changes are detected against the source's fork point, so the target should be the
+    // source's parent or a sibling forked at the same tick. The source is retired afterwards.
+    MergeResult merge(int sourceId, int targetId, MergePolicy policy);
+    // Retires a timeline without merging it.
+    void discard(int id);
+    
+    // Returns the timeline with the given id, or nullptr if it does not exist or is retired.
+    Timeline* find(int id);
+    // Returns the number of live timelines.
+    size_t liveCount() const;
+    // Returns the id of the root timeline.
+    int rootId() const { return 0; }
+
+private:
+    std::vector<Timeline> timelines; // Indexed by id; retired timelines are kept as tombstones.
+};
+
+#endif // TIMELINE_H
@@ -0,0 +1,499 @@
+#include "TimelineArchive.h"
+#include "ConsoleCapture.h"
+#include "StateHash.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <type_traits>
+
+namespace {
+    // File identification, as in save files.
+    constexpr char ARCHIVE_MAGIC[4] = {'T', 'X', 'T', 'L'};
+    constexpr char CHUNK_MAGIC[4] = {'T', 'L', 'C', 'K'};
+    constexpr char INDEX_MAGIC[4] = {'T', 'L', 'I', 'X'};
+    constexpr uint32_t ARCHIVE_BYTE_ORDER = 0x01020304;
+
+    // Record kinds, stored in the first byte of every record.
+    constexpr uint8_t RECORD_KEYFRAME = 0;
+    constexpr uint8_t RECORD_DELTA = 1;
+
+    // A chunk is also closed early once its records pass this size, so the record offsets fit in
+    // 32 bits and a seek in a huge crowd does not land on a chunk of hundreds of megabytes.
+    constexpr size_t MAX_CHUNK_BYTES = 64 * 1024 * 1024;
+
+    // The ArchiveHeader struct starts every archive. The chunks follow it.
+    struct ArchiveHeader {
+        char magic[4];
+        uint32_t byteOrder;
+        uint16_t version;
+        uint16_t reserved;
+        uint32_t tickRate;     // The tick rate the ticks were simulated at.
+        uint64_t firstTick;    // The tick of the first record.
+    };
+
+    // The ChunkHeader struct starts every chunk. It is followed by the end offset of each record,
+    // counted from the first record, and then the records: a keyframe, then one delta per tick.
+    struct ChunkHeader {
+        char magic[4];
+        uint32_t tickCount;
+        uint64_t firstTick;
+        uint32_t size;         // The bytes after this header.
+        uint32_t checksum;     // hashBytes of the records, seeded with hashBytes of the record ends.
+    };
+
+    // The ArchiveFooter struct ends a closed archive. The seek index is just before it.
+    struct ArchiveFooter {
+        uint64_t indexOffset;
+        uint64_t chunkCount;
+        char magic[4];
+        uint32_t checksum;     // hashBytes of the index.
+    };
+    static_assert(sizeof(ArchiveHeader) == 24 && sizeof(ChunkHeader) == 24 && sizeof(ArchiveFooter) == 24 &&
+                  sizeof(ArchiveChunk) == 16, "The archive layout must not depend on padding");
+    static_assert(std::is_trivially_copyable_v<ArchiveChunk>);
+
+    // The archived entity components, in the order they appear in a frame. Textures are not archived.
+    constexpr std::vector<float> EntityStore::* ARCHIVED_COLUMNS[] = {
+        &EntityStore::posX, &EntityStore::posY, &EntityStore::prevX, &EntityStore::prevY,
+        &EntityStore::velX, &EntityStore::velY, &EntityStore::speed, &EntityStore::baseSpeed,
+        &EntityStore::maxSpeed, &EntityStore::baseMaxSpeed, &EntityStore::friction,
+        &EntityStore::width, &EntityStore::height,
+    };
+    constexpr size_t ARCHIVED_COLUMN_COUNT = std::size(ARCHIVED_COLUMNS);
+
+    // Logs an archive error to both stderr and the in-game console.
+    void logArchiveError(const std::string& message) {
+        std::cerr << message << '\n';
+        consoleCapture.addLine(message);
+    }
+
+    // Returns the number of 32-bit words in the frame of a world of count entities.
+    size_t frameWords(size_t count) {
+        return 1 + ARCHIVED_COLUMN_COUNT * count;
+    }
+
+    // Flattens the entities into raw bits, so deltas are exact: the entity count, then each column.
+    void captureFrame(const EntityStore& entities, std::vector<uint32_t>& frame) {
+        const size_t count = entities.size();
+        frame.resize(frameWords(count));
+        frame[0] = static_cast<uint32_t>(count);
+        for (size_t c = 0; c < ARCHIVED_COLUMN_COUNT; ++c) {
+            std::memcpy(frame.data() + 1 + c * count, (entities.*ARCHIVED_COLUMNS[c]).data(), count * sizeof(float));
+        }
+    }
+
+    // Writes a decoded frame back into the entities.
+    void applyFrame(const std::vector<uint32_t>& frame, EntityStore& entities) {
+        const size_t count = frame[0];
+        entities.resize(count);
+        for (size_t c = 0; c < ARCHIVED_COLUMN_COUNT; ++c) {
+            std::memcpy((entities.*ARCHIVED_COLUMNS[c]).data(), frame.data() + 1 + c * count, count * sizeof(float));
+        }
+    }
+
+    // Returns how many low bytes are needed to hold the value (0 when it is zero).
+    uint8_t significantBytes(uint32_t value) {
+        uint8_t n = 0;
+        while (value != 0) {
+            ++n;
+            value >>= 8;
+        }
+        return n;
+    }
+
+    // Appends a record holding the whole frame.
+    void appendKeyframe(const std::vector<uint32_t>& frame, std::vector<uint8_t>& out) {
+        const size_t start = out.size();
+        out.resize(start + 1 + frame.size() * sizeof(uint32_t));
+        out[start] = RECORD_KEYFRAME;
+        std::memcpy(out.data() + start + 1, frame.data(), frame.size() * sizeof(uint32_t));
+    }
+
+    // Appends a record holding the XOR of the frame against the keyframe: a byte of two four-bit
+    // lengths per two words, then the significant bytes of each word. A component that has not
+    // changed since the keyframe, such as a sprite size, costs half a byte.
+    void appendDelta(const std::vector<uint32_t>& frame, const std::vector<uint32_t>& keyframe, std::vector<uint8_t>& out) {
+        const size_t words = frame.size();
+        const size_t lengthBytes = (words + 1) / 2;
+        const size_t start = out.size();
+        out.resize(start + 1 + lengthBytes + words * sizeof(uint32_t));
+        uint8_t* record = out.data() + start;
+        record[0] = RECORD_DELTA;
+        std::memset(record + 1, 0, lengthBytes);
+        size_t size = 1 + lengthBytes;
+        for (size_t i = 0; i < words; ++i) {
+            uint32_t delta = frame[i] ^ keyframe[i];
+            const uint8_t length = significantBytes(delta);
+            record[1 + i / 2] |= static_cast<uint8_t>(length << ((i % 2) * 4));
+            for (uint8_t b = 0; b < length; ++b) {
+                record[size++] = static_cast<uint8_t>(delta);
+                delta >>= 8;
+            }
+        }
+        out.resize(start + size);
+    }
+
+    // Decodes a record into frame. A keyframe replaces the frame; a delta is applied to it, so the
+    // frame must hold the chunk's keyframe. Returns false if the record is malformed.
+    bool decodeRecord(const uint8_t* record, size_t size, std::vector<uint32_t>& frame) {
+        if (size == 0) return false;
+        if (record[0] == RECORD_KEYFRAME) {
+            const size_t words = (size - 1) / sizeof(uint32_t);
+            uint32_t count = 0;
+            if (words == 0 || (size - 1) % sizeof(uint32_t) != 0) return false;
+            std::memcpy(&count, record + 1, sizeof(count));
+            // The player is the first entity, so a world without it cannot be restored.
+            if (count == 0 || count > (words - 1) / ARCHIVED_COLUMN_COUNT || frameWords(count) != words) return false;
+            frame.resize(words);
+            std::memcpy(frame.data(), record + 1, size - 1);
+            return true;
+        }
+
+        // Every tick of a chunk has the keyframe's entity count, so the count's delta is always empty.
+        const size_t words = frame.size();
+        const size_t lengthBytes = (words + 1) / 2;
+        if (record[0] != RECORD_DELTA || words == 0 || size < 1 + lengthBytes || (record[1] & 0x0F) != 0) return false;
+        size_t pos = 1 + lengthBytes;
+        for (size_t i = 0; i < words; ++i) {
+            const uint8_t length = (record[1 + i / 2] >> ((i % 2) * 4)) & 0x0F;
+            if (length > sizeof(uint32_t) || length > size - pos) return false;
+            uint32_t delta = 0;
+            for (uint8_t b = 0; b < length; ++b) {
+                delta |= static_cast<uint32_t>(record[pos++]) << (8 * b);
+            }
+            frame[i] ^= delta;
+        }
+        return pos == size;
+    }
+
+    // Decodes tick k of a chunk into frame: its keyframe, then the tick's delta. Only those two
+    // records are read.
+    bool decodeChunkTick(const uint8_t* ends, const uint8_t* records, size_t recordsSize, uint32_t k,
+                         std::vector<uint32_t>& frame) {
+        const auto recordEnd = [ends](uint32_t i) {
+            uint32_t end;
+            std::memcpy(&end, ends + i * sizeof(uint32_t), sizeof(end));
+            return static_cast<size_t>(end);
+        };
+        const size_t keyframeEnd = recordEnd(0);
+        if (keyframeEnd == 0 || keyframeEnd > recordsSize || records[0] != RECORD_KEYFRAME ||
+            !decodeRecord(records, keyframeEnd, frame)) {
+            return false;
+        }
+        if (k == 0) return true;
+        const size_t start = recordEnd(k - 1);
+        const size_t end = recordEnd(k);
+        return start < end && end <= recordsSize && records[start] == RECORD_DELTA &&
+               decodeRecord(records + start, end - start, frame);
+    }
+
+    // Reads the header of the chunk at offset and checks that the chunk lies within the first
+    // size bytes of the file.
+    bool readChunkHeader(const uint8_t* data, size_t size, uint64_t offset, ChunkHeader& header) {
+        if (offset > size || size - offset < sizeof(header)) return false;
+        std::memcpy(&header, data + offset, sizeof(header));
+        return std::memcmp(header.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) == 0 && header.tickCount > 0 &&
+               header.size <= size - offset - sizeof(header) &&
+               static_cast<uint64_t>(header.tickCount) * sizeof(uint32_t) < header.size;
+    }
+
+    // Returns whether a chunk's contents match its checksum.
+    bool checkChunk(const uint8_t* data, uint64_t offset, const ChunkHeader& header) {
+        const uint8_t* body = data + offset + sizeof(header);
+        const size_t endsBytes = header.tickCount * sizeof(uint32_t);
+        return hashBytes(body + endsBytes, header.size - endsBytes, hashBytes(body, endsBytes)) == header.checksum;
+    }
+
+    // Decodes a tick from a chunk in a mapped file. The checksum is left to the index rebuild, so
+    // a seek touches only the chunk's header, its record ends and the two records it decodes.
+    bool readChunkTick(const uint8_t* data, size_t size, const ArchiveChunk& chunk, uint64_t tick,
+                       std::vector<uint32_t>& frame) {
+        ChunkHeader header;
+        if (!readChunkHeader(data, size, chunk.offset, header) || header.firstTick != chunk.firstTick ||
+            tick - header.firstTick >= header.tickCount) {
+            return false;
+        }
+        const uint8_t* ends = data + chunk.offset + sizeof(header);
+        const size_t endsBytes = header.tickCount * sizeof(uint32_t);
+        return decodeChunkTick(ends, ends + endsBytes, header.size - endsBytes,
+                               static_cast<uint32_t>(tick - header.firstTick), frame);
+    }
+
+    // Finds the chunk holding a tick with a binary search of the chunks' first ticks. The tick
+    // must not be before the first chunk.
+    const ArchiveChunk& findChunk(const std::vector<ArchiveChunk>& chunks, uint64_t tick) {
+        const auto after = std::upper_bound(chunks.begin(), chunks.end(), tick,
+                                            [](uint64_t t, const ArchiveChunk& chunk) { return t < chunk.firstTick; });
+        return *(after - 1);
+    }
+}
+
+// TimelineWriter implementation
+TimelineWriter::~TimelineWriter() {
+    close();
+}
+
+bool TimelineWriter::open(const std::string& archivePath, const EntityStore& entities, uint64_t firstTick, int tickRate) {
+    close();
+    file.open(archivePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        logArchiveError("TIMELINE: Failed to create " + archivePath);
+        return false;
+    }
+
+    ArchiveHeader header{};
+    std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+    header.byteOrder = ARCHIVE_BYTE_ORDER;
+    header.version = ARCHIVE_VERSION;
+    header.tickRate = static_cast<uint32_t>(tickRate);
+    header.firstTick = firstTick;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    path = archivePath;
+    chunks.clear();
+    recordEnds.clear();
+    records.clear();
+    mapped.close();
+    startTick = firstTick;
+    ticks = 0;
+    bytes = sizeof(header);
+    rate = tickRate;
+    record(entities);
+    return true;
+}
+
+// The records of the chunk holding the tick, up to and including it, are copied to become the open
+// chunk, so the file can be cut where that chunk starts and appended to from there.
+bool TimelineWriter::resume(const std::string& archivePath, const EntityStore& entities, uint64_t tick, int tickRate) {
+    close();
+    std::error_code error;
+    if (!std::filesystem::exists(archivePath, error)) {
+        return open(archivePath, entities, tick, tickRate);
+    }
+
+    uint64_t archiveStart = 0;
+    uint64_t cutOffset = 0;
+    {
+        TimelineReader reader;
+        EntityStore archived;
+        bool continues = reader.open(archivePath) && reader.tickRate() == tickRate && reader.seek(tick, archived);
+        if (continues) {
+            captureFrame(archived, keyframe);
+            captureFrame(entities, frame);
+            continues = keyframe == frame;
+        }
+        ChunkHeader header;
+        if (continues) {
+            const ArchiveChunk& chunk = findChunk(reader.index(), tick);
+            continues = mapped.open(archivePath) && readChunkHeader(mapped.data(), mapped.size(), chunk.offset, header);
+            if (continues) {
+                const uint8_t* ends = mapped.data() + chunk.offset + sizeof(header);
+                recordEnds.resize(static_cast<size_t>(tick - chunk.firstTick + 1));
+                std::memcpy(recordEnds.data(), ends, recordEnds.size() * sizeof(uint32_t));
+                const uint8_t* chunkRecords = ends + header.tickCount * sizeof(uint32_t);
+                records.assign(chunkRecords, chunkRecords + recordEnds.back());
+                continues = decodeRecord(records.data(), recordEnds[0], keyframe);
+                chunks.assign(reader.index().begin(), reader.index().begin() + (&chunk - reader.index().data()));
+                archiveStart = reader.firstTick();
+                cutOffset = chunk.offset;
+            }
+            mapped.close();
+        }
+        if (!continues) {
+            consoleCapture.addLine("TIMELINE: " + archivePath + " does not lead up to tick " + std::to_string(tick) +
+                                   ", starting a new archive");
+            return open(archivePath, entities, tick, tickRate);
+        }
+    }
+
+    // The ticks after the save, and the seek index if the archive was closed, are cut off.
+    std::filesystem::resize_file(archivePath, cutOffset, error);
+    if (!error) file.open(archivePath, std::ios::binary | std::ios::app);
+    if (!file.is_open()) {
+        logArchiveError("TIMELINE: Failed to continue " + archivePath);
+        chunks.clear();
+        recordEnds.clear();
+        records.clear();
+        return false;
+    }
+    path = archivePath;
+    startTick = archiveStart;
+    ticks = tick - archiveStart + 1;
+    bytes = cutOffset;
+    rate = tickRate;
+    consoleCapture.addLine("TIMELINE: Continuing " + archivePath + " from tick " + std::to_string(tick));
+    return true;
+}
+
+// A tick starts a new chunk once the open one is full, or when the number of entities changed,
+// since a delta needs its keyframe's layout.
+void TimelineWriter::record(const EntityStore& entities) {
+    if (!file.is_open()) return;
+    captureFrame(entities, frame);
+    if (recordEnds.size() >= ARCHIVE_CHUNK_TICKS || records.size() >= MAX_CHUNK_BYTES ||
+        (!recordEnds.empty() && frame.size() != keyframe.size())) {
+        flushChunk();
+    }
+    if (recordEnds.empty()) {
+        appendKeyframe(frame, records);
+        keyframe = frame;
+    } else {
+        appendDelta(frame, keyframe, records);
+    }
+    recordEnds.push_back(static_cast<uint32_t>(records.size()));
+    ++ticks;
+}
+
+// The chunk is flushed as soon as it is written, so a crash loses at most the open chunk.
+void TimelineWriter::flushChunk() {
+    if (recordEnds.empty() || !file.is_open()) return;
+    const size_t endsBytes = recordEnds.size() * sizeof(uint32_t);
+    ChunkHeader header{};
+    std::memcpy(header.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC));
+    header.tickCount = static_cast<uint32_t>(recordEnds.size());
+    header.firstTick = startTick + ticks - recordEnds.size();
+    header.size = static_cast<uint32_t>(endsBytes + records.size());
+    header.checksum = hashBytes(records.data(), records.size(), hashBytes(recordEnds.data(), endsBytes));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(recordEnds.data()), static_cast<std::streamsize>(endsBytes));
+    file.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size()));
+    file.flush();
+    if (!file) {
+        logArchiveError("TIMELINE: Failed to write " + path + ", archiving stopped");
+        file.close();
+        return;
+    }
+
+    chunks.push_back({header.firstTick, bytes});
+    bytes += sizeof(header) + header.size;
+    recordEnds.clear();
+    records.clear();
+}
+
+// The index is only written here; until then the chunk headers are enough to rebuild it.
+void TimelineWriter::close() {
+    if (!file.is_open()) return;
+    flushChunk();
+    if (!file.is_open()) return;
+
+    const size_t indexBytes = chunks.size() * sizeof(ArchiveChunk);
+    ArchiveFooter footer{};
+    footer.indexOffset = bytes;
+    footer.chunkCount = chunks.size();
+    std::memcpy(footer.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    footer.checksum = hashBytes(chunks.data(), indexBytes);
+    file.write(reinterpret_cast<const char*>(chunks.data()), static_cast<std::streamsize>(indexBytes));
+    file.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+    bytes += indexBytes + sizeof(footer);
+    file.close();
+    mapped.close();
+}
+
+// Ticks in the open chunk are decoded from memory. Older ones are read from the file, which is
+// mapped again only if it has grown since the last seek.
+bool TimelineWriter::seek(uint64_t tick, EntityStore& entities) {
+    if (!file.is_open() || tick < startTick || tick - startTick >= ticks) return false;
+    const uint64_t openChunkTick = startTick + ticks - recordEnds.size();
+    bool decoded;
+    if (tick >= openChunkTick) {
+        decoded = decodeChunkTick(reinterpret_cast<const uint8_t*>(recordEnds.data()), records.data(), records.size(),
+                                  static_cast<uint32_t>(tick - openChunkTick), frame);
+    } else {
+        if (mapped.size() < bytes) mapped.open(path);
+        decoded = readChunkTick(mapped.data(), mapped.size(), findChunk(chunks, tick), tick, frame);
+    }
+    if (!decoded) {
+        logArchiveError("TIMELINE: Tick " + std::to_string(tick) + " of " + path + " could not be read");
+        return false;
+    }
+    applyFrame(frame, entities);
+    return true;
+}
+
+// TimelineReader implementation
+// A closed archive's index is checked and copied; otherwise the chunks are walked from the start,
+// stopping at the first one that is cut short or does not match its checksum.
+bool TimelineReader::open(const std::string& archivePath) {
+    path = archivePath;
+    chunks.clear();
+    startTick = 0;
+    ticks = 0;
+    rate = 0;
+    if (!file.open(path)) {
+        logArchiveError("TIMELINE: Failed to open " + path);
+        return false;
+    }
+    const auto invalid = [this](const std::string& reason) {
+        logArchiveError("TIMELINE: " + path + " " + reason);
+        chunks.clear();
+        file.close();
+        return false;
+    };
+
+    const uint8_t* data = file.data();
+    ArchiveHeader header;
+    if (file.size() < sizeof(header)) return invalid("is not a timeline archive");
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0) return invalid("is not a timeline archive");
+    if (header.byteOrder != ARCHIVE_BYTE_ORDER) return invalid("was written on a machine with a different byte order");
+    if (header.version == 0 || header.version > ARCHIVE_VERSION) {
+        return invalid("has format version " + std::to_string(header.version) + ", this build reads up to " +
+                       std::to_string(ARCHIVE_VERSION));
+    }
+    startTick = header.firstTick;
+    rate = static_cast<int>(header.tickRate);
+
+    ArchiveFooter footer{};
+    if (file.size() >= sizeof(header) + sizeof(footer)) {
+        std::memcpy(&footer, data + file.size() - sizeof(footer), sizeof(footer));
+    }
+    const size_t indexEnd = file.size() - sizeof(footer);
+    const bool closed = std::memcmp(footer.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 &&
+                        footer.indexOffset >= sizeof(header) && footer.indexOffset <= indexEnd &&
+                        footer.chunkCount == (indexEnd - footer.indexOffset) / sizeof(ArchiveChunk) &&
+                        (indexEnd - footer.indexOffset) % sizeof(ArchiveChunk) == 0 &&
+                        hashBytes(data + footer.indexOffset, indexEnd - footer.indexOffset) == footer.checksum;
+
+    ChunkHeader last{};
+    if (closed) {
+        chunks.resize(static_cast<size_t>(footer.chunkCount));
+        std::memcpy(chunks.data(), data + footer.indexOffset, chunks.size() * sizeof(ArchiveChunk));
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            const bool ordered = i == 0 ? chunks[i].firstTick == startTick && chunks[i].offset == sizeof(header)
+                                        : chunks[i].firstTick > chunks[i - 1].firstTick && chunks[i].offset > chunks[i - 1].offset;
+            if (!ordered || chunks[i].offset >= footer.indexOffset) return invalid("has a bad seek index");
+        }
+        if (chunks.empty() || !readChunkHeader(data, static_cast<size_t>(footer.indexOffset), chunks.back().offset, last) ||
+            last.firstTick != chunks.back().firstTick) {
+            return invalid("has a bad seek index");
+        }
+    } else {
+        uint64_t offset = sizeof(header);
+        uint64_t nextTick = startTick;
+        ChunkHeader chunk;
+        while (readChunkHeader(data, file.size(), offset, chunk) && chunk.firstTick == nextTick &&
+               checkChunk(data, offset, chunk)) {
+            chunks.push_back({chunk.firstTick, offset});
+            last = chunk;
+            offset += sizeof(chunk) + chunk.size;
+            nextTick += chunk.tickCount;
+        }
+        if (chunks.empty()) return invalid("holds no complete chunks");
+        consoleCapture.addLine("TIMELINE: " + path + " was not closed; recovered " +
+                               std::to_string(nextTick - startTick) + " ticks");
+    }
+    ticks = last.firstTick + last.tickCount - startTick;
+    return true;
+}
+
+bool TimelineReader::seek(uint64_t tick, EntityStore& entities) {
+    if (chunks.empty() || tick < startTick || tick - startTick >= ticks) return false;
+    if (!readChunkTick(file.data(), file.size(), findChunk(chunks, tick), tick, frame)) {
+        logArchiveError("TIMELINE: Tick " + std::to_string(tick) + " of " + path + " could not be read");
+        return false;
+    }
+    applyFrame(frame, entities);
+    return true;
+}
@@ -0,0 +1,113 @@
+#ifndef TIMELINE_ARCHIVE_H
+#define TIMELINE_ARCHIVE_H
+
+#include "EntityStore.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Constants for the timeline archive.
+constexpr uint16_t ARCHIVE_VERSION = 1;      // The archive format written by this build.
+constexpr uint32_t ARCHIVE_CHUNK_TICKS = 64; // The ticks in a chunk: a keyframe, then deltas against it.
+
+// The ArchiveChunk struct is one entry of an archive's seek index.
+struct ArchiveChunk {
+    uint64_t firstTick; // The tick of the chunk's keyframe.
+    uint64_t offset;    // The chunk's position in the file.
+};
+
+// The TimelineWriter class appends the state of every entity, every tick, to an archive file, so a
+// whole session can be scrubbed through later. Ticks are gathered into chunks of a full keyframe
+// and XOR deltas against it trimmed to their significant bytes, the same encoding the rewind
+// history uses. Each chunk is written in one go once it is full, and closing the archive appends
+// a seek index of every chunk. An archive that was never closed is still readable, since
+// TimelineReader rebuilds the index from the chunks.
+class TimelineWriter {
+public:
+    TimelineWriter() = default;
+    ~TimelineWriter();
+
+    TimelineWriter(const TimelineWriter&) = delete;
+    TimelineWriter& operator=(const TimelineWriter&) = delete;
+
+    // Creates the file and archives the current state of the entities as firstTick. Returns false
+    // if the file cannot be created.
+    bool open(const std::string& path, const EntityStore& entities, uint64_t firstTick, int tickRate);
+    // Continues the archive at path from tick, for a session resumed from a save. The archive is
+    // kept up to tick and cut after it if it holds tick in the same state as the entities;
+    // otherwise a new archive is started as with open(). Returns false if neither works.
+    bool resume(const std::string& path, const EntityStore& entities, uint64_t tick, int tickRate);
+    // Archives the state of the entities as the next tick.
+    void record(const EntityStore& entities);
+    // Writes the last chunk and the seek index, and closes the file.
+    void close();
+    // Restores the entities to an archived tick: O(log n) to find its chunk, then one keyframe and
+    // one delta decoded. Ticks already written are read back through a mapping of the file.
+    // Returns false, leaving the entities unchanged, if the tick is not archived or is corrupt.
+    bool seek(uint64_t tick, EntityStore& entities);
+
+    // Checks if an archive is being written.
+    bool isOpen() const { return file.is_open(); }
+    // Returns the tick the archive starts at.
+    uint64_t firstTick() const { return startTick; }
+    // Returns the number of ticks archived so far.
+    uint64_t tickCount() const { return ticks; }
+    // Returns the tick rate the archive was recorded at.
+    int tickRate() const { return rate; }
+    // Returns the number of bytes written so far, not counting the open chunk.
+    uint64_t bytesWritten() const { return bytes; }
+
+private:
+    // Writes the open chunk to the file and starts a new one.
+    void flushChunk();
+
+    std::ofstream file;
+    std::string path;
+    std::vector<ArchiveChunk> chunks;  // The chunks written so far.
+    std::vector<uint32_t> frame;       // The tick being recorded, as raw bits.
+    std::vector<uint32_t> keyframe;    // The open chunk's keyframe.
+    std::vector<uint32_t> recordEnds;  // The end of each of the open chunk's records.
+    std::vector<uint8_t> records;      // The open chunk's records.
+    MappedFile mapped;                 // The file as of the last seek into a written chunk.
+    uint64_t startTick = 0;
+    uint64_t ticks = 0;
+    uint64_t bytes = 0;
+    int rate = 0;
+};
+
+// The TimelineReader class seeks through an archive written by TimelineWriter. The file is mapped,
+// so a seek only reads the index and the one chunk it lands in.
+class TimelineReader {
+public:
+    // Maps the archive and reads its seek index, or rebuilds the index if the archive was not
+    // closed. Returns false if the file is missing or not an archive.
+    bool open(const std::string& path);
+    // Restores the entities to an archived tick: O(log n) to find its chunk, then one keyframe and
+    // one delta decoded. Returns false, leaving the entities unchanged, if the tick is not
+    // archived or is corrupt.
+    bool seek(uint64_t tick, EntityStore& entities);
+
+    // Returns the tick the archive starts at.
+    uint64_t firstTick() const { return startTick; }
+    // Returns the number of ticks in the archive.
+    uint64_t tickCount() const { return ticks; }
+    // Returns the tick rate the archive was recorded at.
+    int tickRate() const { return rate; }
+    // Returns the number of chunks in the archive.
+    size_t chunkCount() const { return chunks.size(); }
+    // Returns the seek index: where each chunk starts.
+    const std::vector<ArchiveChunk>& index() const { return chunks; }
+
+private:
+    MappedFile file;
+    std::string path;
+    std::vector<ArchiveChunk> chunks;
+    std::vector<uint32_t> frame;       // The tick being restored, as raw bits.
+    uint64_t startTick = 0;
+    uint64_t ticks = 0;
+    int rate = 0;
+};
+
+#endif // TIMELINE_ARCHIVE_H
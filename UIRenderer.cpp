@@ -1,13 +1,62 @@
 #include "UIRenderer.h"
 #include "ConsoleCapture.h"
 #include "Version.h"
+#include "Profiler.h"
+#include "FrameArena.h"
 #include "raylib.h"
+#include "rlgl.h"
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <cstdint>
 
 // A global cache for the console layout to avoid recalculating it every frame.
 static ConsoleLayout consoleLayout;
 
+// The ConsolePanelCache struct holds the console panel as last drawn, and what it was drawn from.
+struct ConsolePanelCache {
+    RenderTexture2D target{};      // The panel, with premultiplied alpha.
+    uint64_t consoleVersion = 0;   // The console version the panel shows.
+    std::string inputText;         // The input text the panel shows.
+    int cursorPosition = 0;
+    bool inputActive = false;
+    bool valid = false;            // False forces a redraw.
+};
+
+// Global caches for the console panel and the glyph advances of its text.
+static ConsolePanelCache consolePanel;
+static GlyphAdvanceCache consoleGlyphs;
+
+// Rebuilds the advance table for a new font size, using the same rules as MeasureText.
+void GlyphAdvanceCache::update(int size) {
+    if (size == fontSize) return;
+    
+    const Font font = GetFontDefault();
+    constexpr int defaultFontSize = 10;
+    const int measuredSize = std::max(size, defaultFontSize);
+    scale = static_cast<float>(measuredSize) / static_cast<float>(font.baseSize);
+    spacing = static_cast<float>(measuredSize / defaultFontSize);
+    
+    for (int c = 0; c < static_cast<int>(advance.size()); ++c) {
+        const int index = GetGlyphIndex(font, c);
+        advance[c] = font.glyphs[index].advanceX != 0
+            ? static_cast<float>(font.glyphs[index].advanceX)
+            : font.recs[index].width + static_cast<float>(font.glyphs[index].offsetX);
+    }
+    fontSize = size;
+}
+
+// Measures text from the advance table. Characters outside ASCII are measured as '?'.
+int GlyphAdvanceCache::measure(const char* text, size_t length) const {
+    if (length == 0) return 0;
+    float width = 0.0f;
+    for (size_t i = 0; i < length; ++i) {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+        width += advance[c < advance.size() ? c : '?'];
+    }
+    return static_cast<int>(width * scale + spacing * static_cast<float>(length - 1));
+}
+
 // Updates the console layout cache with the current parameters.
 void ConsoleLayout::update(bool showFPS, int consoleWidth, int consoleHeight, int consoleFontSize) {
     x = 10;
@@ -41,15 +90,9 @@ bool ConsoleLayout::shouldUpdate(bool showFPS, int consoleWidth, int consoleHeig
            lastFontSize != consoleFontSize;
 }
 
-// Draws the developer console on the screen.
-void DrawConsole(bool showFPS, int consoleWidth, int consoleHeight, int consoleFontSize, const ConsoleInput& consoleInput) {
-    // Recalculate the console layout only when necessary.
-    if (consoleLayout.shouldUpdate(showFPS, consoleWidth, consoleHeight, consoleFontSize)) {
-        consoleLayout.update(showFPS, consoleWidth, consoleHeight, consoleFontSize);
-    }
-    
-    const auto& layout = consoleLayout;
-    
+// Draws the console panel at the layout's position. Returns false if a line could not be read,
+// which happens when it is being written at the same moment.
+static bool DrawConsolePanel(const ConsoleLayout& layout, const ConsoleInput& consoleInput) {
     // Draw the console's background and border.
     DrawRectangle(layout.x, layout.y, layout.width, layout.height, 
                   Fade(BLACK, CONSOLE_BACKGROUND_ALPHA));
@@ -61,26 +104,94 @@ void DrawConsole(bool showFPS, int consoleWidth, int consoleHeight, int consoleF
              layout.y + layout.padding, 
              layout.titleFontSize, WHITE);
     
-    // Draw the captured console lines.
-    const auto& lines = consoleCapture.getLines();
-    if (lines.empty()) return;  // No lines to draw.
-    
+    // Draw the tail of the captured console lines, oldest at the top.
     const int startY = layout.y + layout.titleHeight;
-    const int linesToShow = std::min(static_cast<int>(lines.size()), layout.maxDisplayLines);
-    const int startIndex = std::max(0, static_cast<int>(lines.size()) - linesToShow);
+    const int linesToShow = std::min(static_cast<int>(consoleCapture.lineCount()), layout.maxDisplayLines);
     
-    // Render the visible lines efficiently.
+    bool complete = true;
+    ConsoleCapture::LineBuffer line;
     for (int i = 0; i < linesToShow; ++i) {
-        const int lineIndex = startIndex + i;
+        // A line that is being written right now is skipped, and the panel redrawn next frame.
+        if (!consoleCapture.tailLine(linesToShow - 1 - i, line)) {
+            complete = false;
+            continue;
+        }
         const int textY = startY + (i * layout.lineHeight);
         
-        DrawText(lines[lineIndex].c_str(), 
+        DrawText(line.data(), 
                  layout.x + layout.padding, 
                  textY, 
                  layout.textFontSize, LIGHTGRAY);
     }
     // Draw the console input box.
     DrawConsoleInputBox(layout, consoleInput);
+    return complete;
+}
+
+// Redraws the console panel into its render texture, recreating the texture if the size changed.
+static void RedrawConsolePanel(const ConsoleLayout& layout, const ConsoleInput& consoleInput, uint64_t consoleVersion) {
+    ConsolePanelCache& panel = consolePanel;
+    if (panel.target.id == 0 || panel.target.texture.width != layout.width || 
+        panel.target.texture.height != layout.height) {
+        if (panel.target.id != 0) UnloadRenderTexture(panel.target);
+        panel.target = LoadRenderTexture(layout.width, layout.height);
+    }
+    
+    // Draw at the texture's origin.
+    ConsoleLayout local = layout;
+    local.x = 0;
+    local.y = 0;
+    
+    BeginTextureMode(panel.target);
+    ClearBackground(BLANK);
+    // Blend alpha with (one, one minus source alpha) so the texture holds premultiplied alpha,
+    // which composites onto the screen the same way drawing the panel directly would.
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, 
+                              RL_FUNC_ADD, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+    const bool complete = DrawConsolePanel(local, consoleInput);
+    EndBlendMode();
+    EndTextureMode();
+    
+    panel.consoleVersion = consoleVersion;
+    panel.inputText = consoleInput.text;
+    panel.cursorPosition = consoleInput.cursorPosition;
+    panel.inputActive = consoleInput.active;
+    panel.valid = complete;
+}
+
+// Draws the developer console on the screen, redrawing the cached panel only if it changed.
+void DrawConsole(bool showFPS, int consoleWidth, int consoleHeight, int consoleFontSize, const ConsoleInput& consoleInput) {
+    PROFILE_ZONE("DrawConsole");
+    // Recalculate the console layout only when necessary.
+    if (consoleLayout.shouldUpdate(showFPS, consoleWidth, consoleHeight, consoleFontSize)) {
+        consoleLayout.update(showFPS, consoleWidth, consoleHeight, consoleFontSize);
+        consolePanel.valid = false;
+    }
+    
+    const auto& layout = consoleLayout;
+    const uint64_t consoleVersion = consoleCapture.version();
+    const ConsolePanelCache& panel = consolePanel;
+    if (!panel.valid || panel.consoleVersion != consoleVersion || panel.inputActive != consoleInput.active ||
+        panel.cursorPosition != consoleInput.cursorPosition || panel.inputText != consoleInput.text) {
+        RedrawConsolePanel(layout, consoleInput, consoleVersion);
+    }
+    
+    // Render textures are stored upside down, hence the negative source height.
+    const Rectangle source = {0.0f, 0.0f, static_cast<float>(layout.width), -static_cast<float>(layout.height)};
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    DrawTextureRec(panel.target.texture, source, 
+                   {static_cast<float>(layout.x), static_cast<float>(layout.y)}, WHITE);
+    EndBlendMode();
+}
+
+// Releases the console panel's render texture.
+void UnloadUIResources() {
+    if (consolePanel.target.id != 0) {
+        UnloadRenderTexture(consolePanel.target);
+        consolePanel.target = RenderTexture2D{};
+    }
+    consolePanel.valid = false;
 }
 
 // Draws the console input box at the bottom of the console.
@@ -98,106 +209,207 @@ void DrawConsoleInputBox(const ConsoleLayout& layout, const ConsoleInput& consol
     // Draw the input text.
     DrawText(consoleInput.text.c_str(), textX, textY, layout.textFontSize, WHITE);
 
-    // Draw the cursor if the input box is active.
+    // Draw the cursor if the input box is active, measuring the text before it from the glyph table.
     if (consoleInput.active) {
-        const int cursorX = textX + MeasureText(consoleInput.text.substr(0, consoleInput.cursorPosition).c_str(), layout.textFontSize);
+        consoleGlyphs.update(layout.textFontSize);
+        const size_t cursor = std::min(consoleInput.text.size(), static_cast<size_t>(std::max(0, consoleInput.cursorPosition)));
+        const int cursorX = textX + consoleGlyphs.measure(consoleInput.text.data(), cursor);
         DrawLine(cursorX, textY, cursorX, textY + layout.textFontSize, WHITE);
     }
 }
 
-// Draws the title screen.
-void DrawTitleScreen(int screenWidth, int screenHeight) {
-    ClearBackground(DARKGRAY);
-    
-    // Title text configuration.
-    constexpr const char* gameTitle = GAME_NAME_CAPS;
-    constexpr const char* startInstruction = "Press SPACE to start";
-    constexpr const char* quitInstruction = "Press ESC to quit";
-    
+// Measures text at a font size, placing it at the left edge.
+TextItem measureTextItem(const char* text, int fontSize, int y) {
+    TextItem item;
+    item.text = text;
+    item.fontSize = fontSize;
+    item.width = MeasureText(text, fontSize);
+    item.y = y;
+    return item;
+}
+
+// Places text centered horizontally in the span [left, left + width), measuring it once.
+TextItem centerText(const char* text, int fontSize, int left, int width, int y) {
+    TextItem item = measureTextItem(text, fontSize, y);
+    item.x = left + (width - item.width) / 2;
+    return item;
+}
+
+// Places text so that it ends at right, measuring it once.
+TextItem rightAlignText(const char* text, int fontSize, int right, int y) {
+    TextItem item = measureTextItem(text, fontSize, y);
+    item.x = right - item.width;
+    return item;
+}
+
+// Returns the default font, which the menus are drawn with.
+UIFont currentUIFont() {
+    const Font font = GetFontDefault();
+    return UIFont{font.texture.id, font.baseSize};
+}
+
+// Checks if a screen layout needs to be recalculated for the given screen size and font.
+bool ScreenLayout::shouldUpdate(int screenWidth, int screenHeight, const UIFont& font) const {
+    return needsUpdate || lastWidth != screenWidth || lastHeight != screenHeight || lastFont != font;
+}
+
+// Records the screen size and font a layout was calculated for.
+void ScreenLayout::markUpdated(int screenWidth, int screenHeight, const UIFont& font) {
+    lastWidth = screenWidth;
+    lastHeight = screenHeight;
+    lastFont = font;
+    needsUpdate = false;
+}
+
+// Calculates the title screen's text sizes and positions for the given screen size and font.
+void TitleScreenLayout::update(int screenWidth, int screenHeight, const UIFont& font) {
     // Scale font sizes based on screen dimensions for better readability.
     const int titleFontSize = std::max(48, screenWidth / 20);
     const int instructionFontSize = std::max(20, screenWidth / 40);
     
-    // Calculate centered positions for the text.
-    const int titleWidth = MeasureText(gameTitle, titleFontSize);
-    const int titleX = (screenWidth - titleWidth) / 2;
-    const int titleY = screenHeight / 2 - 100;
+    title = centerText(GAME_NAME_CAPS, titleFontSize, 0, screenWidth, screenHeight / 2 - 100);
+    start = centerText("Press SPACE to start", instructionFontSize, 0, screenWidth, title.y + titleFontSize + 60);
+    quit = centerText("Press ESC to quit", instructionFontSize, 0, screenWidth, start.y + instructionFontSize + 20);
     
-    const int startWidth = MeasureText(startInstruction, instructionFontSize);
-    const int startX = (screenWidth - startWidth) / 2;
-    const int startY = titleY + titleFontSize + 60;
+    // The game version sits in the bottom right corner.
+    constexpr int versionFontSize = 16;
+    version = rightAlignText(VERSION_SHORT, versionFontSize, screenWidth - 10, screenHeight - versionFontSize - 10);
     
-    const int quitWidth = MeasureText(quitInstruction, instructionFontSize);
-    const int quitX = (screenWidth - quitWidth) / 2;
-    const int quitY = startY + instructionFontSize + 20;
+    markUpdated(screenWidth, screenHeight, font);
+}
+
+// Calculates the pause menu's box and text positions for the given screen size and font.
+void PauseScreenLayout::update(int screenWidth, int screenHeight, const UIFont& font) {
+    constexpr int titleFontSize = 24;
+    constexpr int instructionFontSize = 16;
     
-    // Draw the title with a subtle shadow/glow effect.
-    DrawText(gameTitle, titleX + 3, titleY + 3, titleFontSize, BLACK);
-    DrawText(gameTitle, titleX, titleY, titleFontSize, WHITE);
+    // Center the pause box on the screen, and the text within the box.
+    boxX = (screenWidth - PAUSE_BOX_WIDTH) / 2;
+    boxY = (screenHeight - PAUSE_BOX_HEIGHT) / 2;
+    title = centerText("GAME PAUSED", titleFontSize, boxX, PAUSE_BOX_WIDTH, boxY + 20);
+    resume = centerText("Press ESC to resume", instructionFontSize, boxX, PAUSE_BOX_WIDTH, boxY + 55);
+    toTitle = centerText("Press T to return to title", instructionFontSize, boxX, PAUSE_BOX_WIDTH, boxY + 80);
+    quit = centerText("Press Q to quit", instructionFontSize, boxX, PAUSE_BOX_WIDTH, boxY + 105);
     
-    // Draw the instructions.
-    DrawText(startInstruction, startX, startY, instructionFontSize, LIGHTGRAY);
-    DrawText(quitInstruction, quitX, quitY, instructionFontSize, GRAY);
+    markUpdated(screenWidth, screenHeight, font);
+}
+
+// Global caches for the menu screen layouts.
+static TitleScreenLayout titleLayout;
+static PauseScreenLayout pauseLayout;
+
+// Draws a laid out piece of text.
+static void DrawTextItem(const TextItem& item, Color color) {
+    DrawText(item.text, item.x, item.y, item.fontSize, color);
+}
+
+// Draws the title screen.
+void DrawTitleScreen(int screenWidth, int screenHeight) {
+    PROFILE_ZONE("DrawTitleScreen");
+    const UIFont font = currentUIFont();
+    if (titleLayout.shouldUpdate(screenWidth, screenHeight, font)) {
+        titleLayout.update(screenWidth, screenHeight, font);
+    }
+    const auto& layout = titleLayout;
     
-    // Create a simple pulsing animation for the "Press SPACE" text.
+    ClearBackground(DARKGRAY);
+    
+    // Draw the title with a subtle shadow/glow effect.
+    DrawText(layout.title.text, layout.title.x + 3, layout.title.y + 3, layout.title.fontSize, BLACK);
+    DrawTextItem(layout.title, WHITE);
+    
+    // Pulse the "Press SPACE" text.
     static float pulseTime = 0.0f;
     pulseTime += GetFrameTime() * 3.0f;
-    const float pulse = (sin(pulseTime) + 1.0f) / 2.0f;
-    const Color pulseColor = {
-        static_cast<unsigned char>(LIGHTGRAY.r),
-        static_cast<unsigned char>(LIGHTGRAY.g), 
-        static_cast<unsigned char>(LIGHTGRAY.b),
-        static_cast<unsigned char>(255 * (0.5f + pulse * 0.5f))
-    };
-    
-    // Redraw the start instruction with the pulsing color.
-    DrawText(startInstruction, startX, startY, instructionFontSize, pulseColor);
+    const float pulse = (std::sin(pulseTime) + 1.0f) / 2.0f;
+    DrawTextItem(layout.start, Fade(LIGHTGRAY, 0.5f + pulse * 0.5f));
+    DrawTextItem(layout.quit, GRAY);
     
     // Draw the game version in the bottom right corner.
-    constexpr int versionFontSize = 16;
-    const int versionWidth = MeasureText(VERSION_SHORT, versionFontSize);
-    const int versionX = screenWidth - versionWidth - 10;
-    const int versionY = screenHeight - versionFontSize - 10;
-    DrawText(VERSION_SHORT, versionX, versionY, versionFontSize, BLACK);
+    DrawTextItem(layout.version, BLACK);
 }
 
 // Draws the pause screen overlay.
 void DrawPauseScreen(int screenWidth, int screenHeight) {
+    PROFILE_ZONE("DrawPauseScreen");
+    const UIFont font = currentUIFont();
+    if (pauseLayout.shouldUpdate(screenWidth, screenHeight, font)) {
+        pauseLayout.update(screenWidth, screenHeight, font);
+    }
+    const auto& layout = pauseLayout;
+    
     // Draw a semi-transparent overlay to dim the background.
     DrawRectangle(0, 0, screenWidth, screenHeight, Fade(BLACK, PAUSE_OVERLAY_ALPHA));
     
-    // Calculate the position for the centered pause box.
-    const int pauseBoxX = (screenWidth - PAUSE_BOX_WIDTH) / 2;
-    const int pauseBoxY = (screenHeight - PAUSE_BOX_HEIGHT) / 2;
-    
     // Draw the pause menu background and border.
-    DrawRectangle(pauseBoxX, pauseBoxY, PAUSE_BOX_WIDTH, PAUSE_BOX_HEIGHT, BLACK);
-    DrawRectangleLines(pauseBoxX, pauseBoxY, PAUSE_BOX_WIDTH, PAUSE_BOX_HEIGHT, WHITE);
+    DrawRectangle(layout.boxX, layout.boxY, PAUSE_BOX_WIDTH, PAUSE_BOX_HEIGHT, BLACK);
+    DrawRectangleLines(layout.boxX, layout.boxY, PAUSE_BOX_WIDTH, PAUSE_BOX_HEIGHT, WHITE);
     
-    // Text configuration for the pause menu.
-    constexpr int titleFontSize = 24;
-    constexpr int instructionFontSize = 16;
-    constexpr const char* titleText = "GAME PAUSED";
-    constexpr const char* resumeText = "Press ESC to resume";
-    constexpr const char* titleText2 = "Press T to return to title";
-    constexpr const char* quitText = "Press Q to quit";
+    // Draw the text in the pause menu.
+    DrawTextItem(layout.title, WHITE);
+    DrawTextItem(layout.resume, LIGHTGRAY);
+    DrawTextItem(layout.toTitle, LIGHTGRAY);
+    DrawTextItem(layout.quit, LIGHTGRAY);
+}
+
+// Draws the profiler overlay in the top right corner.
+void DrawProfilerOverlay(int screenWidth) {
+    constexpr int fontSize = 10;
+    constexpr int lineHeight = fontSize + 2;
+    constexpr int padding = 6;
     
-    // Calculate centered text positions within the pause box.
-    const int titleWidth = MeasureText(titleText, titleFontSize);
-    const int titleX = pauseBoxX + (PAUSE_BOX_WIDTH - titleWidth) / 2;
+    const int zoneCount = static_cast<int>(profiler.zoneCount());
+    const int x = screenWidth - PROFILER_WIDTH - 10;
+    const int y = 40;
+    const int height = padding * 3 + lineHeight * (zoneCount + 2) + PROFILER_GRAPH_HEIGHT;
     
-    const int resumeWidth = MeasureText(resumeText, instructionFontSize);
-    const int resumeX = pauseBoxX + (PAUSE_BOX_WIDTH - resumeWidth) / 2;
+    DrawRectangle(x, y, PROFILER_WIDTH, height, Fade(BLACK, CONSOLE_BACKGROUND_ALPHA));
+    DrawRectangleLines(x, y, PROFILER_WIDTH, height, WHITE);
     
-    const int titleWidth2 = MeasureText(titleText2, instructionFontSize);
-    const int titleX2 = pauseBoxX + (PAUSE_BOX_WIDTH - titleWidth2) / 2;
+    // Draw one row per zone with its per-frame p50 and p99.
+    int textY = y + padding;
+    DrawText("zone", x + padding, textY, fontSize, WHITE);
+    DrawText("p50 ms", x + PROFILER_WIDTH - 120, textY, fontSize, WHITE);
+    DrawText("p99 ms", x + PROFILER_WIDTH - 60, textY, fontSize, WHITE);
+    char value[16];
+    for (int zone = 0; zone < zoneCount; ++zone) {
+        textY += lineHeight;
+        const auto& stats = profiler.zoneStats(zone);
+        DrawText(profiler.zoneName(zone), x + padding, textY, fontSize, LIGHTGRAY);
+        snprintf(value, sizeof(value), "%.3f", stats.p50);
+        DrawText(value, x + PROFILER_WIDTH - 120, textY, fontSize, LIGHTGRAY);
+        snprintf(value, sizeof(value), "%.3f", stats.p99);
+        DrawText(value, x + PROFILER_WIDTH - 60, textY, fontSize, LIGHTGRAY);
+    }
     
-    const int quitWidth = MeasureText(quitText, instructionFontSize);
-    const int quitX = pauseBoxX + (PAUSE_BOX_WIDTH - quitWidth) / 2;
+    // Draw the frame arena's use in the last frame.
+    textY += lineHeight;
+    char arenaText[64];
+#ifdef DEBUG
+    snprintf(arenaText, sizeof(arenaText), "frame arena %.1f / %zu KB, %llu heap allocs",
+             static_cast<double>(frameArena.lastFrameBytes()) / 1024.0, frameArena.capacity() / 1024,
+             static_cast<unsigned long long>(FrameArena::lastFrameHeapCalls()));
+#else
+    snprintf(arenaText, sizeof(arenaText), "frame arena %.1f / %zu KB",
+             static_cast<double>(frameArena.lastFrameBytes()) / 1024.0, frameArena.capacity() / 1024);
+#endif
+    DrawText(arenaText, x + padding, textY, fontSize, LIGHTGRAY);
     
-    // Draw the text in the pause menu.
-    DrawText(titleText, titleX, pauseBoxY + 20, titleFontSize, WHITE);
-    DrawText(resumeText, resumeX, pauseBoxY + 55, instructionFontSize, LIGHTGRAY);
-    DrawText(titleText2, titleX2, pauseBoxY + 80, instructionFontSize, LIGHTGRAY);
-    DrawText(quitText, quitX, pauseBoxY + 105, instructionFontSize, LIGHTGRAY);
-}
\ No newline at end of file
+    // Draw the frame time graph, newest frame on the right, one pixel per frame.
+    const int graphX = x + padding;
+    const int graphY = textY + lineHeight + padding;
+    const int graphWidth = PROFILER_WIDTH - padding * 2;
+    const int bars = std::min(graphWidth, static_cast<int>(profiler.frameCount()));
+    for (int n = 0; n < bars; ++n) {
+        const float ms = profiler.frameTime(n);
+        const int barHeight = std::min(PROFILER_GRAPH_HEIGHT,
+            static_cast<int>(ms / PROFILER_GRAPH_MAX_MS * PROFILER_GRAPH_HEIGHT));
+        const Color color = ms > 1000.0f / 60.0f ? RED : GREEN;
+        DrawLine(graphX + graphWidth - 1 - n, graphY + PROFILER_GRAPH_HEIGHT,
+                 graphX + graphWidth - 1 - n, graphY + PROFILER_GRAPH_HEIGHT - barHeight, color);
+    }
+    
+    // Mark the 60 FPS budget.
+    const int budgetY = graphY + PROFILER_GRAPH_HEIGHT - static_cast<int>(1000.0f / 60.0f / PROFILER_GRAPH_MAX_MS * PROFILER_GRAPH_HEIGHT);
+    DrawLine(graphX, budgetY, graphX + graphWidth, budgetY, Fade(WHITE, 0.5f));
+}
@@ -1,5 +1,7 @@
 #ifndef UI_RENDERER_H
 #define UI_RENDERER_H
+#include <array>
+#include <cstddef>
 #include <string>
 
 // Constants for UI rendering.
@@ -8,6 +10,9 @@ constexpr float CONSOLE_BACKGROUND_ALPHA = 0.8f; // The alpha of the console bac
 constexpr int PAUSE_BOX_WIDTH = 300;             // The width of the pause menu box.
 constexpr int PAUSE_BOX_HEIGHT = 170;            // The height of the pause menu box.
 constexpr int CONSOLE_LINE_SPACING = 4;          // The vertical spacing between lines in the console.
+constexpr int PROFILER_WIDTH = 300;              // The width of the profiler overlay.
+constexpr int PROFILER_GRAPH_HEIGHT = 60;        // The height of the frame time graph.
+constexpr float PROFILER_GRAPH_MAX_MS = 33.3f;   // The frame time at the top of the graph.
 
 // The ConsoleLayout struct holds the cached layout information for the console.
 // This is used to avoid recalculating the layout every frame.
@@ -30,6 +35,83 @@ private:
     int lastWidth = 0, lastHeight = 0, lastFontSize = 0;
 };
 
+// The TextItem struct is a piece of text with its measured width and screen position.
+struct TextItem {
+    const char* text = ""; // The text, which must outlive the item (usually a literal).
+    int x = 0, y = 0;      // The top left corner of the text.
+    int fontSize = 0;
+    int width = 0;         // The measured width of the text.
+};
+
+// Measures text at a font size, for placing it.
+TextItem measureTextItem(const char* text, int fontSize, int y);
+// Places text centered horizontally in the span [left, left + width), measuring it once.
+TextItem centerText(const char* text, int fontSize, int left, int width, int y);
+// Places text so that it ends at right, measuring it once.
+TextItem rightAlignText(const char* text, int fontSize, int right, int y);
+
+// The UIFont struct identifies the font menu text is measured with: its texture and base size.
+// A font reloaded with the window gets a new texture, so measurements taken before are stale.
+struct UIFont {
+    unsigned int textureId = 0;
+    int baseSize = 0;
+    
+    bool operator==(const UIFont& other) const { return textureId == other.textureId && baseSize == other.baseSize; }
+    bool operator!=(const UIFont& other) const { return !(*this == other); }
+};
+
+// Returns the font menu text is measured and drawn with. Needs a window.
+UIFont currentUIFont();
+
+// The ScreenLayout struct tracks the screen size and font a cached menu layout was calculated for.
+// Like ConsoleLayout, a layout is only recalculated when its inputs change.
+struct ScreenLayout {
+    bool needsUpdate = true; // Whether the layout needs to be recalculated.
+    
+    // Checks if the layout needs to be recalculated for the given screen size and font.
+    bool shouldUpdate(int screenWidth, int screenHeight, const UIFont& font) const;
+    
+protected:
+    // Records the screen size and font the layout was calculated for.
+    void markUpdated(int screenWidth, int screenHeight, const UIFont& font);
+    
+private:
+    int lastWidth = 0, lastHeight = 0;
+    UIFont lastFont;
+};
+
+// The TitleScreenLayout struct holds the cached text positions of the title screen.
+struct TitleScreenLayout : ScreenLayout {
+    TextItem title, start, quit, version;
+    
+    // Calculates the layout for the given screen size and font.
+    void update(int screenWidth, int screenHeight, const UIFont& font);
+};
+
+// The PauseScreenLayout struct holds the cached box and text positions of the pause menu.
+struct PauseScreenLayout : ScreenLayout {
+    int boxX = 0, boxY = 0; // The top left corner of the pause box.
+    TextItem title, resume, toTitle, quit;
+    
+    // Calculates the layout for the given screen size and font.
+    void update(int screenWidth, int screenHeight, const UIFont& font);
+};
+
+// The GlyphAdvanceCache struct holds the advance of every ASCII glyph of the default font at one
+// font size, so text can be measured without MeasureText (which needs a terminated string).
+// Measurements match MeasureText.
+struct GlyphAdvanceCache {
+    int fontSize = 0;                  // The font size the table was built for (0 if not built).
+    float scale = 1.0f;                // The scale from the font's base size to fontSize.
+    float spacing = 0.0f;              // The spacing added between glyphs.
+    std::array<float, 128> advance{};  // The unscaled advance of each ASCII glyph.
+    
+    // Rebuilds the table if the font size changed. Needs a window.
+    void update(int size);
+    // Returns the width of the first length characters of text.
+    int measure(const char* text, size_t length) const;
+};
+
 // The ConsoleInput struct holds the state of the console input box.
 struct ConsoleInput {
     std::string text; // The text currently in the input box.
@@ -37,9 +119,13 @@ struct ConsoleInput {
     bool active = false; // Whether the input box is active.
 };
 
-// Renders the developer console.
+// Renders the developer console. The panel is drawn into a render texture that is only redrawn
+// when the console output, the input box or the layout changes.
 void DrawConsole(bool showFPS, int consoleWidth, int consoleHeight, int consoleFontSize, const ConsoleInput& consoleInput);
 
+// Releases the render textures used by the UI. Call before closing the window.
+void UnloadUIResources();
+
 // Renders the console input box.
 void DrawConsoleInputBox(const ConsoleLayout& layout, const ConsoleInput& consoleInput);
 
@@ -49,4 +135,7 @@ void DrawTitleScreen(int screenWidth, int screenHeight);
 // Renders the pause screen.
 void DrawPauseScreen(int screenWidth, int screenHeight);
 
+// Renders the profiler overlay: per-zone p50/p99 times and a frame time graph.
+void DrawProfilerOverlay(int screenWidth);
+
 #endif // UI_RENDERER_H
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "UdpTransport.h"
+#include "ConsoleCapture.h"
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    using NativeSocket = SOCKET;
+    void closeNative(NativeSocket handle) { closesocket(handle); }
+#else
+    using NativeSocket = int;
+    void closeNative(NativeSocket handle) { ::close(handle); }
+#endif
+
+    // Logs a transport error to both stderr and the in-game console.
+    void logNetError(const std::string& message) {
+        std::cerr << message << '\n';
+        consoleCapture.addLine(message);
+    }
+
+    // Returns the loopback address with the given port.
+    sockaddr_in loopbackAddress(uint16_t port) {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return address;
+    }
+}
+
+// UdpTransport implementation
+UdpTransport::~UdpTransport() {
+    close();
+}
+
+bool UdpTransport::open(uint16_t localPort, uint16_t peerPort, const NetConditions& netConditions, uint32_t randomSeed) {
+    close();
+#ifdef _WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        logNetError("NET: Winsock could not be started");
+        return false;
+    }
+#endif
+    const NativeSocket handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#ifdef _WIN32
+    if (handle == INVALID_SOCKET) {
+        WSACleanup();
+#else
+    if (handle < 0) {
+#endif
+        logNetError("NET: Failed to create a UDP socket");
+        return false;
+    }
+
+    const sockaddr_in local = loopbackAddress(localPort);
+    bool ready = bind(handle, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) == 0;
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ready = ready && ioctlsocket(handle, FIONBIO, &nonBlocking) == 0;
+#else
+    ready = ready && fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+    if (!ready) {
+        logNetError("NET: Failed to bind UDP port " + std::to_string(localPort));
+        closeNative(handle);
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return false;
+    }
+
+    socketHandle = static_cast<intptr_t>(handle);
+    remotePort = peerPort;
+    conditions = netConditions;
+    seed = randomSeed;
+    sent = dropped = received = 0;
+    return true;
+}
+
+void UdpTransport::close() {
+    if (!isOpen()) return;
+    closeNative(static_cast<NativeSocket>(socketHandle));
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    socketHandle = INVALID_HANDLE;
+    delayed.clear();
+}
+
+float UdpTransport::nextRandom() {
+    seed = seed * 1664525u + 1013904223u;
+    return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+}
+
+// Loss and delay are both drawn when the packet is queued, in send order, so they stay
+// reproducible for a given seed.
+void UdpTransport::send(const uint8_t* data, size_t size) {
+    if (!isOpen() || size > NET_MAX_PACKET) return;
+    if (nextRandom() * 100.0f < conditions.lossPercent) {
+        ++dropped;
+        return;
+    }
+    if (conditions.latencyMs <= 0 && conditions.jitterMs <= 0) {
+        sendNow(data, size);
+        return;
+    }
+
+    const int delayMs = conditions.latencyMs + static_cast<int>(nextRandom() * static_cast<float>(conditions.jitterMs + 1));
+    Delayed packet;
+    packet.due = Clock::now() + std::chrono::milliseconds(delayMs);
+    packet.size = static_cast<uint16_t>(size);
+    std::memcpy(packet.data.data(), data, size);
+    delayed.push_back(packet);
+}
+
+void UdpTransport::flush() {
+    const Clock::time_point now = Clock::now();
+    size_t kept = 0;
+    for (size_t i = 0; i < delayed.size(); ++i) {
+        if (delayed[i].due <= now) {
+            sendNow(delayed[i].data.data(), delayed[i].size);
+        } else {
+            delayed[kept++] = delayed[i];
+        }
+    }
+    delayed.resize(kept);
+}
+
+// A peer that is not listening yet makes sends fail; the packet is simply lost, as on a real network.
+void UdpTransport::sendNow(const uint8_t* data, size_t size) {
+    const sockaddr_in remote = loopbackAddress(remotePort);
+    sendto(static_cast<NativeSocket>(socketHandle), reinterpret_cast<const char*>(data), static_cast<int>(size), 0,
+           reinterpret_cast<const sockaddr*>(&remote), sizeof(remote));
+    ++sent;
+}
+
+// Datagrams from any other port are skipped.
+size_t UdpTransport::receive(uint8_t* buffer, size_t capacity) {
+    if (!isOpen()) return 0;
+    for (;;) {
+        sockaddr_in from{};
+        socklen_t fromSize = sizeof(from);
+        const auto size = recvfrom(static_cast<NativeSocket>(socketHandle), reinterpret_cast<char*>(buffer),
+                                   static_cast<int>(capacity), 0, reinterpret_cast<sockaddr*>(&from), &fromSize);
+        if (size <= 0) return 0;
+        if (ntohs(from.sin_port) != remotePort) continue;
+        ++received;
+        return static_cast<size_t>(size);
+    }
+}
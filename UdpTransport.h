@@ -0,0 +1,79 @@
+#ifndef UDP_TRANSPORT_H
+#define UDP_TRANSPORT_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Constants for the UDP transport.
+constexpr size_t NET_MAX_PACKET = 512; // The largest datagram sent or received, in bytes.
+
+// The NetConditions struct describes a worse network than the real one, which the transport
+// imitates on outgoing packets so rollback can be measured over loopback.
+struct NetConditions {
+    float lossPercent = 0.0f; // The chance, in percent, that a packet is dropped.
+    int latencyMs = 0;        // The delay added to every packet, in milliseconds.
+    int jitterMs = 0;         // The most extra delay added at random. Packets may then arrive out of order.
+};
+
+// The UdpTransport class exchanges datagrams with one peer on the local machine. The socket is
+// non-blocking, so sending and receiving never stall a frame. Outgoing packets pass through the
+// simulated conditions first: dropped ones are counted and discarded, delayed ones wait in a
+// queue until flush() finds them due.
+class UdpTransport {
+public:
+    UdpTransport() = default;
+    ~UdpTransport();
+
+    UdpTransport(const UdpTransport&) = delete;
+    UdpTransport& operator=(const UdpTransport&) = delete;
+
+    // Binds the local port on 127.0.0.1 and sends to the remote one. The seed drives the simulated
+    // loss and jitter. Returns false, reporting why, if the socket cannot be set up.
+    bool open(uint16_t localPort, uint16_t remotePort, const NetConditions& conditions, uint32_t seed);
+    // Closes the socket and forgets any delayed packets.
+    void close();
+    // Checks if the socket is open.
+    bool isOpen() const { return socketHandle != INVALID_HANDLE; }
+
+    // Queues a datagram for the peer. Datagrams larger than NET_MAX_PACKET are not sent.
+    void send(const uint8_t* data, size_t size);
+    // Sends the delayed datagrams that are due. Called at least once per tick.
+    void flush();
+    // Reads one datagram from the peer. Returns its size, or 0 if none is waiting.
+    size_t receive(uint8_t* buffer, size_t capacity);
+
+    // Returns the datagrams handed to the socket, dropped by the simulated loss, and received.
+    uint64_t packetsSent() const { return sent; }
+    uint64_t packetsDropped() const { return dropped; }
+    uint64_t packetsReceived() const { return received; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr intptr_t INVALID_HANDLE = -1;
+
+    // The Delayed struct is an outgoing datagram waiting out its simulated latency.
+    struct Delayed {
+        Clock::time_point due;
+        uint16_t size;
+        std::array<uint8_t, NET_MAX_PACKET> data;
+    };
+
+    // Returns a pseudo-random number in [0, 1).
+    float nextRandom();
+    // Hands a datagram to the socket.
+    void sendNow(const uint8_t* data, size_t size);
+
+    intptr_t socketHandle = INVALID_HANDLE;
+    uint16_t remotePort = 0;
+    NetConditions conditions;
+    uint32_t seed = 0;
+    std::vector<Delayed> delayed;  // Datagrams not yet due, in the order they were queued.
+    uint64_t sent = 0;
+    uint64_t dropped = 0;
+    uint64_t received = 0;
+};
+
+#endif // UDP_TRANSPORT_H
@@ -1,79 +1,53 @@
 #include "raylib.h"
 #include "ConsoleCapture.h"
 #include "ConfigParser.h"
+#include "GameConfig.h"
+#include "Game.h"
+#include "Headless.h"
+#include "LaunchOptions.h"
+#include "FixedTimestep.h"
+#include <filesystem>
+#include <iostream>
+#ifndef HEADLESS_BUILD
 #include "TextureLoader.h"
+#include "AssetCache.h"
+#include "ConfigWatcher.h"
 #include "UIRenderer.h"
-#include "Player.h"
-#include "GameConfig.h"
-#include "GameState.h"
 #include "Version.h"
-#include "Commands.h"
+#include "InputReplay.h"
+#include "FrameArena.h"
+#include "Profiler.h"
+#include "SpriteBatch.h"
+#include "SpriteBench.h"
+#include "StateHash.h"
+#include "SaveState.h"
+#include "TimelineArchive.h"
+#endif
 
 namespace {
-    // Initializes the console with welcome messages.
-    void initializeConsole() {
-        consoleCapture.addLine("Game started successfully");
-        consoleCapture.addLine("Config loaded successfully (resources/conf.ini)");
-    }
+    // The config file the game loads at startup.
+    const std::string CONFIG_PATH = "resources/conf.ini";
     
-    // Creates the player object, positioning it in the center of the screen.
-    Player createPlayer(const GameConfig& config, Texture2D texture) {
-        const float startX = static_cast<float>(config.screenWidth) / 2.0f - 
-                            static_cast<float>(texture.width) / 2.0f;
-        const float startY = static_cast<float>(config.screenHeight) / 2.0f - 
-                            static_cast<float>(texture.height) / 2.0f;
-        
-        return Player(startX, startY, config.playerSpeed, 
-                     config.friction, config.maxSpeed, texture);
+    // Returns the log file for this process. Netplay peers usually run in the same directory, so
+    // each one logs to its own file, e.g. timeexe_peer1.log.
+    std::string logPathFor(const GameConfig& config, const LaunchOptions& options) {
+        if (config.logFile.empty() || options.netPlayer < 0) return config.logFile;
+        std::filesystem::path path(config.logFile);
+        path.replace_filename(path.stem().string() + "_peer" + std::to_string(options.netPlayer) +
+                              path.extension().string());
+        return path.string();
     }
     
-    // Updates the game state, handling all input and game logic.
-    void updateGame(Player& player, GameState& gameState, const GameConfig& config, float deltaTime, CommandParser& commandParser, ConsoleInput& consoleInput) {
-        // Handle input based on the current game state.
-        if (gameState.isOnTitleScreen()) {
-            gameState.handleTitleInput();
-        } else {
-            // Toggle console input with ALT+C.
-            if (gameState.consoleVisible && IsKeyDown(KEY_LEFT_ALT) && IsKeyPressed(KEY_C)) {
-                consoleInput.active = !consoleInput.active;
-            }
-
-            // If console input is active, process text input.
-            if (consoleInput.active) {
-                int key = GetCharPressed();
-                if (key >= 32 && key <= 125) {
-                    consoleInput.text.insert(consoleInput.cursorPosition, 1, (char)key);
-                    consoleInput.cursorPosition++;
-                }
-
-                // Handle backspace for deleting characters.
-                if (IsKeyPressed(KEY_BACKSPACE)) {
-                    if (consoleInput.cursorPosition > 0) {
-                        consoleInput.text.erase(consoleInput.cursorPosition - 1, 1);
-                        consoleInput.cursorPosition--;
-                    }
-                }
-
-                // Handle ENTER to execute the command.
-                if (IsKeyPressed(KEY_ENTER)) {
-                    commandParser.parseAndExecute(consoleInput.text, player);
-                    consoleInput.text.clear();
-                    consoleInput.cursorPosition = 0;
-                }
-            } else {
-                // Otherwise, handle normal game input.
-                gameState.handleGameInput(config.consoleEnabled);
-            }
-
-            // Update the player only when the game is in the PLAYING state.
-            if (gameState.isInGame()) {
-                player.update(deltaTime, config.screenWidth, config.screenHeight, consoleInput.active);
-            }
-        }
+    // Initializes the console with welcome messages.
+    void initializeConsole() {
+        consoleCapture.addLine("Game started successfully");
+        consoleCapture.addLine("Config loaded successfully (" + CONFIG_PATH + ")");
     }
     
+#ifndef HEADLESS_BUILD
     // Renders the entire game, including the world, UI, and console.
-    void renderGame(const Player& player, const GameConfig& config, const GameState& gameState, const ConsoleInput& consoleInput) {
+    void renderGame(const Player& player, const GameConfig& config, const GameState& gameState, const FixedTimestep& timestep, const ConsoleInput& consoleInput, SpriteBatch& spriteBatch) {
+        PROFILE_ZONE("Render");
         BeginDrawing();
         
         if (gameState.isOnTitleScreen()) {
@@ -83,14 +57,26 @@ namespace {
             // Render the main game world.
             ClearBackground(GRAY);
             
-            // Draw the player.
-            player.draw();
+            // Draw the player, interpolated between the last two simulation ticks.
+            spriteBatch.begin();
+            player.draw(spriteBatch, timestep.interpolationAlpha());
+            spriteBatch.end();
+            
+            // Show that time is running backwards.
+            if (gameState.rewinding) {
+                DrawText("<< REWIND", config.screenWidth - MeasureText("<< REWIND", 20) - 10, 10, 20, WHITE);
+            }
             
             // Draw the FPS counter if enabled.
             if (config.showFPS) {
                 DrawFPS(10, 10);
             }
             
+            // Draw the profiler overlay if it's enabled.
+            if (profiler.overlayVisible) {
+                DrawProfilerOverlay(config.screenWidth);
+            }
+            
             // Draw the console if it's enabled and visible.
             if (config.consoleEnabled && gameState.consoleVisible) {
                 DrawConsole(config.showFPS, config.consoleWidth, 
@@ -103,46 +89,245 @@ namespace {
             }
         }
         
+        // Presenting may block on vsync, so it gets its own zone.
+        PROFILE_ZONE("EndDrawing");
         EndDrawing();
     }
+    
+    // Applies an edited config file between frames. Each changed field runs its console
+    // variable's callbacks, the same as setting it from the console would.
+    // While recording or replaying, the settings the recording depends on are held.
+    void applyConfigReload(const ConfigReload& reload, GameConfig& config, const CVarRegistry& cvars, bool holdSimulation) {
+        GameConfig after = reload.after;
+        const ReplayHeader held = ReplayHeader::fromConfig(reload.before, 0, 0);
+        if (holdSimulation && ReplayHeader::fromConfig(after, 0, 0) != held) {
+            held.applyTo(after);
+            consoleCapture.addLine("CONFIG: Simulation settings are held while recording or replaying");
+        }
+        const int changed = config.applyChanges(reload.before, after, &cvars);
+        consoleCapture.addLine("CONFIG: Reloaded " + CONFIG_PATH + " (" + std::to_string(changed) + " changed)");
+    }
+    
+    // Adds the callbacks for the settings that only the windowed game applies. Timestep changes
+    // are only flagged here, since the console runs partway through a frame's ticks.
+    void bindWindowCVars(CVarRegistry& cvars, const GameConfig& config, bool& timestepChanged) {
+        const auto resizeWindow = [&config](const CVar&) { SetWindowSize(config.screenWidth, config.screenHeight); };
+        cvars.onChange("window_width", resizeWindow);
+        cvars.onChange("window_height", resizeWindow);
+        cvars.onChange("target_fps", [&config](const CVar&) { SetTargetFPS(config.targetFPS); });
+        
+        const auto resetTimestep = [&timestepChanged](const CVar&) { timestepChanged = true; };
+        cvars.onChange("tick_rate", resetTimestep);
+        cvars.onChange("max_frame_time", resetTimestep);
+        cvars.onChange("max_ticks_per_frame", resetTimestep);
+    }
+#endif // HEADLESS_BUILD
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     // Load the game configuration from the INI file.
-    const auto configData = parseINI("resources/conf.ini");
+    ConfigFile configFile;
     GameConfig config;
-    config.loadFromConfig(configData);
+    if (configFile.open(CONFIG_PATH)) {
+        config.loadFromConfig(configFile);
+    }
+    
+    LaunchOptions options;
+    if (!parseLaunchOptions(argc, argv, options)) {
+        return 2;
+    }
+    if (options.help) {
+        std::cout << launchOptionsUsage();
+        return 0;
+    }
     
     // Set the maximum number of characters per line for the console.
     consoleCapture.setMaxDisplayChars(config.calculateMaxDisplayChars());
+    const std::string logPath = logPathFor(config, options);
+    if (!logPath.empty() &&
+        !consoleCapture.startFileSink(logPath, static_cast<size_t>(config.logMaxKB) * 1024, config.logFiles)) {
+        consoleCapture.addLine("LOG: Could not open " + logPath);
+    }
+    initializeConsole();
+    
+    // Run without a window when requested, or always in the headless build.
+#ifdef HEADLESS_BUILD
+    return RunHeadless(config, options);
+#else
+    // Comparing state hashes needs no window either.
+    if (options.headless || !options.compareHashPaths[0].empty()) {
+        return RunHeadless(config, options);
+    }
+    if (options.sprites > 0) {
+        return RunSpriteBench(config, options);
+    }
+    
+    // Edits to the config file apply live. Reloads are compared with the file as loaded here,
+    // so only the settings an edit touches override the ones set below.
+    ConfigWatcher configWatcher;
+    if (config.watchConfig) {
+        configWatcher.start(CONFIG_PATH, config);
+    }
+    
+    // A replay brings the settings it was recorded with.
+    InputReplay replay;
+    if (!options.replayPath.empty() && replay.open(options.replayPath)) {
+        replay.getHeader().applyTo(config);
+    }
     
     // Initialize the game window and set the target FPS.
     InitWindow(config.screenWidth, config.screenHeight, WINDOW_TITLE);
     SetExitKey(KEY_NULL); // Disable the default ESC key for exiting.
-    SetTargetFPS(60);
+    SetTargetFPS(config.targetFPS);
+    profiler.overlayVisible = config.showProfiler;
     
-    // Initialize game components.
-    initializeConsole();
+    // Decode the player sprite in the background, keeping the window responsive on the title screen.
+    // The player's start position and screen bounds depend on the sprite size, so the game waits for it.
+    AssetCache assets;
+    const TextureHandle playerSprite = assets.loadTexture(config.spritePath);
+    do {
+        assets.update();
+        BeginDrawing();
+        DrawTitleScreen(config.screenWidth, config.screenHeight);
+        EndDrawing();
+    } while (!assets.isSettled(playerSprite) && !WindowShouldClose());
     
-    const Texture2D playerTexture = LoadPlayerTexture(config.spritePath);
-    Player player = createPlayer(config, playerTexture);
+    // Initialize game components.
+    const Texture2D playerTexture = assets.texture(playerSprite);
+    SpriteBatch spriteBatch;
+    spriteBatch.atlas().add(playerTexture);
+    EntityStore entities;
+    Player player = createPlayer(entities, config, playerTexture);
     GameState gameState;  // The game starts on the title screen by default.
     CommandParser commandParser;
     ConsoleInput consoleInput;
+    RewindBuffer rewindBuffer(static_cast<size_t>(config.rewindMemoryKB) * 1024, config.rewindKeyframeInterval);
+    FixedTimestep timestep(config.tickRate, config.maxFrameTime, config.maxTicksPerFrame);
+    bindGameCVars(commandParser.cvars(), config, player);
+    bool timestepChanged = false;
+    bindWindowCVars(commandParser.cvars(), config, timestepChanged);
+    if (!options.execPath.empty()) {
+        commandParser.execScript(options.execPath);
+    }
+    
+    if (replay.isActive() && (replay.getHeader().playerWidth != playerTexture.width ||
+                              replay.getHeader().playerHeight != playerTexture.height)) {
+        consoleCapture.addLine("REPLAY: Sprite size differs from the recording");
+    }
+    // State hashes of a recorded session can be compared with a headless replay of it.
+    StateHashWriter stateHashes;
+    if (!options.hashPath.empty()) {
+        stateHashes.open(options.hashPath);
+    }
+    
+    // Resume a saved game, or start a new one if it cannot be loaded.
+    uint64_t simulatedTicks = 0;
+    const bool resumed = !options.loadPath.empty() &&
+                         loadSave(options.loadPath, entities, gameState, consoleInput, rewindBuffer, simulatedTicks);
+    // A replay continues from the loaded tick, and a recording starts there.
+    if (replay.isActive()) {
+        replay.skipTo(simulatedTicks);
+    }
+    InputRecorder recorder;
+    if (!options.recordPath.empty()) {
+        ReplayHeader header = ReplayHeader::fromConfig(config, playerTexture.width, playerTexture.height);
+        header.startTick = simulatedTicks;
+        recorder.open(options.recordPath, header);
+    }
+    AutoSaver autosaver;
+    float sinceAutosave = 0.0f;
+    // Archive every tick of the session, so the console can scrub back to any time in it. A resumed
+    // session carries on the archive it was saved from, rather than erasing it.
+    TimelineWriter timeline;
+    if (!config.archivePath.empty()) {
+        if (resumed) {
+            timeline.resume(config.archivePath, entities, simulatedTicks, config.tickRate);
+        } else {
+            timeline.open(config.archivePath, entities, simulatedTicks, config.tickRate);
+        }
+    }
+    commandParser.bindTimeline(timeline, rewindBuffer);
+    
+    // Input polled each frame is held here until a tick consumes it.
+    InputSnapshot pendingInput;
+    TypedCharQueue typedChars;
+    // Kept across frames, since its configs hold strings on the heap.
+    ConfigReload configReload;
     
     // The main game loop.
     while (!WindowShouldClose() && !gameState.shouldQuit) {
-        const float deltaTime = GetFrameTime();
+        profiler.beginFrame();
+        const float frameTime = GetFrameTime();
+        {
+            PROFILE_ZONE("PollInput");
+            pendingInput.merge(PollInput(typedChars));
+        }
+        assets.update();
+        const bool holdSimulation = replay.isActive() || recorder.isOpen();
+        commandParser.cvars().holdSimulation(holdSimulation);
+        if (configWatcher.poll(configReload)) {
+            applyConfigReload(configReload, config, commandParser.cvars(), holdSimulation);
+        }
+        // Apply timestep settings changed since the last frame, before this frame's ticks.
+        if (timestepChanged) {
+            timestep = FixedTimestep(config.tickRate, config.maxFrameTime, config.maxTicksPerFrame);
+            timestepChanged = false;
+        }
         
-        // Update all game logic.
-        updateGame(player, gameState, config, deltaTime, commandParser, consoleInput);
+        // Update all game logic in whole fixed ticks.
+        const int ticks = timestep.advance(frameTime);
+        for (int i = 0; i < ticks; ++i) {
+            PROFILE_ZONE("Tick");
+            InputSnapshot tickInput = pendingInput;
+            tickInput.typedChar = typedChars.pop();
+            if (replay.isActive() && !replay.next(tickInput)) {
+                consoleCapture.addLine("REPLAY: Finished, switching to live input");
+                tickInput = pendingInput;
+            }
+            recorder.record(tickInput);
+            updateGame(player, gameState, config, tickInput, timestep.tickDelta, commandParser, consoleInput, rewindBuffer);
+            if (stateHashes.isOpen()) {
+                stateHashes.record(hashSimulationState(entities, gameState, consoleInput, rewindBuffer));
+            }
+            pendingInput.clearEvents();
+            ++simulatedTicks;
+            timeline.record(entities);
+        }
+        
+        // Autosave between ticks while a game is in progress. Only the capture runs on this
+        // thread; a save that finds the last one still being written is retried next frame.
+        sinceAutosave += frameTime;
+        if (config.autosaveSeconds > 0 && sinceAutosave >= static_cast<float>(config.autosaveSeconds) &&
+            gameState.currentState != GameStateType::TITLE_SCREEN) {
+            PROFILE_ZONE("Autosave");
+            if (autosaver.save(config.autosavePath, entities, gameState, consoleInput, rewindBuffer, simulatedTicks,
+                               config.tickRate)) {
+                sinceAutosave = 0.0f;
+            }
+        }
         
         // Render everything to the screen.
-        renderGame(player, config, gameState, consoleInput);
+        renderGame(player, config, gameState, timestep, consoleInput, spriteBatch);
+        profiler.endFrame();
+        // Free the frame's scratch memory in one step.
+        frameArena.reset();
     }
     
     // Clean up resources before exiting.
-    UnloadTexture(playerTexture);
+    configWatcher.stop();
+    recorder.close();
+    stateHashes.close();
+    timeline.close();
+    if (config.autosaveSeconds > 0 && gameState.currentState != GameStateType::TITLE_SCREEN) {
+        autosaver.wait();
+        autosaver.save(config.autosavePath, entities, gameState, consoleInput, rewindBuffer, simulatedTicks,
+                       config.tickRate);
+    }
+    autosaver.stop();
+    UnloadUIResources();
+    spriteBatch.atlas().unload();
+    assets.unloadAll();
     CloseWindow();
     return 0;
-}
\ No newline at end of file
+#endif // HEADLESS_BUILD
+}